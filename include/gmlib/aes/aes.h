@@ -13,7 +13,7 @@ namespace alg = internal::aesni;
 namespace alg = internal::lut;
 #endif
 
-class AES128 : public block_cipher_mode::BlockCipherImpl
+class AES128 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME              = "AES128";
@@ -105,7 +105,7 @@ public:
     }
 };
 
-class AES192 : public block_cipher_mode::BlockCipherImpl
+class AES192 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME              = "AES192";
@@ -197,7 +197,7 @@ public:
     }
 };
 
-class AES256 : public block_cipher_mode::BlockCipherImpl
+class AES256 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME              = "AES256";
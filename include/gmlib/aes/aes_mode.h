@@ -7,6 +7,7 @@
 #include <gmlib/block_cipher_mode/ctr_mode.h>
 #include <gmlib/block_cipher_mode/ecb_mode.h>
 #include <gmlib/block_cipher_mode/gcm_mode.h>
+#include <gmlib/block_cipher_mode/ocb_mode.h>
 #include <gmlib/block_cipher_mode/ofb_mode.h>
 
 namespace aes {
@@ -53,6 +54,13 @@ using AES128GcmDecryptor = block_cipher_mode::GcmDecryptor<AES128>;
 using AES192GcmDecryptor = block_cipher_mode::GcmDecryptor<AES192>;
 using AES256GcmDecryptor = block_cipher_mode::GcmDecryptor<AES256>;
 
+using AES128OcbEncryptor = block_cipher_mode::OcbEncryptor<AES128>;
+using AES192OcbEncryptor = block_cipher_mode::OcbEncryptor<AES192>;
+using AES256OcbEncryptor = block_cipher_mode::OcbEncryptor<AES256>;
+using AES128OcbDecryptor = block_cipher_mode::OcbDecryptor<AES128>;
+using AES192OcbDecryptor = block_cipher_mode::OcbDecryptor<AES192>;
+using AES256OcbDecryptor = block_cipher_mode::OcbDecryptor<AES256>;
+
 } // namespace aes
 
 #endif
\ No newline at end of file
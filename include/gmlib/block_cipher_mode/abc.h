@@ -4,7 +4,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <map>
+#include <initializer_list>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 
@@ -18,8 +19,125 @@ enum ParamKey : std::size_t
     TAG      = 0b1000,
 };
 
-using ConstParameter = std::map<ParamKey, std::pair<const void*, std::size_t>>;
-using Parameter      = std::map<ParamKey, std::pair<void*, std::size_t>>;
+/**
+ * @brief   mode parameters, a flat array with one slot per ParamKey
+ * @details keeps the std::map interface used by init/set/get (find, end,
+ *          operator[], brace initialization) without heap allocation
+ */
+template <typename Ptr>
+class BasicParameter
+{
+public:
+    using mapped_type    = std::pair<Ptr, std::size_t>;
+    using value_type     = std::pair<ParamKey, mapped_type>;
+    using iterator       = value_type*;
+    using const_iterator = const value_type*;
+
+    static constexpr std::size_t MAX_SIZE = 4;
+
+private:
+    value_type  items_[MAX_SIZE];
+    std::size_t size_ = 0;
+
+public:
+    BasicParameter() = default;
+
+    BasicParameter(std::initializer_list<value_type> items)
+    {
+        for (const value_type& item : items)
+        {
+            this->insert(item);
+        }
+    }
+
+public:
+    iterator begin() noexcept
+    {
+        return items_;
+    }
+
+    iterator end() noexcept
+    {
+        return items_ + size_;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return items_;
+    }
+
+    const_iterator end() const noexcept
+    {
+        return items_ + size_;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    void clear() noexcept
+    {
+        size_ = 0;
+    }
+
+    iterator find(ParamKey key) noexcept
+    {
+        iterator it = items_;
+        while (it != this->end() && it->first != key)
+        {
+            it++;
+        }
+        return it;
+    }
+
+    const_iterator find(ParamKey key) const noexcept
+    {
+        const_iterator it = items_;
+        while (it != this->end() && it->first != key)
+        {
+            it++;
+        }
+        return it;
+    }
+
+    std::size_t count(ParamKey key) const noexcept
+    {
+        return (this->find(key) != this->end()) ? 1 : 0;
+    }
+
+    /**
+     * @brief   insert item, an existing key is kept unchanged (as std::map)
+     */
+    std::pair<iterator, bool> insert(const value_type& item)
+    {
+        iterator it = this->find(item.first);
+        if (it != this->end())
+        {
+            return {it, false};
+        }
+        if (size_ == MAX_SIZE)
+        {
+            throw std::runtime_error("too many mode parameters");
+        }
+        items_[size_] = item;
+        return {items_ + size_++, true};
+    }
+
+    mapped_type& operator[](ParamKey key)
+    {
+        return this->insert(value_type(key, mapped_type(nullptr, 0)))
+            .first->second;
+    }
+};
+
+using ConstParameter = BasicParameter<const void*>;
+using Parameter      = BasicParameter<void*>;
 
 namespace abc {
 
@@ -63,6 +181,14 @@ public:
                                 std::size_t         block_num) const = 0;
 };
 
+/**
+ * @brief   block cipher mode interface
+ * @note    all modes work in place: update / do_final accept out == in, so
+ *          a buffer can be encrypted or decrypted without a second copy.
+ *          Partially overlapping out and in are not supported. A cipher
+ *          used by a mode must accept out == in in encrypt_blocks /
+ *          decrypt_blocks.
+ */
 class BlockCipherMode
 {
 public:
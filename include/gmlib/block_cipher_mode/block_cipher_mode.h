@@ -2,13 +2,25 @@
 #define BLOCK_CIPHER_MODE_BLOCK_CIPHER_MODE_H
 
 #include <gmlib/block_cipher_mode/abc.h>
+#include <gmlib/block_cipher_mode/internal/pkcs7.h>
+#include <gmlib/memory_utils/iovec.h>
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
 
 namespace block_cipher_mode {
 
-template <std::size_t _BLOCK_SIZE>
+/**
+ * @brief   common buffering of block cipher modes
+ * @details with Derived = void, update_blocks / final_block are reached
+ *          through the vtable. A mode passing itself as Derived (CRTP) gets
+ *          direct, inlinable calls instead; the abc::BlockCipherMode
+ *          interface is still there for type-erased use.
+ */
+template <std::size_t _BLOCK_SIZE, class Derived = void>
 class BlockCipherModeImpl : public abc::BlockCipherMode
 {
 public:
@@ -29,15 +41,29 @@ public:
 public:
     inline const abc::BlockCipher& fetch_cipher_ctx() const noexcept override;
 
+protected:
+    /**
+     * @brief   padding applied by the buffering layer
+     */
+    enum class Padding
+    {
+        NONE,        // final_block gets the remaining bytes as they are
+        PKCS7_PAD,   // pad the last block before final_block
+        PKCS7_UNPAD, // keep back the last block, strip the padding of it
+    };
+
 private:
     std::uint8_t buf_[BLOCK_SIZE];
     std::size_t  buf_size_;
+    Padding      padding_;
 
 protected:
     inline BlockCipherModeImpl() noexcept;
 
     inline void reset() noexcept;
 
+    inline void set_padding(Padding padding) noexcept;
+
 public:
     inline std::size_t init(const ConstParameter& params) override;
 
@@ -55,6 +81,20 @@ public:
                          const std::uint8_t* in  = nullptr,
                          std::size_t         inl = 0) override;
 
+    /**
+     * @brief               update with a scatter/gather input, fragments
+     *                      are processed in place and only a block split
+     *                      across fragments goes through the buffer
+     * @param[out]  out     contiguous output
+     * @param[out]  outl    output length (in bytes)
+     * @param[in]   in      input fragments
+     * @param[in]   in_num  fragment number
+     */
+    inline void update_v(std::uint8_t*              out,
+                         std::size_t*               outl,
+                         const memory_utils::IoVec* in,
+                         std::size_t                in_num);
+
 private:
     inline virtual void update_blocks(std::uint8_t*       out,
                                       const std::uint8_t* in,
@@ -63,6 +103,20 @@ private:
     inline virtual void final_block(std::uint8_t*       out,
                                     const std::uint8_t* in,
                                     std::size_t         inl) = 0;
+
+private:
+    inline void dispatch_update(std::uint8_t*       out,
+                                std::size_t*        outl,
+                                const std::uint8_t* in,
+                                std::size_t         inl);
+
+    inline void dispatch_update_blocks(std::uint8_t*       out,
+                                       const std::uint8_t* in,
+                                       std::size_t         block_num);
+
+    inline void dispatch_final_block(std::uint8_t*       out,
+                                     const std::uint8_t* in,
+                                     std::size_t         inl);
 };
 
 // ================================
@@ -73,32 +127,37 @@ private:
                 __FILE__, __FUNCTION__, __LINE__);                      \
     std::exit(exit_code)
 
-template <std::size_t BLOCK_SIZE>
-const char* BlockCipherModeImpl<BLOCK_SIZE>::fetch_name() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+const char* BlockCipherModeImpl<BLOCK_SIZE, Derived>::fetch_name()
+    const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t BlockCipherModeImpl<BLOCK_SIZE>::fetch_name_str_len() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t BlockCipherModeImpl<BLOCK_SIZE, Derived>::fetch_name_str_len()
+    const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t BlockCipherModeImpl<BLOCK_SIZE>::fetch_block_size() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t BlockCipherModeImpl<BLOCK_SIZE, Derived>::fetch_block_size()
+    const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t BlockCipherModeImpl<BLOCK_SIZE>::fetch_user_key_len() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t BlockCipherModeImpl<BLOCK_SIZE, Derived>::fetch_user_key_len()
+    const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-const abc::BlockCipher& BlockCipherModeImpl<BLOCK_SIZE>::fetch_cipher_ctx()
+template <std::size_t BLOCK_SIZE, class Derived>
+const abc::BlockCipher& BlockCipherModeImpl<BLOCK_SIZE,
+                                            Derived>::fetch_cipher_ctx()
     const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
@@ -108,52 +167,65 @@ const abc::BlockCipher& BlockCipherModeImpl<BLOCK_SIZE>::fetch_cipher_ctx()
 
 // ==========================
 
-template <std::size_t BLOCK_SIZE>
-BlockCipherModeImpl<BLOCK_SIZE>::BlockCipherModeImpl() noexcept : buf_size_(0)
+template <std::size_t BLOCK_SIZE, class Derived>
+BlockCipherModeImpl<BLOCK_SIZE, Derived>::BlockCipherModeImpl() noexcept
+    : buf_size_(0), padding_(Padding::NONE)
 {
 }
 
-template <std::size_t BLOCK_SIZE>
-void BlockCipherModeImpl<BLOCK_SIZE>::reset() noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::reset() noexcept
 {
     buf_size_ = 0;
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t BlockCipherModeImpl<BLOCK_SIZE>::init(const ConstParameter& params)
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::set_padding(
+    Padding padding) noexcept
+{
+    padding_ = padding;
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t BlockCipherModeImpl<BLOCK_SIZE, Derived>::init(
+    const ConstParameter& params)
 {
     return 0;
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t BlockCipherModeImpl<BLOCK_SIZE>::set(const ConstParameter& params)
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t BlockCipherModeImpl<BLOCK_SIZE, Derived>::set(
+    const ConstParameter& params)
 {
     return 0;
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t BlockCipherModeImpl<BLOCK_SIZE>::get(const Parameter& params)
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t BlockCipherModeImpl<BLOCK_SIZE, Derived>::get(
+    const Parameter& params)
 {
     return 0;
 }
 
-template <std::size_t BLOCK_SIZE>
-void BlockCipherModeImpl<BLOCK_SIZE>::update(std::uint8_t*       out,
-                                             std::size_t*        outl,
-                                             const std::uint8_t* in,
-                                             std::size_t         inl)
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::update(std::uint8_t*       out,
+                                                      std::size_t*        outl,
+                                                      const std::uint8_t* in,
+                                                      std::size_t         inl)
 {
     if (inl == 0)
     {
         *outl = 0;
         return;
     }
+    // when unpadding, the last full block stays in the buffer for do_final
+    const bool    keep     = (padding_ == Padding::PKCS7_UNPAD);
     std::uint8_t* out_base = out;
     if (buf_size_ == 0)
     {
-        std::size_t block_num = inl / BLOCK_SIZE;
+        std::size_t block_num = (inl - keep) / BLOCK_SIZE;
         std::size_t size      = block_num * BLOCK_SIZE;
-        this->update_blocks(out, in, block_num);
+        this->dispatch_update_blocks(out, in, block_num);
         out += size, in += size, inl -= size;
 
         std::memcpy(buf_, in, inl);
@@ -170,34 +242,127 @@ void BlockCipherModeImpl<BLOCK_SIZE>::update(std::uint8_t*       out,
         std::memcpy(buf_ + buf_size_, in, size);
         buf_size_ += size, in += size, inl -= size;
 
-        if (buf_size_ == BLOCK_SIZE)
+        if (buf_size_ == BLOCK_SIZE && !(keep && inl == 0))
         {
-            this->update_blocks(out, buf_, 1);
+            this->dispatch_update_blocks(out, buf_, 1);
             buf_size_ = 0, out += BLOCK_SIZE;
         }
     }
     if (buf_size_ == 0)
     {
-        std::size_t block_num = inl / BLOCK_SIZE;
+        std::size_t block_num = (inl - keep) / BLOCK_SIZE;
         std::size_t size      = block_num * BLOCK_SIZE;
-        this->update_blocks(out, in, block_num);
+        this->dispatch_update_blocks(out, in, block_num);
         out += size, in += size, inl -= size;
 
         std::memcpy(buf_, in, inl);
-        buf_size_ = inl, *outl = (std::size_t)(out - out_base);
+        buf_size_ = inl;
     }
+    *outl = (std::size_t)(out - out_base);
 }
 
-template <std::size_t BLOCK_SIZE>
-void BlockCipherModeImpl<BLOCK_SIZE>::do_final(std::uint8_t*       out,
-                                               std::size_t*        outl,
-                                               const std::uint8_t* in,
-                                               std::size_t         inl)
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::do_final(
+    std::uint8_t*       out,
+    std::size_t*        outl,
+    const std::uint8_t* in,
+    std::size_t         inl)
 {
-    this->update(out, outl, in, inl);
+    this->dispatch_update(out, outl, in, inl);
     out += *outl;
-    this->final_block(out, buf_, buf_size_);
+    if (padding_ == Padding::PKCS7_PAD)
+    {
+        internal::pkcs7_pad<BLOCK_SIZE>(buf_, buf_size_);
+        buf_size_ = BLOCK_SIZE;
+    }
+    if (padding_ == Padding::PKCS7_UNPAD && buf_size_ != BLOCK_SIZE)
+    {
+        buf_size_ = 0;
+        throw std::runtime_error("pkcs7 decryption failed");
+    }
+    this->dispatch_final_block(out, buf_, buf_size_);
     *outl += buf_size_;
+    buf_size_ = 0;
+    if (padding_ == Padding::PKCS7_UNPAD)
+    {
+        // one error for every failure, and no plaintext of a bad block
+        std::size_t pad;
+        if (!internal::pkcs7_check<BLOCK_SIZE>(out, &pad))
+        {
+            std::memset(out, 0, BLOCK_SIZE);
+            throw std::runtime_error("pkcs7 decryption failed");
+        }
+        *outl -= pad;
+    }
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::update_v(
+    std::uint8_t*              out,
+    std::size_t*               outl,
+    const memory_utils::IoVec* in,
+    std::size_t                in_num)
+{
+    std::uint8_t* out_base = out;
+    for (std::size_t i = 0; i < in_num; i++)
+    {
+        std::size_t size;
+        this->dispatch_update(out, &size,
+                              static_cast<const std::uint8_t*>(in[i].iov_base),
+                              in[i].iov_len);
+        out += size;
+    }
+    *outl = (std::size_t)(out - out_base);
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::dispatch_update(
+    std::uint8_t*       out,
+    std::size_t*        outl,
+    const std::uint8_t* in,
+    std::size_t         inl)
+{
+    if constexpr (std::is_void<Derived>::value)
+    {
+        this->update(out, outl, in, inl);
+    }
+    else
+    {
+        static_cast<Derived*>(this)->Derived::update(out, outl, in, inl);
+    }
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::dispatch_update_blocks(
+    std::uint8_t*       out,
+    const std::uint8_t* in,
+    std::size_t         block_num)
+{
+    if constexpr (std::is_void<Derived>::value)
+    {
+        this->update_blocks(out, in, block_num);
+    }
+    else
+    {
+        static_cast<Derived*>(this)->Derived::update_blocks(out, in,
+                                                            block_num);
+    }
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void BlockCipherModeImpl<BLOCK_SIZE, Derived>::dispatch_final_block(
+    std::uint8_t*       out,
+    const std::uint8_t* in,
+    std::size_t         inl)
+{
+    if constexpr (std::is_void<Derived>::value)
+    {
+        this->final_block(out, in, inl);
+    }
+    else
+    {
+        static_cast<Derived*>(this)->Derived::final_block(out, in, inl);
+    }
 }
 
 } // namespace block_cipher_mode
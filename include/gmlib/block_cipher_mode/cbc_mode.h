@@ -2,6 +2,7 @@
 #define BLOCK_CIPHER_MODE_CBC_MODE_H
 
 #include <gmlib/block_cipher_mode/block_cipher_mode.h>
+#include <gmlib/block_cipher_mode/internal/multi_buffer.h>
 #include <gmlib/memory_utils/memxor.h>
 
 #include <stdexcept>
@@ -9,11 +10,14 @@
 namespace block_cipher_mode {
 
 template <class Cipher>
-class CbcEncryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class CbcEncryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcEncryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcEncryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/CBC-ENC";
 
@@ -92,9 +96,20 @@ private:
 public:
     CbcEncryptor() = default;
 
-    CbcEncryptor(const std::uint8_t* user_key, const std::uint8_t* iv)
+    CbcEncryptor(const std::uint8_t* user_key,
+                 const std::uint8_t* iv,
+                 bool                pkcs7 = false)
     {
         this->init(user_key, iv);
+        this->set_pkcs7(pkcs7);
+    }
+
+    CbcEncryptor(const Cipher&       cipher,
+                 const std::uint8_t* iv,
+                 bool                pkcs7 = false)
+    {
+        this->init(cipher, iv);
+        this->set_pkcs7(pkcs7);
     }
 
 public:
@@ -104,12 +119,33 @@ public:
         std::memcpy(iv_, iv, BLOCK_SIZE);
     }
 
+    /**
+     * @brief               use a ready key schedule (e.g. KeyScheduleCache)
+     * @param[in]   cipher  Cipher::ENCRYPTION key schedule
+     * @param[in]   iv      BLOCK_SIZE bytes iv
+     */
+    void init(const Cipher& cipher, const std::uint8_t* iv) noexcept
+    {
+        cipher_ = cipher;
+        std::memcpy(iv_, iv, BLOCK_SIZE);
+    }
+
     void reset(const std::uint8_t* iv) noexcept
     {
-        this->BlockCipherModeImpl<BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcEncryptor>::reset();
         std::memcpy(iv_, iv, BLOCK_SIZE);
     }
 
+    /**
+     * @brief           enable PKCS7 padding, do_final pads the last block
+     */
+    void set_pkcs7(bool enable) noexcept
+    {
+        using Base = BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcEncryptor>;
+        this->Base::set_padding(enable ? Base::Padding::PKCS7_PAD
+                                       : Base::Padding::NONE);
+    }
+
 private:
     void update_blocks(std::uint8_t*       out,
                        const std::uint8_t* in,
@@ -145,11 +181,14 @@ private:
 };
 
 template <class Cipher>
-class CbcDecryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class CbcDecryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcDecryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcDecryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/CBC-DEC";
 
@@ -228,9 +267,20 @@ private:
 public:
     CbcDecryptor() = default;
 
-    CbcDecryptor(const std::uint8_t* user_key, const std::uint8_t* iv)
+    CbcDecryptor(const std::uint8_t* user_key,
+                 const std::uint8_t* iv,
+                 bool                pkcs7 = false)
     {
         this->init(user_key, iv);
+        this->set_pkcs7(pkcs7);
+    }
+
+    CbcDecryptor(const Cipher&       cipher,
+                 const std::uint8_t* iv,
+                 bool                pkcs7 = false)
+    {
+        this->init(cipher, iv);
+        this->set_pkcs7(pkcs7);
     }
 
 public:
@@ -240,12 +290,33 @@ public:
         std::memcpy(iv_, iv, BLOCK_SIZE);
     }
 
+    /**
+     * @brief               use a ready key schedule (e.g. KeyScheduleCache)
+     * @param[in]   cipher  Cipher::DECRYPTION key schedule
+     * @param[in]   iv      BLOCK_SIZE bytes iv
+     */
+    void init(const Cipher& cipher, const std::uint8_t* iv) noexcept
+    {
+        cipher_ = cipher;
+        std::memcpy(iv_, iv, BLOCK_SIZE);
+    }
+
     void reset(const std::uint8_t* iv) noexcept
     {
-        this->BlockCipherModeImpl<BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcDecryptor>::reset();
         std::memcpy(iv_, iv, BLOCK_SIZE);
     }
 
+    /**
+     * @brief           enable PKCS7 padding, do_final strips it
+     */
+    void set_pkcs7(bool enable) noexcept
+    {
+        using Base = BlockCipherModeImpl<Cipher::BLOCK_SIZE, CbcDecryptor>;
+        this->Base::set_padding(enable ? Base::Padding::PKCS7_UNPAD
+                                       : Base::Padding::NONE);
+    }
+
 private:
     void update_blocks(std::uint8_t*       out,
                        const std::uint8_t* in,
@@ -255,15 +326,21 @@ private:
         constexpr std::size_t PARALLEL_BYTES = BLOCK_SIZE * PARALLEL_NUM;
         constexpr std::size_t REMAIN         = PARALLEL_BYTES - BLOCK_SIZE;
 
+        // out == in is allowed: the last ciphertext block is saved as the
+        // next iv, and the blocks are xored back to front so a ciphertext
+        // block is read before its slot is overwritten
         std::uint8_t buffer[PARALLEL_BYTES], next_iv[BLOCK_SIZE];
         while (block_num >= PARALLEL_NUM)
         {
             std::memcpy(next_iv, in + REMAIN, BLOCK_SIZE);
 
             cipher_.decrypt_blocks(buffer, in, PARALLEL_NUM);
+            for (std::size_t i = REMAIN; i != 0; i -= BLOCK_SIZE)
+            {
+                memory_utils::memxor<BLOCK_SIZE>(out + i, buffer + i,
+                                                 in + i - BLOCK_SIZE);
+            }
             memory_utils::memxor<BLOCK_SIZE>(out, buffer, iv_);
-            std::uint8_t *ptr1 = out + BLOCK_SIZE, *ptr2 = buffer + BLOCK_SIZE;
-            memory_utils::memxor<REMAIN>(ptr1, ptr2, in);
             in += PARALLEL_BYTES, out += PARALLEL_BYTES;
             block_num -= PARALLEL_NUM;
 
@@ -275,9 +352,12 @@ private:
             std::memcpy(next_iv, in + remain, BLOCK_SIZE);
 
             cipher_.decrypt_blocks(buffer, in, block_num);
+            for (std::size_t i = remain; i != 0; i -= BLOCK_SIZE)
+            {
+                memory_utils::memxor<BLOCK_SIZE>(out + i, buffer + i,
+                                                 in + i - BLOCK_SIZE);
+            }
             memory_utils::memxor<BLOCK_SIZE>(out, buffer, iv_);
-            std::uint8_t *ptr1 = out + BLOCK_SIZE, *ptr2 = buffer + BLOCK_SIZE;
-            memory_utils::memxor_n(ptr1, ptr2, in, remain);
 
             std::memcpy(iv_, next_iv, BLOCK_SIZE);
         }
@@ -301,6 +381,76 @@ private:
     }
 };
 
+/**
+ * @brief   CBC encryption of independent streams in parallel lanes
+ * @details CBC encryption is a serial chain, so one message can not use the
+ *          parallel cipher backend. Here up to Cipher::PARALLEL_NUM streams
+ *          (same key, own iv and data) are advanced together, one
+ *          encrypt_blocks call per step. The gain is that of the backend:
+ *          with Cipher::PARALLEL_NUM = 1 (the portable SM4 and AES ones)
+ *          this is no faster than a CbcEncryptor per stream.
+ */
+template <class Cipher>
+class CbcMultiEncryptor
+{
+    static_assert(type_traits::is_valid_cipher<Cipher>::value,
+                  "invalid block cipher class");
+
+public:
+    static constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN;
+
+    static constexpr std::size_t LANE_NUM = Cipher::PARALLEL_NUM;
+
+private:
+    Cipher cipher_;
+
+public:
+    CbcMultiEncryptor() = default;
+
+    CbcMultiEncryptor(const std::uint8_t* user_key)
+    {
+        this->init(user_key);
+    }
+
+public:
+    void init(const std::uint8_t* user_key)
+    {
+        cipher_.set_key(user_key, Cipher::ENCRYPTION);
+    }
+
+    /**
+     * @brief                   encrypt streams, iv of each stream is updated
+     *                          to its last ciphertext block
+     * @param[in,out]   streams     streams, len multiple of BLOCK_SIZE
+     * @param[in]       stream_num  stream number
+     */
+    void update(MultiBufferStream* streams, std::size_t stream_num)
+    {
+        for (std::size_t i = 0; i < stream_num; i++)
+        {
+            if (streams[i].len % BLOCK_SIZE != 0)
+            {
+                throw std::runtime_error(
+                    "input data length in CBC mode needs to "
+                    "be an integer multiple of BLOCK_SIZE");
+            }
+        }
+        internal::multi_buffer_crypt(
+            cipher_, streams, stream_num,
+            [](std::uint8_t* block, const MultiBufferStream& s,
+               std::size_t offset) {
+                memory_utils::memxor<BLOCK_SIZE>(block, s.in + offset, s.iv);
+            },
+            [](const MultiBufferStream& s, std::size_t offset,
+               const std::uint8_t* block, std::size_t) {
+                std::memcpy(s.out + offset, block, BLOCK_SIZE);
+                std::memcpy(s.iv, block, BLOCK_SIZE);
+            });
+    }
+};
+
 } // namespace block_cipher_mode
 
 #endif
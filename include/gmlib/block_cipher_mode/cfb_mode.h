@@ -2,6 +2,7 @@
 #define BLOCK_CIPHER_MODE_CFB_MODE_H
 
 #include <gmlib/block_cipher_mode/block_cipher_mode.h>
+#include <gmlib/block_cipher_mode/internal/multi_buffer.h>
 #include <gmlib/memory_utils/memxor.h>
 
 #include <stdexcept>
@@ -9,11 +10,14 @@
 namespace block_cipher_mode {
 
 template <class Cipher>
-class CfbEncryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class CfbEncryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, CfbEncryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, CfbEncryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/CFB-ENC";
 
@@ -106,7 +110,7 @@ public:
 
     void reset(const std::uint8_t* iv) noexcept
     {
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, CfbEncryptor>::reset();
         std::memcpy(iv_, iv, Cipher::BLOCK_SIZE);
     }
 
@@ -142,11 +146,14 @@ private:
 };
 
 template <class Cipher>
-class CfbDecryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class CfbDecryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, CfbDecryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, CfbDecryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/CFB-DEC";
 
@@ -239,7 +246,7 @@ public:
 
     void reset(const std::uint8_t* iv) noexcept
     {
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, CfbDecryptor>::reset();
         std::memcpy(iv_, iv, Cipher::BLOCK_SIZE);
     }
 
@@ -289,6 +296,69 @@ private:
     }
 };
 
+/**
+ * @brief   CFB encryption of independent streams in parallel lanes
+ * @details up to Cipher::PARALLEL_NUM streams (same key, own iv and data)
+ *          are advanced together, one encrypt_blocks call per step. With
+ *          Cipher::PARALLEL_NUM = 1 this is no faster than a CfbEncryptor
+ *          per stream.
+ */
+template <class Cipher>
+class CfbMultiEncryptor
+{
+    static_assert(type_traits::is_valid_cipher<Cipher>::value,
+                  "invalid block cipher class");
+
+public:
+    static constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN;
+
+    static constexpr std::size_t LANE_NUM = Cipher::PARALLEL_NUM;
+
+private:
+    Cipher cipher_;
+
+public:
+    CfbMultiEncryptor() = default;
+
+    CfbMultiEncryptor(const std::uint8_t* user_key)
+    {
+        this->init(user_key);
+    }
+
+public:
+    void init(const std::uint8_t* user_key)
+    {
+        cipher_.set_key(user_key, Cipher::ENCRYPTION);
+    }
+
+    /**
+     * @brief                   encrypt streams, iv of each stream is updated
+     *                          to its last ciphertext block
+     * @param[in,out]   streams     streams, a partial last block is allowed
+     *                              and finishes the stream
+     * @param[in]       stream_num  stream number
+     */
+    void update(MultiBufferStream* streams, std::size_t stream_num)
+    {
+        internal::multi_buffer_crypt(
+            cipher_, streams, stream_num,
+            [](std::uint8_t* block, const MultiBufferStream& s, std::size_t) {
+                std::memcpy(block, s.iv, BLOCK_SIZE);
+            },
+            [](const MultiBufferStream& s, std::size_t offset,
+               const std::uint8_t* block, std::size_t n) {
+                memory_utils::memxor_n(s.out + offset, s.in + offset, block,
+                                       n);
+                if (n == BLOCK_SIZE)
+                {
+                    std::memcpy(s.iv, s.out + offset, BLOCK_SIZE);
+                }
+            });
+    }
+};
+
 } // namespace block_cipher_mode
 
 #endif
\ No newline at end of file
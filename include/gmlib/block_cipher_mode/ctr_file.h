@@ -0,0 +1,90 @@
+#ifndef BLOCK_CIPHER_MODE_CTR_FILE_H
+#define BLOCK_CIPHER_MODE_CTR_FILE_H
+
+#include <gmlib/block_cipher_mode/ctr_mode.h>
+#include <gmlib/memory_utils/mapped_file.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace block_cipher_mode {
+
+/**
+ * @brief                   CTR crypt a whole file into another one
+ * @details                 both files are memory mapped, chunks of
+ *                          MAPPED_FILE_CHUNK_SIZE bytes are handed out to
+ *                          thread_num threads, each one crypting with
+ *                          CtrCryptor::crypt_at. The stream starts from the
+ *                          iv of ctr, whose update state is not used.
+ * @param[in]   ctr         initialized CTR cryptor
+ * @param[in]   in_path     input file (UTF-8)
+ * @param[in]   out_path    output file (UTF-8), created or replaced once
+ *                          complete, must not be the input file (even by
+ *                          another path)
+ * @param[in]   thread_num  crypting threads, 0 for all hardware threads
+ */
+template <class Cipher>
+void ctr_crypt_file(const CtrCryptor<Cipher>& ctr,
+                    const char*               in_path,
+                    const char*               out_path,
+                    std::size_t               thread_num = 0)
+{
+    constexpr std::size_t CHUNK_SIZE = memory_utils::MAPPED_FILE_CHUNK_SIZE;
+
+    // the output is written to a temporary file, renamed on success
+    memory_utils::MappedFile in(in_path);
+    memory_utils::MappedFile out(out_path, in.size(), &in);
+
+    const std::uint8_t* src       = in.data();
+    std::uint8_t*       dst       = out.writable_data();
+    std::size_t         len       = in.size();
+    std::size_t         chunk_num = (len + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    if (thread_num == 0)
+    {
+        thread_num = std::thread::hardware_concurrency();
+        thread_num = (thread_num == 0) ? 1 : thread_num;
+    }
+    thread_num = (thread_num > chunk_num) ? chunk_num : thread_num;
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        std::size_t i;
+        while ((i = next.fetch_add(1, std::memory_order_relaxed)) < chunk_num)
+        {
+            std::size_t offset = i * CHUNK_SIZE;
+            std::size_t size   = len - offset;
+            size               = (size > CHUNK_SIZE) ? CHUNK_SIZE : size;
+            ctr.crypt_at(offset, dst + offset, src + offset, size);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        for (std::size_t t = 1; t < thread_num; t++)
+        {
+            threads.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+        // stop the started threads before unwinding
+        next.store(chunk_num, std::memory_order_relaxed);
+        for (std::thread& th : threads)
+        {
+            th.join();
+        }
+        throw;
+    }
+    worker();
+    for (std::thread& th : threads)
+    {
+        th.join();
+    }
+    out.commit();
+}
+
+} // namespace block_cipher_mode
+
+#endif
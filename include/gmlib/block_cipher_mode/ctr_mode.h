@@ -10,11 +10,14 @@
 namespace block_cipher_mode {
 
 template <class Cipher>
-class CtrCryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class CtrCryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, CtrCryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, CtrCryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/CTR";
 
@@ -89,6 +92,7 @@ public:
 private:
     Cipher       cipher_;
     std::uint8_t counter_[Cipher::BLOCK_SIZE];
+    std::uint8_t counter0_[Cipher::BLOCK_SIZE];
 
 public:
     CtrCryptor() = default;
@@ -97,17 +101,88 @@ public:
         this->init(user_key, iv);
     }
 
+    CtrCryptor(const Cipher& cipher, const std::uint8_t* iv)
+    {
+        this->init(cipher, iv);
+    }
+
 public:
     void init(const std::uint8_t* user_key, const std::uint8_t* iv)
     {
         cipher_.set_key(user_key, Cipher::ENCRYPTION);
         std::memcpy(counter_, iv, Cipher::BLOCK_SIZE);
+        std::memcpy(counter0_, iv, Cipher::BLOCK_SIZE);
+    }
+
+    /**
+     * @brief               use a ready key schedule (e.g. KeyScheduleCache)
+     * @param[in]   cipher  Cipher::ENCRYPTION key schedule
+     * @param[in]   iv      BLOCK_SIZE bytes initial counter
+     */
+    void init(const Cipher& cipher, const std::uint8_t* iv) noexcept
+    {
+        cipher_ = cipher;
+        std::memcpy(counter_, iv, Cipher::BLOCK_SIZE);
+        std::memcpy(counter0_, iv, Cipher::BLOCK_SIZE);
     }
 
     void reset(const std::uint8_t* iv) noexcept
     {
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, CtrCryptor>::reset();
         std::memcpy(counter_, iv, Cipher::BLOCK_SIZE);
+        std::memcpy(counter0_, iv, Cipher::BLOCK_SIZE);
+    }
+
+    /**
+     * @brief               random access crypt, encryption and decryption
+     *                      are the same operation
+     * @details             crypts len bytes found at byte offset of the
+     *                      stream that starts from the iv of init/reset.
+     *                      Only reads the key schedule and the initial
+     *                      counter, so it may be called concurrently from
+     *                      many threads and does not disturb update/do_final.
+     * @param[in]   offset  byte offset in the stream
+     * @param[out]  out     output, len bytes
+     * @param[in]   in      input, len bytes
+     * @param[in]   len     data length (in bytes)
+     */
+    void crypt_at(std::uint64_t       offset,
+                  std::uint8_t*       out,
+                  const std::uint8_t* in,
+                  std::size_t         len) const
+    {
+        constexpr std::size_t BLOCK_SIZE     = Cipher::BLOCK_SIZE;
+        constexpr std::size_t PARALLEL_NUM   = Cipher::PARALLEL_NUM;
+        constexpr std::size_t PARALLEL_BYTES = BLOCK_SIZE * PARALLEL_NUM;
+
+        if (len == 0)
+        {
+            return;
+        }
+        std::uint8_t counter[BLOCK_SIZE];
+        std::uint8_t key_stream[PARALLEL_BYTES];
+        internal::ctr_add<BLOCK_SIZE>(counter, counter0_, offset / BLOCK_SIZE);
+        std::size_t skip = (std::size_t)(offset % BLOCK_SIZE);
+        while (len)
+        {
+            std::size_t block_num = (skip + len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            if (block_num > PARALLEL_NUM)
+            {
+                block_num = PARALLEL_NUM;
+            }
+            // generate counter
+            internal::ctr_gen_blocks<BLOCK_SIZE>(key_stream, counter,
+                                                 block_num);
+            // generate key stream
+            cipher_.encrypt_blocks(key_stream, key_stream, block_num);
+            std::size_t size = block_num * BLOCK_SIZE - skip;
+            if (size > len)
+            {
+                size = len;
+            }
+            memory_utils::memxor_n(out, in, key_stream + skip, size);
+            out += size, in += size, len -= size, skip = 0;
+        }
     }
 
 private:
@@ -119,15 +194,7 @@ private:
         }
         constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
         // generate counter
-        std::uint8_t* cur_counter = out;
-        std::memcpy(cur_counter, counter_, BLOCK_SIZE);
-        for (std::size_t i = 1; i < block_num; i++)
-        {
-            std::uint8_t* nxt_counter = cur_counter + BLOCK_SIZE;
-            internal::ctr_inc<BLOCK_SIZE>(nxt_counter, cur_counter);
-            cur_counter = nxt_counter;
-        }
-        internal::ctr_inc<BLOCK_SIZE>(counter_, cur_counter);
+        internal::ctr_gen_blocks<BLOCK_SIZE>(out, counter_, block_num);
         // generate key stream
         cipher_.encrypt_blocks(out, out, block_num);
     }
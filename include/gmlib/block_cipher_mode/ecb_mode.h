@@ -8,11 +8,14 @@
 namespace block_cipher_mode {
 
 template <class Cipher>
-class EcbEncryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class EcbEncryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbEncryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbEncryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/ECB-ENC";
 
@@ -80,9 +83,16 @@ private:
 public:
     EcbEncryptor() = default;
 
-    EcbEncryptor(const std::uint8_t* user_key)
+    EcbEncryptor(const std::uint8_t* user_key, bool pkcs7 = false)
     {
         this->init(user_key);
+        this->set_pkcs7(pkcs7);
+    }
+
+    EcbEncryptor(const Cipher& cipher, bool pkcs7 = false)
+    {
+        this->init(cipher);
+        this->set_pkcs7(pkcs7);
     }
 
 public:
@@ -91,9 +101,28 @@ public:
         cipher_.set_key(user_key, Cipher::ENCRYPTION);
     }
 
+    /**
+     * @brief               use a ready key schedule (e.g. KeyScheduleCache)
+     * @param[in]   cipher  Cipher::ENCRYPTION key schedule
+     */
+    void init(const Cipher& cipher) noexcept
+    {
+        cipher_ = cipher;
+    }
+
     void reset() noexcept
     {
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbEncryptor>::reset();
+    }
+
+    /**
+     * @brief           enable PKCS7 padding, do_final pads the last block
+     */
+    void set_pkcs7(bool enable) noexcept
+    {
+        using Base = BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbEncryptor>;
+        this->Base::set_padding(enable ? Base::Padding::PKCS7_PAD
+                                       : Base::Padding::NONE);
     }
 
 private:
@@ -123,11 +152,14 @@ private:
 };
 
 template <class Cipher>
-class EcbDecryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class EcbDecryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbDecryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbDecryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/ECB-DEC";
 
@@ -195,9 +227,16 @@ private:
 public:
     EcbDecryptor() = default;
 
-    EcbDecryptor(const std::uint8_t* user_key)
+    EcbDecryptor(const std::uint8_t* user_key, bool pkcs7 = false)
     {
         this->init(user_key);
+        this->set_pkcs7(pkcs7);
+    }
+
+    EcbDecryptor(const Cipher& cipher, bool pkcs7 = false)
+    {
+        this->init(cipher);
+        this->set_pkcs7(pkcs7);
     }
 
 public:
@@ -206,9 +245,28 @@ public:
         cipher_.set_key(user_key, Cipher::DECRYPTION);
     }
 
+    /**
+     * @brief               use a ready key schedule (e.g. KeyScheduleCache)
+     * @param[in]   cipher  Cipher::DECRYPTION key schedule
+     */
+    void init(const Cipher& cipher) noexcept
+    {
+        cipher_ = cipher;
+    }
+
     void reset() noexcept
     {
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbDecryptor>::reset();
+    }
+
+    /**
+     * @brief           enable PKCS7 padding, do_final strips it
+     */
+    void set_pkcs7(bool enable) noexcept
+    {
+        using Base = BlockCipherModeImpl<Cipher::BLOCK_SIZE, EcbDecryptor>;
+        this->Base::set_padding(enable ? Base::Padding::PKCS7_UNPAD
+                                       : Base::Padding::NONE);
     }
 
 private:
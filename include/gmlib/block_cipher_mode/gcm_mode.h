@@ -4,12 +4,13 @@
 #include <gmlib/block_cipher_mode/block_cipher_mode.h>
 #include <gmlib/block_cipher_mode/internal/gctr_inc.h>
 #include <gmlib/ghash/ghash.h>
+#include <gmlib/memory_utils/iovec.h>
 #include <gmlib/memory_utils/memxor.h>
 
 namespace block_cipher_mode {
 
-template <class Cipher>
-class GctrCryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+template <class Cipher, class Derived = void>
+class GctrCryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, Derived>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
@@ -80,7 +81,7 @@ public:
         static const std::uint8_t ZERO[16] = {0};
         std::uint8_t              t[16];
 
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, Derived>::reset();
         hash.reset();
         // init counter
         if (iv_len == 12)
@@ -103,6 +104,30 @@ public:
         internal::gctr_inc(counter_, counter0_);
     }
 
+protected:
+    /**
+     * @brief               gmac the aad fragments, zero padded to a block
+     * @param[in]   aad     aad fragments
+     * @param[in]   aad_num fragment number
+     * @return              aad length (in bytes)
+     */
+    static std::uint64_t hash_aad(ghash::GHash&              hash,
+                                  const memory_utils::IoVec* aad,
+                                  std::size_t                aad_num)
+    {
+        static const std::uint8_t ZERO[16] = {0};
+
+        std::size_t aad_len = memory_utils::iovec_len(aad, aad_num);
+        if (aad_len > UINT64_MAX / 8)
+        {
+            throw std::runtime_error(
+                "additional authenticated data length too long");
+        }
+        hash.update_v(aad, aad_num);
+        hash.update(ZERO, (16 - (aad_len % 16)) % 16);
+        return (std::uint64_t)aad_len;
+    }
+
 private:
     void gen_block_key_stream(std::uint8_t* out, std::size_t block_num)
     {
@@ -111,15 +136,7 @@ private:
             return;
         }
         // generate counter
-        std::uint8_t* cur_counter = out;
-        std::memcpy(cur_counter, counter_, 16);
-        for (std::size_t i = 1; i < block_num; i++)
-        {
-            std::uint8_t* nxt_counter = cur_counter + 16;
-            internal::gctr_inc(nxt_counter, cur_counter);
-            cur_counter = nxt_counter;
-        }
-        internal::gctr_inc(counter_, cur_counter);
+        internal::gctr_gen_blocks(out, counter_, block_num);
         // generate key stream
         cipher_.encrypt_blocks(out, out, block_num);
     }
@@ -169,12 +186,15 @@ protected:
 };
 
 template <class Cipher>
-class GcmEncryptor : public GctrCryptor<Cipher>
+class GcmEncryptor final
+    : public GctrCryptor<Cipher, GcmEncryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
     static_assert(Cipher::BLOCK_SIZE == 16, "gcm need BLOCK_SIZE=16");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, GcmEncryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/GCM-ENC";
 
@@ -296,19 +316,8 @@ public:
               const std::uint8_t* aad,
               std::size_t         aad_len)
     {
-        if (aad_len > UINT64_MAX / 8)
-        {
-            throw std::runtime_error(
-                "additional authenticated data length too loog");
-        }
-        this->GctrCryptor<Cipher>::init(user_key, iv, iv_len, hash_);
-        // gmac aad(additional authenticated data)
-        static std::uint8_t ZERO[16] = {0};
-        hash_.update(aad, aad_len);
-        hash_.update(ZERO, (16 - (aad_len % 16)) % 16);
-        aad_len_ = (std::uint64_t)aad_len;
-        ct_len_  = 0;
-        std::memset(tag_, 0, 16);
+        memory_utils::IoVec v = {aad, aad_len};
+        this->init(user_key, iv, iv_len, &v, 1);
     }
 
     void reset(const std::uint8_t* iv,
@@ -316,17 +325,38 @@ public:
                const std::uint8_t* aad,
                std::size_t         aad_len)
     {
-        if (aad_len > UINT64_MAX / 8)
-        {
-            throw std::runtime_error(
-                "additional authenticated data length too loog");
-        }
-        this->GctrCryptor<Cipher>::reset(iv, iv_len, hash_);
+        memory_utils::IoVec v = {aad, aad_len};
+        this->reset(iv, iv_len, &v, 1);
+    }
+
+    /**
+     * @brief               init with a scatter/gather aad, the fragments
+     *                      are fed to ghash without being joined
+     * @param[in]   aad     aad fragments
+     * @param[in]   aad_num fragment number
+     */
+    void init(const std::uint8_t*        user_key,
+              const std::uint8_t*        iv,
+              std::size_t                iv_len,
+              const memory_utils::IoVec* aad,
+              std::size_t                aad_num)
+    {
+        this->GctrCryptor<Cipher, GcmEncryptor>::init(user_key, iv, iv_len,
+                                                      hash_);
         // gmac aad(additional authenticated data)
-        static std::uint8_t ZERO[16] = {0};
-        hash_.update(aad, aad_len);
-        hash_.update(ZERO, (16 - (aad_len % 16)) % 16);
-        aad_len_ = (std::uint64_t)aad_len;
+        aad_len_ = this->hash_aad(hash_, aad, aad_num);
+        ct_len_  = 0;
+        std::memset(tag_, 0, 16);
+    }
+
+    void reset(const std::uint8_t*        iv,
+               std::size_t                iv_len,
+               const memory_utils::IoVec* aad,
+               std::size_t                aad_num)
+    {
+        this->GctrCryptor<Cipher, GcmEncryptor>::reset(iv, iv_len, hash_);
+        // gmac aad(additional authenticated data)
+        aad_len_ = this->hash_aad(hash_, aad, aad_num);
         ct_len_  = 0;
         std::memset(tag_, 0, 16);
     }
@@ -341,7 +371,8 @@ private:
                        const std::uint8_t* in,
                        std::size_t         block_num) override
     {
-        this->GctrCryptor<Cipher>::update_blocks(out, in, block_num);
+        this->GctrCryptor<Cipher, GcmEncryptor>::update_blocks(out, in,
+                                                               block_num);
         // gmac
         std::size_t outl       = block_num * Cipher::BLOCK_SIZE;
         std::size_t nxt_ct_len = ct_len_ + outl;
@@ -360,7 +391,7 @@ private:
         static const std::uint8_t ZERO[16] = {0};
         if (inl)
         {
-            this->GctrCryptor<Cipher>::final_block(out, in, inl);
+            this->GctrCryptor<Cipher, GcmEncryptor>::final_block(out, in, inl);
             hash_.update(out, inl);
             hash_.update(ZERO, (16 - inl % 16) % 16);
 
@@ -376,19 +407,22 @@ private:
         memory_utils::store64_be(t + 8, ct_len_ * 8);
         hash_.update(t, 16);
         hash_.do_final(tag_);
-        this->GctrCryptor<Cipher>::cipher_.encrypt_block(
-            t, this->GctrCryptor<Cipher>::get_counter0());
+        this->GctrCryptor<Cipher, GcmEncryptor>::cipher_.encrypt_block(
+            t, this->GctrCryptor<Cipher, GcmEncryptor>::get_counter0());
         memory_utils::memxor<16>(tag_, tag_, t);
     }
 };
 
 template <class Cipher>
-class GcmDecryptor : public GctrCryptor<Cipher>
+class GcmDecryptor final
+    : public GctrCryptor<Cipher, GcmDecryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
     static_assert(Cipher::BLOCK_SIZE == 16, "gcm need BLOCK_SIZE=16");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, GcmDecryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/GCM-DEC";
 
@@ -523,18 +557,8 @@ public:
               const std::uint8_t* aad,
               std::size_t         aad_len)
     {
-        if (aad_len > UINT64_MAX / 8)
-        {
-            throw std::runtime_error(
-                "additional authenticated data length too loog");
-        }
-        this->GctrCryptor<Cipher>::init(user_key, iv, iv_len, hash_);
-        static const std::uint8_t ZERO[16] = {0};
-        // gmac aad(additional authenticated data)
-        hash_.update(aad, aad_len);
-        hash_.update(ZERO, (16 - (aad_len % 16)) % 16);
-        aad_len_ = aad_len;
-        ct_len_  = 0;
+        memory_utils::IoVec v = {aad, aad_len};
+        this->init(user_key, iv, iv_len, &v, 1);
     }
 
     void reset(const std::uint8_t* iv,
@@ -542,17 +566,38 @@ public:
                const std::uint8_t* aad,
                std::size_t         aad_len)
     {
-        if (aad_len > UINT64_MAX / 8)
-        {
-            throw std::runtime_error(
-                "additional authenticated data length too loog");
-        }
-        this->GctrCryptor<Cipher>::reset(iv, iv_len, hash_);
+        memory_utils::IoVec v = {aad, aad_len};
+        this->reset(iv, iv_len, &v, 1);
+    }
+
+    /**
+     * @brief               init with a scatter/gather aad, the fragments
+     *                      are fed to ghash without being joined
+     * @param[in]   aad     aad fragments
+     * @param[in]   aad_num fragment number
+     */
+    void init(const std::uint8_t*        user_key,
+              const std::uint8_t*        iv,
+              std::size_t                iv_len,
+              const memory_utils::IoVec* aad,
+              std::size_t                aad_num)
+    {
+        this->GctrCryptor<Cipher, GcmDecryptor>::init(user_key, iv, iv_len,
+                                                      hash_);
+        // gmac aad(additional authenticated data), a tag set before init
+        // (as init(params) does) is kept
+        aad_len_ = this->hash_aad(hash_, aad, aad_num);
+        ct_len_  = 0;
+    }
+
+    void reset(const std::uint8_t*        iv,
+               std::size_t                iv_len,
+               const memory_utils::IoVec* aad,
+               std::size_t                aad_num)
+    {
+        this->GctrCryptor<Cipher, GcmDecryptor>::reset(iv, iv_len, hash_);
         // gmac aad(additional authenticated data)
-        static std::uint8_t ZERO[16] = {0};
-        hash_.update(aad, aad_len);
-        hash_.update(ZERO, (16 - (aad_len % 16)) % 16);
-        aad_len_ = (std::uint64_t)aad_len;
+        aad_len_ = this->hash_aad(hash_, aad, aad_num);
         ct_len_  = 0;
         std::memset(tag_, 0, 16);
     }
@@ -580,14 +625,15 @@ private:
         ct_len_ = nxt_ct_len;
         hash_.update(in, block_num * Cipher::BLOCK_SIZE);
         // gctr
-        this->GctrCryptor<Cipher>::update_blocks(out, in, block_num);
+        this->GctrCryptor<Cipher, GcmDecryptor>::update_blocks(out, in,
+                                                               block_num);
     }
 
     void final_block(std::uint8_t*       out,
                      const std::uint8_t* in,
                      std::size_t         inl) override
     {
-        static std::uint8_t t[16] = {0}, tag[16];
+        static const std::uint8_t ZERO[16] = {0};
         if (inl != 0)
         {
             std::size_t nxt_ct_len = ct_len_ + inl;
@@ -598,16 +644,17 @@ private:
             ct_len_ = nxt_ct_len;
 
             hash_.update(in, inl);
-            hash_.update(t, (16 - inl % 16) % 16);
+            hash_.update(ZERO, (16 - inl % 16) % 16);
 
-            this->GctrCryptor<Cipher>::final_block(out, in, inl);
+            this->GctrCryptor<Cipher, GcmDecryptor>::final_block(out, in, inl);
         }
+        std::uint8_t t[16], tag[16];
         memory_utils::store64_be(t + 0, aad_len_ * 8);
         memory_utils::store64_be(t + 8, ct_len_ * 8);
         hash_.update(t, 16);
         hash_.do_final(tag);
-        this->GctrCryptor<Cipher>::cipher_.encrypt_block(
-            t, this->GctrCryptor<Cipher>::get_counter0());
+        this->GctrCryptor<Cipher, GcmDecryptor>::cipher_.encrypt_block(
+            t, this->GctrCryptor<Cipher, GcmDecryptor>::get_counter0());
         memory_utils::memxor<16>(tag, tag, t);
         if (std::memcmp(tag, tag_, 16) != 0)
         {
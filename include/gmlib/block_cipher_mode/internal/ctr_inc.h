@@ -4,6 +4,11 @@
 #include <gmlib/memory_utils/endian.h>
 
 #include <cstddef>
+#include <cstring>
+
+#if defined(CPU_FLAG_SSSE3) || defined(CPU_FLAG_AVX2)
+#include <immintrin.h>
+#endif
 
 namespace block_cipher_mode {
 namespace internal {
@@ -60,6 +65,159 @@ static inline void ctr_inc(std::uint8_t* out, const std::uint8_t* in) noexcept
     ctr_inc_n(out, in, BLOCK_SIZE);
 }
 
+static inline void ctr_add8(std::uint8_t*       out,
+                            const std::uint8_t* in,
+                            std::uint64_t       n) noexcept
+{
+    std::uint64_t tmp = n & UINT32_MAX;
+    tmp += memory_utils::load32_be(in + 4);
+    memory_utils::store32_be(out + 4, tmp & UINT32_MAX);
+    tmp = memory_utils::load32_be(in + 0) + (tmp >> 32) + (n >> 32);
+    memory_utils::store32_be(out + 0, tmp & UINT32_MAX);
+}
+
+static inline void ctr_add16(std::uint8_t*       out,
+                             const std::uint8_t* in,
+                             std::uint64_t       n) noexcept
+{
+    std::uint64_t tmp = n & UINT32_MAX;
+    tmp += memory_utils::load32_be(in + 12);
+    memory_utils::store32_be(out + 12, tmp & UINT32_MAX);
+    tmp = memory_utils::load32_be(in + 8) + (tmp >> 32) + (n >> 32);
+    memory_utils::store32_be(out + 8, tmp & UINT32_MAX);
+    tmp = memory_utils::load32_be(in + 4) + (tmp >> 32);
+    memory_utils::store32_be(out + 4, tmp & UINT32_MAX);
+    tmp = memory_utils::load32_be(in + 0) + (tmp >> 32);
+    memory_utils::store32_be(out + 0, tmp & UINT32_MAX);
+}
+
+static void ctr_add_n(std::uint8_t*       out,
+                      const std::uint8_t* in,
+                      std::size_t         size,
+                      std::uint64_t       n) noexcept
+{
+    std::uint16_t t = 0;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        std::size_t pos = size - 1 - i;
+        t += (std::uint16_t)in[pos] + (std::uint16_t)(n & 0xFF);
+        out[pos] = t & 0xFF;
+        t >>= 8, n >>= 8;
+    }
+}
+
+/**
+ * @brief       out = in + n, big endian counter of BLOCK_SIZE bytes
+ */
+template <std::size_t BLOCK_SIZE>
+static inline void ctr_add(std::uint8_t*       out,
+                           const std::uint8_t* in,
+                           std::uint64_t       n) noexcept
+{
+    if constexpr (BLOCK_SIZE == 16)
+    {
+        ctr_add16(out, in, n);
+        return;
+    }
+    if constexpr (BLOCK_SIZE == 8)
+    {
+        ctr_add8(out, in, n);
+        return;
+    }
+    ctr_add_n(out, in, BLOCK_SIZE, n);
+}
+
+/**
+ * @brief           out[i] = counter + i (i = 0 ... n-1), counter += n,
+ *                  128-bit big endian counter
+ * @details         counter blocks are built in registers: the counter is
+ *                  byte swapped once, lanes are advanced with a 64-bit add
+ *                  and swapped back on store
+ */
+static inline void ctr_gen_blocks16(std::uint8_t* out,
+                                    std::uint8_t  counter[16],
+                                    std::size_t   n) noexcept
+{
+    std::uint64_t lo = memory_utils::load64_be(counter + 8);
+    if (lo + n < lo)
+    {
+        // carry into the high half, rare
+        for (std::size_t i = 0; i < n; i++)
+        {
+            std::memcpy(out + 16 * i, counter, 16);
+            ctr_inc16(counter, counter);
+        }
+        return;
+    }
+    std::size_t i = 0;
+#if defined(CPU_FLAG_AVX2)
+    const __m256i BSWAP64 = _mm256_setr_epi8(
+        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, //
+        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8  //
+    );
+    const __m256i STEP = _mm256_setr_epi64x(0, 2, 0, 2);
+    __m256i c = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)counter));
+    c = _mm256_shuffle_epi8(c, BSWAP64);
+    c = _mm256_add_epi64(c, _mm256_setr_epi64x(0, 0, 0, 1));
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_si256((__m256i*)(out + 16 * i),
+                            _mm256_shuffle_epi8(c, BSWAP64));
+        c = _mm256_add_epi64(c, STEP);
+    }
+#elif defined(CPU_FLAG_SSSE3)
+    const __m128i BSWAP64 = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, //
+                                          15, 14, 13, 12, 11, 10, 9, 8);
+    const __m128i STEP    = _mm_set_epi64x(1, 0);
+    __m128i       c       = _mm_loadu_si128((const __m128i*)counter);
+    c                     = _mm_shuffle_epi8(c, BSWAP64);
+    for (; i < n; i++)
+    {
+        _mm_storeu_si128((__m128i*)(out + 16 * i),
+                         _mm_shuffle_epi8(c, BSWAP64));
+        c = _mm_add_epi64(c, STEP);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        std::memcpy(out + 16 * i, counter, 8);
+        memory_utils::store64_be(out + 16 * i + 8, lo + i);
+    }
+    memory_utils::store64_be(counter + 8, lo + n);
+}
+
+/**
+ * @brief           out[i] = counter + i (i = 0 ... n-1), counter += n,
+ *                  big endian counter of BLOCK_SIZE bytes
+ */
+template <std::size_t BLOCK_SIZE>
+static inline void ctr_gen_blocks(std::uint8_t* out,
+                                  std::uint8_t* counter,
+                                  std::size_t   n) noexcept
+{
+    if constexpr (BLOCK_SIZE == 16)
+    {
+        ctr_gen_blocks16(out, counter, n);
+        return;
+    }
+    if constexpr (BLOCK_SIZE == 8)
+    {
+        std::uint64_t c = memory_utils::load64_be(counter);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            memory_utils::store64_be(out + 8 * i, c + i);
+        }
+        memory_utils::store64_be(counter, c + n);
+        return;
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        std::memcpy(out + BLOCK_SIZE * i, counter, BLOCK_SIZE);
+        ctr_inc_n(counter, counter, BLOCK_SIZE);
+    }
+}
+
 } // namespace internal
 } // namespace block_cipher_mode
 
@@ -3,6 +3,13 @@
 
 #include <gmlib/memory_utils/endian.h>
 
+#include <cstddef>
+#include <cstring>
+
+#if defined(CPU_FLAG_SSSE3) || defined(CPU_FLAG_AVX2)
+#include <immintrin.h>
+#endif
+
 namespace block_cipher_mode::internal {
 
 static inline void gctr_inc(std::uint8_t       out[16],
@@ -15,6 +22,55 @@ static inline void gctr_inc(std::uint8_t       out[16],
     memory_utils::store32_be(out + 12, tmp);
 }
 
+/**
+ * @brief           out[i] = inc32(counter, i) (i = 0 ... n-1),
+ *                  counter = inc32(counter, n)
+ * @details         the 96-bit prefix is kept, the low 32-bit word is
+ *                  byte swapped once and advanced with a lane add
+ */
+static inline void gctr_gen_blocks(std::uint8_t* out,
+                                   std::uint8_t  counter[16],
+                                   std::size_t   n) noexcept
+{
+    std::uint32_t c = memory_utils::load32_be(counter + 12);
+    std::size_t   i = 0;
+#if defined(CPU_FLAG_AVX2)
+    const __m256i BSWAP32 = _mm256_setr_epi8(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 14, 13, 12, //
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 14, 13, 12  //
+    );
+    const __m256i STEP = _mm256_setr_epi32(0, 0, 0, 2, 0, 0, 0, 2);
+    __m256i       t    = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)counter));
+    t = _mm256_shuffle_epi8(t, BSWAP32);
+    t = _mm256_add_epi32(t, _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, 1));
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm256_storeu_si256((__m256i*)(out + 16 * i),
+                            _mm256_shuffle_epi8(t, BSWAP32));
+        t = _mm256_add_epi32(t, STEP);
+    }
+#elif defined(CPU_FLAG_SSSE3)
+    const __m128i BSWAP32 = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, //
+                                          8, 9, 10, 11, 15, 14, 13, 12);
+    const __m128i STEP    = _mm_setr_epi32(0, 0, 0, 1);
+    __m128i       t       = _mm_loadu_si128((const __m128i*)counter);
+    t                     = _mm_shuffle_epi8(t, BSWAP32);
+    for (; i < n; i++)
+    {
+        _mm_storeu_si128((__m128i*)(out + 16 * i),
+                         _mm_shuffle_epi8(t, BSWAP32));
+        t = _mm_add_epi32(t, STEP);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        std::memcpy(out + 16 * i, counter, 12);
+        memory_utils::store32_be(out + 16 * i + 12, c + (std::uint32_t)i);
+    }
+    memory_utils::store32_be(counter + 12, c + (std::uint32_t)n);
+}
+
 } // namespace block_cipher_mode::internal
 
 #endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef BLOCK_CIPHER_MODE_INTERNAL_MULTI_BUFFER_H
+#define BLOCK_CIPHER_MODE_INTERNAL_MULTI_BUFFER_H
+
+#include <gmlib/block_cipher_mode/multi_buffer_stream.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace block_cipher_mode {
+namespace internal {
+
+/**
+ * @brief               advance up to Cipher::PARALLEL_NUM streams together,
+ *                      one encrypt_blocks call per step
+ * @param cipher        block cipher context (encryption key schedule)
+ * @param streams       streams, lanes are refilled as streams finish
+ * @param stream_num    stream number
+ * @param load          load(block, stream, offset), prepare cipher input
+ * @param store         store(stream, offset, block, n), consume n bytes
+ */
+template <class Cipher, class Load, class Store>
+void multi_buffer_crypt(const Cipher&      cipher,
+                        MultiBufferStream* streams,
+                        std::size_t        stream_num,
+                        Load               load,
+                        Store              store)
+{
+    constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+    constexpr std::size_t LANE_NUM   = Cipher::PARALLEL_NUM;
+
+    std::uint8_t       buffer[BLOCK_SIZE * LANE_NUM];
+    MultiBufferStream* lane[LANE_NUM];
+    std::size_t        offset[LANE_NUM];
+    std::size_t        lane_num = 0, next = 0;
+    while (true)
+    {
+        // refill idle lanes
+        while (lane_num < LANE_NUM && next < stream_num)
+        {
+            if (streams[next].len != 0)
+            {
+                lane[lane_num] = &streams[next], offset[lane_num] = 0;
+                lane_num++;
+            }
+            next++;
+        }
+        if (lane_num == 0)
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < lane_num; i++)
+        {
+            load(buffer + i * BLOCK_SIZE, *lane[i], offset[i]);
+        }
+        cipher.encrypt_blocks(buffer, buffer, lane_num);
+        std::size_t active = 0;
+        for (std::size_t i = 0; i < lane_num; i++)
+        {
+            std::size_t n = lane[i]->len - offset[i];
+            if (n > BLOCK_SIZE)
+            {
+                n = BLOCK_SIZE;
+            }
+            store(*lane[i], offset[i], buffer + i * BLOCK_SIZE, n);
+            offset[i] += n;
+            // drop finished lanes
+            if (offset[i] != lane[i]->len)
+            {
+                lane[active] = lane[i], offset[active] = offset[i];
+                active++;
+            }
+        }
+        lane_num = active;
+    }
+}
+
+} // namespace internal
+} // namespace block_cipher_mode
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BLOCK_CIPHER_MODE_INTERNAL_OCB_OFFSET_H
+#define BLOCK_CIPHER_MODE_INTERNAL_OCB_OFFSET_H
+
+#include <gmlib/memory_utils/endian.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace block_cipher_mode::internal {
+
+/**
+ * @brief       OCB double, out = in * x in GF(2^128)
+ * @details     RFC 7253, big endian, x^128 + x^7 + x^2 + x + 1
+ */
+static inline void ocb_double(std::uint8_t       out[16],
+                              const std::uint8_t in[16]) noexcept
+{
+    std::uint64_t hi    = memory_utils::load64_be(in + 0);
+    std::uint64_t lo    = memory_utils::load64_be(in + 8);
+    std::uint64_t carry = hi >> 63;
+    hi                  = (hi << 1) | (lo >> 63);
+    lo                  = (lo << 1) ^ (0x87 & (0 - carry));
+    memory_utils::store64_be(out + 0, hi);
+    memory_utils::store64_be(out + 8, lo);
+}
+
+/**
+ * @brief       number of trailing zero bits, n != 0
+ */
+static inline unsigned ocb_ntz(std::uint64_t n) noexcept
+{
+    unsigned r = 0;
+    while ((n & 1) == 0)
+    {
+        n >>= 1, r++;
+    }
+    return r;
+}
+
+/**
+ * @brief           generate n consecutive offsets,
+ *                  Offset_i = Offset_{i-1} xor L_{ntz(i)}
+ * @param out       16 x n bytes, offsets of block index+1 ... index+n
+ * @param offset    16 bytes, in/out, offset of block index
+ * @param L         L_0, L_1, ... table, 16 bytes each
+ * @param index     in/out, index of the last processed block
+ * @param n         offset number
+ */
+static inline void ocb_gen_offsets(std::uint8_t*       out,
+                                   std::uint8_t        offset[16],
+                                   const std::uint8_t  L[][16],
+                                   std::uint64_t*      index,
+                                   std::size_t         n) noexcept
+{
+    std::uint64_t t0  = memory_utils::load64_le(offset + 0);
+    std::uint64_t t1  = memory_utils::load64_le(offset + 8);
+    std::uint64_t idx = *index;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        const std::uint8_t* l = L[ocb_ntz(++idx)];
+        t0 ^= memory_utils::load64_le(l + 0);
+        t1 ^= memory_utils::load64_le(l + 8);
+        memory_utils::store64_le(out + 16 * i + 0, t0);
+        memory_utils::store64_le(out + 16 * i + 8, t1);
+    }
+    memory_utils::store64_le(offset + 0, t0);
+    memory_utils::store64_le(offset + 8, t1);
+    *index = idx;
+}
+
+} // namespace block_cipher_mode::internal
+
+#endif
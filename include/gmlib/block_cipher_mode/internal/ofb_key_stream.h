@@ -0,0 +1,223 @@
+#ifndef BLOCK_CIPHER_MODE_INTERNAL_OFB_KEY_STREAM_H
+#define BLOCK_CIPHER_MODE_INTERNAL_OFB_KEY_STREAM_H
+
+#include <gmlib/memory_utils/memxor.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace block_cipher_mode::internal {
+
+/// @brief OFB key stream blocks generated per batch, inline or ahead
+constexpr std::size_t OFB_KEY_STREAM_BATCH = 64;
+
+/**
+ * @brief   OFB key stream ring, filled ahead by a helper thread
+ * @details single producer (helper thread) and single consumer (the owning
+ *          OfbCryptor). The ring keeps its own copy of the key schedule,
+ *          so the owner may be moved or re-keyed while the thread runs.
+ *          Either side blocks on a condition variable when the ring is
+ *          empty (consumer) or full (producer).
+ */
+template <class Cipher>
+class OfbKeyStreamRing
+{
+public:
+    static constexpr std::size_t BLOCK_SIZE  = Cipher::BLOCK_SIZE;
+    static constexpr std::size_t RING_BLOCKS = 4096;
+
+private:
+    alignas(64) std::uint8_t ring_[RING_BLOCKS * BLOCK_SIZE];
+    Cipher                   cipher_;
+    std::uint8_t             iv_[BLOCK_SIZE];
+    std::size_t              total_;
+    std::atomic<std::size_t> produced_;
+    std::atomic<std::size_t> consumed_;
+    std::atomic<bool>        stop_;
+    std::mutex               mtx_;
+    std::condition_variable  produced_cv_;
+    std::condition_variable  consumed_cv_;
+    std::thread              worker_;
+
+public:
+    OfbKeyStreamRing() noexcept : total_(0), produced_(0), consumed_(0)
+    {
+        stop_.store(false);
+    }
+
+    OfbKeyStreamRing(const OfbKeyStreamRing&) = delete;
+
+    OfbKeyStreamRing& operator=(const OfbKeyStreamRing&) = delete;
+
+    ~OfbKeyStreamRing() noexcept
+    {
+        this->stop();
+    }
+
+public:
+    /**
+     * @brief               start generating key stream on a helper thread
+     * @param   cipher      cipher context (encryption key schedule), copied
+     * @param   iv          BLOCK_SIZE bytes iv
+     * @param   block_num   number of key stream blocks to generate
+     */
+    void start(const Cipher&       cipher,
+               const std::uint8_t* iv,
+               std::size_t         block_num)
+    {
+        this->stop();
+        cipher_ = cipher;
+        std::memcpy(iv_, iv, BLOCK_SIZE);
+        total_ = block_num;
+        produced_.store(0), consumed_.store(0), stop_.store(false);
+        worker_ = std::thread(&OfbKeyStreamRing::produce, this);
+    }
+
+    /**
+     * @brief   stop the helper thread, unconsumed key stream is discarded
+     * @note    join only throws for a non-joinable or the calling thread,
+     *          neither of which can happen here
+     */
+    void stop() noexcept
+    {
+        if (worker_.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                stop_.store(true);
+            }
+            consumed_cv_.notify_one();
+            worker_.join();
+        }
+        total_ = 0;
+        produced_.store(0), consumed_.store(0);
+    }
+
+    /**
+     * @brief   number of key stream blocks not consumed yet
+     */
+    std::size_t remain() const noexcept
+    {
+        return total_ - consumed_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief           xor inl bytes with the precomputed key stream, waits
+     *                  for the helper thread when needed
+     * @param   out     output
+     * @param   in      input
+     * @param   inl     input length, at most remain() x BLOCK_SIZE, a
+     *                  partial last block consumes a whole block
+     * @param   next_iv BLOCK_SIZE bytes, receives the chaining value once
+     *                  the whole precomputed stream is consumed
+     */
+    void consume(std::uint8_t*       out,
+                 const std::uint8_t* in,
+                 std::size_t         inl,
+                 std::uint8_t*       next_iv)
+    {
+        std::size_t consumed = consumed_.load(std::memory_order_relaxed);
+        while (inl)
+        {
+            std::size_t produced = produced_.load(std::memory_order_acquire);
+            if (produced == consumed)
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                produced_cv_.wait(lock, [&] {
+                    produced = produced_.load(std::memory_order_acquire);
+                    return produced != consumed;
+                });
+            }
+            std::size_t pos = consumed % RING_BLOCKS;
+            std::size_t n   = produced - consumed;
+            if (n > RING_BLOCKS - pos)
+            {
+                n = RING_BLOCKS - pos;
+            }
+            std::size_t size = n * BLOCK_SIZE;
+            if (size > inl)
+            {
+                size = inl, n = (inl + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            }
+            memory_utils::memxor_n(out, in, ring_ + pos * BLOCK_SIZE, size);
+            out += size, in += size, inl -= size, consumed += n;
+            consumed_.store(consumed, std::memory_order_release);
+            this->notify(consumed_cv_);
+        }
+        if (consumed == total_)
+        {
+            worker_.join();
+            std::memcpy(next_iv, iv_, BLOCK_SIZE);
+            total_ = 0;
+            produced_.store(0), consumed_.store(0);
+        }
+    }
+
+private:
+    void produce() noexcept
+    {
+        std::size_t produced = 0;
+        while (produced != total_)
+        {
+            std::size_t consumed = consumed_.load(std::memory_order_acquire);
+            if (produced - consumed == RING_BLOCKS)
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                consumed_cv_.wait(lock, [&] {
+                    consumed = consumed_.load(std::memory_order_acquire);
+                    return stop_.load(std::memory_order_relaxed) ||
+                           produced - consumed != RING_BLOCKS;
+                });
+            }
+            if (stop_.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            std::size_t pos = produced % RING_BLOCKS;
+            std::size_t n   = RING_BLOCKS - (produced - consumed);
+            if (n > RING_BLOCKS - pos)
+            {
+                n = RING_BLOCKS - pos;
+            }
+            if (n > OFB_KEY_STREAM_BATCH)
+            {
+                n = OFB_KEY_STREAM_BATCH;
+            }
+            if (n > total_ - produced)
+            {
+                n = total_ - produced;
+            }
+            std::uint8_t* ptr = ring_ + pos * BLOCK_SIZE;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                cipher_.encrypt_block(ptr, iv_);
+                std::memcpy(iv_, ptr, BLOCK_SIZE);
+                ptr += BLOCK_SIZE;
+            }
+            produced += n;
+            produced_.store(produced, std::memory_order_release);
+            this->notify(produced_cv_);
+        }
+    }
+
+    /**
+     * @brief   wake the other side, taking the lock first so the wake up
+     *          can not slip in between its check and its wait
+     */
+    void notify(std::condition_variable& cv) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+        }
+        cv.notify_one();
+    }
+};
+
+} // namespace block_cipher_mode::internal
+
+#endif
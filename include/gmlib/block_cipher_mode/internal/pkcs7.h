@@ -0,0 +1,57 @@
+#ifndef BLOCK_CIPHER_MODE_INTERNAL_PKCS7_H
+#define BLOCK_CIPHER_MODE_INTERNAL_PKCS7_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace block_cipher_mode::internal {
+
+/**
+ * @brief           PKCS7 pad a partial block in place
+ * @param block     BLOCK_SIZE bytes, the first inl bytes are data
+ * @param inl       data length, 0 <= inl < BLOCK_SIZE
+ */
+template <std::size_t BLOCK_SIZE>
+static inline void pkcs7_pad(std::uint8_t block[BLOCK_SIZE],
+                             std::size_t  inl) noexcept
+{
+    static_assert(BLOCK_SIZE < 256, "pkcs7 need BLOCK_SIZE < 256");
+    std::size_t pad = BLOCK_SIZE - inl;
+    std::memset(block + inl, (int)pad, pad);
+}
+
+/**
+ * @brief           check the PKCS7 padding of the last plaintext block
+ * @details         branch-free over every byte of the block, so neither the
+ *                  time nor the memory access depends on the padding value
+ *                  or on where it is wrong
+ * @param block     last plaintext block
+ * @param pad_len   padding length, 0 if the padding is invalid
+ * @return          all ones if the padding is valid, 0 otherwise
+ */
+template <std::size_t BLOCK_SIZE>
+static inline std::size_t pkcs7_check(const std::uint8_t block[BLOCK_SIZE],
+                                      std::size_t*       pad_len) noexcept
+{
+    static_assert(BLOCK_SIZE < 256, "pkcs7 need BLOCK_SIZE < 256");
+    // x < y for 0 <= x, y < 2^31, as 0 or 1
+    auto lt = [](std::uint32_t x, std::uint32_t y) noexcept {
+        return (x - y) >> 31;
+    };
+    std::uint32_t pad = block[BLOCK_SIZE - 1];
+    std::uint32_t bad = lt(pad, 1) | lt((std::uint32_t)BLOCK_SIZE, pad);
+    for (std::size_t i = 0; i < BLOCK_SIZE; i++)
+    {
+        // block[i] is a padding byte
+        std::uint32_t in_pad = lt((std::uint32_t)(BLOCK_SIZE - 1 - i), pad);
+        bad |= (0 - in_pad) & (block[i] ^ pad);
+    }
+    std::size_t ok = (std::size_t)0 - (std::size_t)lt(bad, 1);
+    *pad_len       = (std::size_t)pad & ok;
+    return ok;
+}
+
+} // namespace block_cipher_mode::internal
+
+#endif
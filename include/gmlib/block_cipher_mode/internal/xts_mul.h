@@ -0,0 +1,72 @@
+#ifndef BLOCK_CIPHER_MODE_INTERNAL_XTS_MUL_H
+#define BLOCK_CIPHER_MODE_INTERNAL_XTS_MUL_H
+
+#include <gmlib/memory_utils/endian.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(CPU_FLAG_SSE2)
+#include <immintrin.h>
+#endif
+
+namespace block_cipher_mode::internal {
+
+/**
+ * @brief       XTS tweak update, out = in * alpha in GF(2^128)
+ * @details     IEEE P1619, little endian, x^128 + x^7 + x^2 + x + 1
+ */
+static inline void xts_mul_alpha(std::uint8_t       out[16],
+                                 const std::uint8_t in[16]) noexcept
+{
+#if defined(CPU_FLAG_SSE2)
+    const __m128i POLY  = _mm_set_epi32(0, 1, 0, 0x87);
+    __m128i       t     = _mm_loadu_si128((const __m128i*)in);
+    __m128i       carry = _mm_shuffle_epi32(_mm_srai_epi32(t, 31), 0x13);
+    t = _mm_xor_si128(_mm_add_epi64(t, t), _mm_and_si128(carry, POLY));
+    _mm_storeu_si128((__m128i*)out, t);
+#else
+    std::uint64_t lo    = memory_utils::load64_le(in + 0);
+    std::uint64_t hi    = memory_utils::load64_le(in + 8);
+    std::uint64_t carry = hi >> 63;
+    hi                  = (hi << 1) | (lo >> 63);
+    lo                  = (lo << 1) ^ (0x87 & (0 - carry));
+    memory_utils::store64_le(out + 0, lo);
+    memory_utils::store64_le(out + 8, hi);
+#endif
+}
+
+/**
+ * @brief           generate n consecutive tweaks, out[0] = tweak, and
+ *                  update tweak to the one following out[n-1]
+ * @param out       16 x n bytes
+ * @param tweak     16 bytes, in/out
+ * @param n         tweak number
+ */
+static inline void xts_gen_tweaks(std::uint8_t* out,
+                                  std::uint8_t  tweak[16],
+                                  std::size_t   n) noexcept
+{
+#if defined(CPU_FLAG_SSE2)
+    const __m128i POLY = _mm_set_epi32(0, 1, 0, 0x87);
+    __m128i       t    = _mm_loadu_si128((const __m128i*)tweak);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        _mm_storeu_si128((__m128i*)(out + 16 * i), t);
+        __m128i carry = _mm_shuffle_epi32(_mm_srai_epi32(t, 31), 0x13);
+        t = _mm_xor_si128(_mm_add_epi64(t, t), _mm_and_si128(carry, POLY));
+    }
+    _mm_storeu_si128((__m128i*)tweak, t);
+#else
+    for (std::size_t i = 0; i < n; i++)
+    {
+        std::memcpy(out + 16 * i, tweak, 16);
+        xts_mul_alpha(tweak, tweak);
+    }
+#endif
+}
+
+} // namespace block_cipher_mode::internal
+
+#endif
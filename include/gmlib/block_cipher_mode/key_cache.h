@@ -0,0 +1,216 @@
+#ifndef BLOCK_CIPHER_MODE_KEY_CACHE_H
+#define BLOCK_CIPHER_MODE_KEY_CACHE_H
+
+#include <gmlib/block_cipher_mode/abc.h>
+#include <gmlib/memory_utils/memequal.h>
+#include <gmlib/memory_utils/memzero.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+namespace block_cipher_mode {
+
+/**
+ * @brief   encryption and decryption key schedule of one user key
+ * @details on destruction both schedules are re-keyed with an all-zero key,
+ *          the cipher context itself is opaque to the cache
+ */
+template <class Cipher>
+struct KeySchedule
+{
+    static_assert(type_traits::is_valid_cipher<Cipher>::value,
+                  "invalid block cipher class");
+
+    Cipher enc; // Cipher::ENCRYPTION schedule
+    Cipher dec; // Cipher::DECRYPTION schedule
+
+    explicit KeySchedule(const std::uint8_t* user_key) noexcept
+    {
+        enc.set_key(user_key, Cipher::ENCRYPTION);
+        dec.set_key(user_key, Cipher::DECRYPTION);
+    }
+
+    KeySchedule(const KeySchedule&) = delete;
+
+    KeySchedule& operator=(const KeySchedule&) = delete;
+
+    ~KeySchedule()
+    {
+        static const std::uint8_t ZERO[Cipher::USER_KEY_LEN] = {0};
+        enc.set_key(ZERO, Cipher::ENCRYPTION);
+        dec.set_key(ZERO, Cipher::DECRYPTION);
+    }
+};
+
+/**
+ * @brief   process-wide cache from user key to ready key schedules
+ * @details the cache is split into SHARD_NUM shards picked by a hash of the
+ *          key, each with CAPACITY / SHARD_NUM entries and its own
+ *          reader-writer lock. A hit only takes the shared lock; the key
+ *          schedule of a miss is computed outside of any lock. A full shard
+ *          evicts its least recently used entry, whose user key is cleared.
+ *          Handles keep a schedule alive after eviction, it is cleared
+ *          when the last handle is released.
+ */
+template <class Cipher, std::size_t CAPACITY = 256, std::size_t SHARD_NUM = 16>
+class KeyScheduleCache
+{
+    static_assert(type_traits::is_valid_cipher<Cipher>::value,
+                  "invalid block cipher class");
+    static_assert(SHARD_NUM != 0 && CAPACITY % SHARD_NUM == 0 &&
+                      CAPACITY != 0,
+                  "CAPACITY needs to be a non-zero multiple of SHARD_NUM");
+
+public:
+    using Handle = std::shared_ptr<const KeySchedule<Cipher>>;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN;
+
+private:
+    static constexpr std::size_t WAY_NUM = CAPACITY / SHARD_NUM;
+
+    struct Entry
+    {
+        std::uint8_t               user_key[USER_KEY_LEN];
+        std::atomic<std::uint64_t> last_use{0};
+        Handle                     schedule;
+    };
+
+    struct Shard
+    {
+        std::shared_mutex          mutex;
+        std::atomic<std::uint64_t> clock{0};
+        Entry                      entries[WAY_NUM];
+    };
+
+    Shard shards_[SHARD_NUM];
+
+public:
+    KeyScheduleCache() = default;
+
+    KeyScheduleCache(const KeyScheduleCache&) = delete;
+
+    KeyScheduleCache& operator=(const KeyScheduleCache&) = delete;
+
+    ~KeyScheduleCache()
+    {
+        this->clear();
+    }
+
+public:
+    /**
+     * @brief                   fetch the key schedule of user_key, the
+     *                          schedule is computed and cached on a miss
+     * @param[in]   user_key    USER_KEY_LEN bytes secret key
+     * @return                  handle, valid even after eviction
+     */
+    Handle get(const std::uint8_t* user_key)
+    {
+        Shard& shard = shards_[this->shard_index(user_key)];
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            Entry* entry = this->find(shard, user_key);
+            if (entry != nullptr)
+            {
+                this->touch(shard, *entry);
+                return entry->schedule;
+            }
+        }
+        Handle schedule = std::make_shared<const KeySchedule<Cipher>>(user_key);
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        Entry* entry = this->find(shard, user_key);
+        if (entry == nullptr)
+        {
+            // another thread may have inserted the key meanwhile
+            entry = this->victim(shard);
+            std::memcpy(entry->user_key, user_key, USER_KEY_LEN);
+            entry->schedule = std::move(schedule);
+        }
+        this->touch(shard, *entry);
+        return entry->schedule;
+    }
+
+    /**
+     * @brief   evict every entry
+     */
+    void clear() noexcept
+    {
+        for (Shard& shard : shards_)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            for (Entry& entry : shard.entries)
+            {
+                memory_utils::memzero(entry.user_key, USER_KEY_LEN);
+                entry.schedule.reset();
+            }
+        }
+    }
+
+private:
+    static std::size_t shard_index(const std::uint8_t* user_key) noexcept
+    {
+        // FNV-1a
+        std::uint64_t h = 0xcbf29ce484222325;
+        for (std::size_t i = 0; i < USER_KEY_LEN; i++)
+        {
+            h = (h ^ user_key[i]) * 0x100000001b3;
+        }
+        return (std::size_t)(h % SHARD_NUM);
+    }
+
+    /**
+     * @brief   entry of user_key or nullptr, every way is compared in
+     *          constant time and without an early exit
+     */
+    static Entry* find(Shard& shard, const std::uint8_t* user_key) noexcept
+    {
+        Entry* found = nullptr;
+        for (Entry& entry : shard.entries)
+        {
+            bool equal = memory_utils::memequal(entry.user_key, user_key,
+                                                USER_KEY_LEN);
+            if (equal && entry.schedule != nullptr)
+            {
+                found = &entry;
+            }
+        }
+        return found;
+    }
+
+    static void touch(Shard& shard, Entry& entry) noexcept
+    {
+        std::uint64_t now = shard.clock.fetch_add(1, std::memory_order_relaxed);
+        entry.last_use.store(now + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief   free entry, or the least recently used one (cleared)
+     */
+    static Entry* victim(Shard& shard) noexcept
+    {
+        Entry* lru = &shard.entries[0];
+        for (Entry& entry : shard.entries)
+        {
+            if (entry.schedule == nullptr)
+            {
+                return &entry;
+            }
+            if (entry.last_use.load(std::memory_order_relaxed) <
+                lru->last_use.load(std::memory_order_relaxed))
+            {
+                lru = &entry;
+            }
+        }
+        memory_utils::memzero(lru->user_key, USER_KEY_LEN);
+        lru->schedule.reset();
+        return lru;
+    }
+};
+
+} // namespace block_cipher_mode
+
+#endif
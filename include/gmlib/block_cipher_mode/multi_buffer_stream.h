@@ -0,0 +1,24 @@
+#ifndef BLOCK_CIPHER_MODE_MULTI_BUFFER_STREAM_H
+#define BLOCK_CIPHER_MODE_MULTI_BUFFER_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace block_cipher_mode {
+
+/**
+ * @brief   one independent message of a multi-buffer call
+ * @note    iv is updated in place to the chaining value, so the same stream
+ *          can be continued by a later call
+ */
+struct MultiBufferStream
+{
+    std::uint8_t*       out; // output, len bytes
+    const std::uint8_t* in;  // input, len bytes
+    std::size_t         len; // message length (in bytes)
+    std::uint8_t*       iv;  // BLOCK_SIZE bytes, in/out chaining value
+};
+
+} // namespace block_cipher_mode
+
+#endif
@@ -0,0 +1,601 @@
+#ifndef BLOCK_CIPHER_MODE_OCB_MODE_H
+#define BLOCK_CIPHER_MODE_OCB_MODE_H
+
+#include <gmlib/block_cipher_mode/block_cipher_mode.h>
+#include <gmlib/block_cipher_mode/internal/ocb_offset.h>
+#include <gmlib/memory_utils/memxor.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace block_cipher_mode {
+
+/**
+ * @brief   OCB mode common part (RFC 7253), TAGLEN = 128
+ * @details L_*, L_$ and L_i are computed once at key setup, the nonce is
+ *          1 ~ 15 bytes and the associated data is hashed at init/reset
+ */
+template <class Cipher, class Derived>
+class OcbCryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, Derived>
+{
+    static_assert(type_traits::is_valid_cipher<Cipher>::value,
+                  "invalid block cipher class");
+    static_assert(Cipher::BLOCK_SIZE == 16, "ocb need BLOCK_SIZE=16");
+
+public:
+    static constexpr std::size_t BLOCK_SIZE   = Cipher::BLOCK_SIZE;
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN;
+
+protected:
+    static constexpr std::size_t L_NUM = 64;
+
+protected:
+    Cipher        cipher_;
+    std::uint8_t  L_star_[16];
+    std::uint8_t  L_dollar_[16];
+    std::uint8_t  L_[L_NUM][16];
+    std::uint8_t  offset_[16];
+    std::uint8_t  checksum_[16];
+    std::uint8_t  sum_[16];
+    std::uint64_t block_index_;
+    // Ktop cache, nonces differing only in the low 6 bits share it
+    std::uint8_t  ktop_nonce_[16];
+    std::uint8_t  ktop_[16];
+    bool          ktop_valid_ = false;
+
+public:
+    OcbCryptor() = default;
+
+protected:
+    void init(const std::uint8_t* user_key,
+              const std::uint8_t* iv,
+              std::size_t         iv_len,
+              const std::uint8_t* aad,
+              std::size_t         aad_len)
+    {
+        static const std::uint8_t ZERO[16] = {0};
+
+        cipher_.set_key(user_key, Cipher::ENCRYPTION);
+        // L_* = E(0), L_$ = double(L_*), L_0 = double(L_$), ...
+        cipher_.encrypt_block(L_star_, ZERO);
+        internal::ocb_double(L_dollar_, L_star_);
+        internal::ocb_double(L_[0], L_dollar_);
+        for (std::size_t i = 1; i < L_NUM; i++)
+        {
+            internal::ocb_double(L_[i], L_[i - 1]);
+        }
+        ktop_valid_ = false;
+        this->reset(iv, iv_len, aad, aad_len);
+    }
+
+    void reset(const std::uint8_t* iv,
+               std::size_t         iv_len,
+               const std::uint8_t* aad,
+               std::size_t         aad_len)
+    {
+        if (iv_len == 0 || iv_len > 15)
+        {
+            throw std::runtime_error("invalid iv len");
+        }
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, Derived>::reset();
+        // Nonce = num2str(TAGLEN mod 128,7) || zeros || 1 || N
+        std::uint8_t nonce[16] = {0};
+        nonce[15 - iv_len]     = 0x01;
+        std::memcpy(nonce + 16 - iv_len, iv, iv_len);
+        unsigned bottom = nonce[15] & 0x3F;
+        nonce[15]       = nonce[15] & 0xC0;
+        if (!ktop_valid_ || std::memcmp(ktop_nonce_, nonce, 16) != 0)
+        {
+            cipher_.encrypt_block(ktop_, nonce);
+            std::memcpy(ktop_nonce_, nonce, 16);
+            ktop_valid_ = true;
+        }
+        // Stretch = Ktop || (Ktop[1..64] xor Ktop[9..72])
+        // Offset_0 = Stretch[1+bottom..128+bottom]
+        std::uint8_t stretch[24 + 1];
+        std::memcpy(stretch, ktop_, 16);
+        memory_utils::memxor<8>(stretch + 16, ktop_, ktop_ + 1);
+        stretch[24]     = 0;
+        unsigned byte_n = bottom / 8, bit_n = bottom % 8;
+        for (std::size_t i = 0; i < 16; i++)
+        {
+            std::uint8_t a = stretch[i + byte_n], b = stretch[i + byte_n + 1];
+            offset_[i] = (bit_n == 0) ? a : (a << bit_n) | (b >> (8 - bit_n));
+        }
+        std::memset(checksum_, 0, 16);
+        block_index_ = 0;
+        this->hash_aad(aad, aad_len);
+    }
+
+    /**
+     * @brief   compute the tag after the last (partial) block
+     */
+    void gen_tag(std::uint8_t tag[16]) const noexcept
+    {
+        // Tag = E(Checksum xor Offset xor L_$) xor HASH(K,A)
+        memory_utils::memxor<16>(tag, checksum_, offset_);
+        memory_utils::memxor<16>(tag, tag, L_dollar_);
+        cipher_.encrypt_block(tag, tag);
+        memory_utils::memxor<16>(tag, tag, sum_);
+    }
+
+    /**
+     * @brief   out = Offset_i xor CIPHER(in xor Offset_i), all blocks of a
+     *          PARALLEL_NUM chunk go through one encrypt_blocks /
+     *          decrypt_blocks call
+     */
+    template <bool ENCRYPT>
+    void crypt_blocks(const Cipher&       cipher,
+                      std::uint8_t*       out,
+                      const std::uint8_t* in,
+                      std::size_t         block_num)
+    {
+        constexpr std::size_t PARALLEL_NUM   = Cipher::PARALLEL_NUM;
+        constexpr std::size_t PARALLEL_BYTES = BLOCK_SIZE * PARALLEL_NUM;
+
+        std::uint8_t offsets[PARALLEL_BYTES], buffer[PARALLEL_BYTES];
+        while (block_num)
+        {
+            std::size_t n = (block_num < PARALLEL_NUM) ? block_num
+                                                       : PARALLEL_NUM;
+            std::size_t size = n * BLOCK_SIZE;
+            internal::ocb_gen_offsets(offsets, offset_, L_, &block_index_, n);
+            memory_utils::memxor_n(buffer, in, offsets, size);
+            if (ENCRYPT)
+            {
+                this->update_checksum(in, n);
+                cipher.encrypt_blocks(buffer, buffer, n);
+                memory_utils::memxor_n(out, buffer, offsets, size);
+            }
+            else
+            {
+                cipher.decrypt_blocks(buffer, buffer, n);
+                memory_utils::memxor_n(out, buffer, offsets, size);
+                this->update_checksum(out, n);
+            }
+            in += size, out += size, block_num -= n;
+        }
+    }
+
+    /**
+     * @brief   final partial block, out = in xor E(Offset xor L_*) and
+     *          Checksum xor= P_* || 1 || 0...
+     */
+    template <bool ENCRYPT>
+    void crypt_partial(std::uint8_t*       out,
+                       const std::uint8_t* in,
+                       std::size_t         inl)
+    {
+        std::uint8_t pad[16], p[16] = {0};
+        memory_utils::memxor<16>(offset_, offset_, L_star_);
+        cipher_.encrypt_block(pad, offset_);
+        if (ENCRYPT)
+        {
+            std::memcpy(p, in, inl);
+        }
+        memory_utils::memxor_n(out, in, pad, inl);
+        if (!ENCRYPT)
+        {
+            std::memcpy(p, out, inl);
+        }
+        p[inl] = 0x80;
+        memory_utils::memxor<16>(checksum_, checksum_, p);
+    }
+
+private:
+    void update_checksum(const std::uint8_t* in, std::size_t block_num)
+    {
+        for (std::size_t i = 0; i < block_num; i++)
+        {
+            memory_utils::memxor<16>(checksum_, checksum_, in + 16 * i);
+        }
+    }
+
+    void hash_aad(const std::uint8_t* aad, std::size_t aad_len)
+    {
+        constexpr std::size_t PARALLEL_NUM   = Cipher::PARALLEL_NUM;
+        constexpr std::size_t PARALLEL_BYTES = BLOCK_SIZE * PARALLEL_NUM;
+
+        std::uint8_t  offset[16] = {0}, offsets[PARALLEL_BYTES];
+        std::uint8_t  buffer[PARALLEL_BYTES];
+        std::uint64_t index = 0;
+        std::size_t   block_num = aad_len / BLOCK_SIZE;
+        std::memset(sum_, 0, 16);
+        while (block_num)
+        {
+            std::size_t n = (block_num < PARALLEL_NUM) ? block_num
+                                                       : PARALLEL_NUM;
+            std::size_t size = n * BLOCK_SIZE;
+            internal::ocb_gen_offsets(offsets, offset, L_, &index, n);
+            memory_utils::memxor_n(buffer, aad, offsets, size);
+            cipher_.encrypt_blocks(buffer, buffer, n);
+            this->update_sum(buffer, n);
+            aad += size, block_num -= n;
+        }
+        aad_len = aad_len % BLOCK_SIZE;
+        if (aad_len)
+        {
+            // Sum xor= E((A_* || 1 || 0...) xor Offset_* )
+            std::uint8_t t[16] = {0};
+            std::memcpy(t, aad, aad_len);
+            t[aad_len] = 0x80;
+            memory_utils::memxor<16>(offset, offset, L_star_);
+            memory_utils::memxor<16>(t, t, offset);
+            cipher_.encrypt_block(t, t);
+            memory_utils::memxor<16>(sum_, sum_, t);
+        }
+    }
+
+    void update_sum(const std::uint8_t* in, std::size_t block_num)
+    {
+        for (std::size_t i = 0; i < block_num; i++)
+        {
+            memory_utils::memxor<16>(sum_, sum_, in + 16 * i);
+        }
+    }
+};
+
+template <class Cipher>
+class OcbEncryptor final
+    : public OcbCryptor<Cipher, OcbEncryptor<Cipher>>
+{
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, OcbEncryptor>;
+
+public:
+    static constexpr const char* NAME_SUFFIX = "/OCB-ENC";
+
+    static constexpr std::size_t NAME_STR_LEN = Cipher::NAME_STR_LEN + 8;
+
+    static constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN;
+
+public:
+    const char* fetch_name() const noexcept override
+    {
+        static char name[NAME_STR_LEN + 1] = {0};
+        static bool inited                 = false;
+        if (inited == false)
+        {
+            char* name_part1 = name;
+            char* name_part2 = name + Cipher::NAME_STR_LEN;
+            std::memcpy(name_part1, Cipher::NAME, Cipher::NAME_STR_LEN);
+            std::memcpy(name_part2, NAME_SUFFIX,
+                        NAME_STR_LEN - Cipher::NAME_STR_LEN);
+            inited = true;
+        }
+        return name;
+    }
+
+    std::size_t fetch_name_str_len() const noexcept override
+    {
+        return NAME_STR_LEN;
+    }
+
+    std::size_t fetch_block_size() const noexcept override
+    {
+        return BLOCK_SIZE;
+    }
+
+    std::size_t fetch_user_key_len() const noexcept override
+    {
+        return USER_KEY_LEN;
+    }
+
+public:
+    std::size_t init(const ConstParameter& params) override
+    {
+        const auto& item_user_key = params.find(ParamKey::USER_KEY);
+        const auto& item_iv       = params.find(ParamKey::IV);
+        const auto& item_aad      = params.find(ParamKey::AAD);
+
+        const std::uint8_t* aad     = nullptr;
+        std::size_t         aad_len = 0;
+
+        std::size_t ret = 0;
+        if (item_user_key == params.end())
+        {
+            throw std::runtime_error("init need user_key");
+        }
+        if (item_user_key->second.second != USER_KEY_LEN)
+        {
+            throw std::runtime_error("invalid user_key len");
+        }
+        if (item_iv == params.end())
+        {
+            throw std::runtime_error("init need iv");
+        }
+        if (item_aad != params.end())
+        {
+            aad     = static_cast<const std::uint8_t*>(item_aad->second.first);
+            aad_len = item_aad->second.second;
+            ret     = ret | ParamKey::AAD;
+        }
+
+        this->init(
+            static_cast<const std::uint8_t*>(item_user_key->second.first), //
+            static_cast<const std::uint8_t*>(item_iv->second.first),       //
+            item_iv->second.second,                                        //
+            aad,                                                           //
+            aad_len                                                        //
+        );
+        return ParamKey::USER_KEY | ParamKey::IV | ret;
+    }
+
+    std::size_t get(const Parameter& params) override
+    {
+        const auto& item_tag = params.find(ParamKey::TAG);
+        std::size_t ret      = 0;
+        if (item_tag != params.end())
+        {
+            if (item_tag->second.second != sizeof(tag_))
+            {
+                throw std::runtime_error("ocb only support tag=16");
+            }
+            this->get_tag(static_cast<std::uint8_t*>(item_tag->second.first));
+            ret = ret | ParamKey::TAG;
+        }
+        return ret;
+    }
+
+private:
+    std::uint8_t tag_[16];
+
+public:
+    OcbEncryptor() = default;
+
+    /**
+     * @param[in]   user_key    Cipher::USER_KEY_LEN bytes
+     * @param[in]   iv          nonce, 1 ~ 15 bytes (12 recommended)
+     * @param[in]   iv_len      nonce length
+     * @param[in]   aad         additional authenticated data
+     * @param[in]   aad_len     additional authenticated data length
+     */
+    OcbEncryptor(const std::uint8_t* user_key,
+                 const std::uint8_t* iv,
+                 std::size_t         iv_len,
+                 const std::uint8_t* aad,
+                 std::size_t         aad_len)
+    {
+        this->init(user_key, iv, iv_len, aad, aad_len);
+    }
+
+public:
+    void init(const std::uint8_t* user_key,
+              const std::uint8_t* iv,
+              std::size_t         iv_len,
+              const std::uint8_t* aad,
+              std::size_t         aad_len)
+    {
+        this->OcbCryptor<Cipher, OcbEncryptor>::init(user_key, iv, iv_len, aad,
+                                                     aad_len);
+        std::memset(tag_, 0, 16);
+    }
+
+    void reset(const std::uint8_t* iv,
+               std::size_t         iv_len,
+               const std::uint8_t* aad,
+               std::size_t         aad_len)
+    {
+        this->OcbCryptor<Cipher, OcbEncryptor>::reset(iv, iv_len, aad, aad_len);
+        std::memset(tag_, 0, 16);
+    }
+
+    void get_tag(std::uint8_t tag[16]) const noexcept
+    {
+        std::memcpy(tag, tag_, 16);
+    }
+
+private:
+    void update_blocks(std::uint8_t*       out,
+                       const std::uint8_t* in,
+                       std::size_t         block_num) override
+    {
+        this->template crypt_blocks<true>(this->cipher_, out, in, block_num);
+    }
+
+    void final_block(std::uint8_t*       out,
+                     const std::uint8_t* in,
+                     std::size_t         inl) override
+    {
+        if (inl)
+        {
+            this->template crypt_partial<true>(out, in, inl);
+        }
+        this->gen_tag(tag_);
+    }
+};
+
+template <class Cipher>
+class OcbDecryptor final
+    : public OcbCryptor<Cipher, OcbDecryptor<Cipher>>
+{
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, OcbDecryptor>;
+
+public:
+    static constexpr const char* NAME_SUFFIX = "/OCB-DEC";
+
+    static constexpr std::size_t NAME_STR_LEN = Cipher::NAME_STR_LEN + 8;
+
+    static constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN;
+
+public:
+    const char* fetch_name() const noexcept override
+    {
+        static char name[NAME_STR_LEN + 1] = {0};
+        static bool inited                 = false;
+        if (inited == false)
+        {
+            char* name_part1 = name;
+            char* name_part2 = name + Cipher::NAME_STR_LEN;
+            std::memcpy(name_part1, Cipher::NAME, Cipher::NAME_STR_LEN);
+            std::memcpy(name_part2, NAME_SUFFIX,
+                        NAME_STR_LEN - Cipher::NAME_STR_LEN);
+            inited = true;
+        }
+        return name;
+    }
+
+    std::size_t fetch_name_str_len() const noexcept override
+    {
+        return NAME_STR_LEN;
+    }
+
+    std::size_t fetch_block_size() const noexcept override
+    {
+        return BLOCK_SIZE;
+    }
+
+    std::size_t fetch_user_key_len() const noexcept override
+    {
+        return USER_KEY_LEN;
+    }
+
+public:
+    std::size_t init(const ConstParameter& params) override
+    {
+        const auto& item_user_key = params.find(ParamKey::USER_KEY);
+        const auto& item_iv       = params.find(ParamKey::IV);
+        const auto& item_aad      = params.find(ParamKey::AAD);
+        const auto& item_tag      = params.find(ParamKey::TAG);
+
+        const std::uint8_t* aad     = nullptr;
+        std::size_t         aad_len = 0;
+
+        std::size_t ret = 0;
+        if (item_user_key == params.end())
+        {
+            throw std::runtime_error("init need user_key");
+        }
+        if (item_user_key->second.second != USER_KEY_LEN)
+        {
+            throw std::runtime_error("invalid user_key len");
+        }
+        if (item_iv == params.end())
+        {
+            throw std::runtime_error("init need iv");
+        }
+        if (item_aad != params.end())
+        {
+            aad     = static_cast<const std::uint8_t*>(item_aad->second.first);
+            aad_len = item_aad->second.second;
+            ret     = ret | ParamKey::AAD;
+        }
+        if (item_tag != params.end())
+        {
+            if (item_tag->second.second != sizeof(tag_))
+            {
+                throw std::runtime_error("ocb only support tag=16");
+            }
+            this->set_tag(
+                static_cast<const std::uint8_t*>(item_tag->second.first));
+            ret = ret | ParamKey::TAG;
+        }
+
+        this->init(
+            static_cast<const std::uint8_t*>(item_user_key->second.first), //
+            static_cast<const std::uint8_t*>(item_iv->second.first),       //
+            item_iv->second.second,                                        //
+            aad,                                                           //
+            aad_len                                                        //
+        );
+        return ParamKey::USER_KEY | ParamKey::IV | ret;
+    }
+
+    std::size_t set(const ConstParameter& params) override
+    {
+        const auto& item_tag = params.find(ParamKey::TAG);
+        std::size_t ret      = 0;
+        if (item_tag != params.end())
+        {
+            if (item_tag->second.second != sizeof(tag_))
+            {
+                throw std::runtime_error("ocb only support tag=16");
+            }
+            this->set_tag(
+                static_cast<const std::uint8_t*>(item_tag->second.first) //
+            );
+            ret = ret | ParamKey::TAG;
+        }
+        return ret;
+    }
+
+private:
+    Cipher       dec_cipher_;
+    std::uint8_t tag_[16] = {0};
+
+public:
+    OcbDecryptor() = default;
+
+    /**
+     * @param[in]   user_key    Cipher::USER_KEY_LEN bytes
+     * @param[in]   iv          nonce, 1 ~ 15 bytes (12 recommended)
+     * @param[in]   iv_len      nonce length
+     * @param[in]   aad         additional authenticated data
+     * @param[in]   aad_len     additional authenticated data length
+     */
+    OcbDecryptor(const std::uint8_t* user_key,
+                 const std::uint8_t* iv,
+                 std::size_t         iv_len,
+                 const std::uint8_t* aad,
+                 std::size_t         aad_len)
+    {
+        this->init(user_key, iv, iv_len, aad, aad_len);
+    }
+
+public:
+    void init(const std::uint8_t* user_key,
+              const std::uint8_t* iv,
+              std::size_t         iv_len,
+              const std::uint8_t* aad,
+              std::size_t         aad_len)
+    {
+        this->OcbCryptor<Cipher, OcbDecryptor>::init(user_key, iv, iv_len, aad,
+                                                     aad_len);
+        dec_cipher_.set_key(user_key, Cipher::DECRYPTION);
+    }
+
+    void reset(const std::uint8_t* iv,
+               std::size_t         iv_len,
+               const std::uint8_t* aad,
+               std::size_t         aad_len)
+    {
+        this->OcbCryptor<Cipher, OcbDecryptor>::reset(iv, iv_len, aad, aad_len);
+        std::memset(tag_, 0, 16);
+    }
+
+    void set_tag(const std::uint8_t tag[16]) noexcept
+    {
+        std::memcpy(tag_, tag, 16);
+    }
+
+private:
+    void update_blocks(std::uint8_t*       out,
+                       const std::uint8_t* in,
+                       std::size_t         block_num) override
+    {
+        this->template crypt_blocks<false>(dec_cipher_, out, in, block_num);
+    }
+
+    void final_block(std::uint8_t*       out,
+                     const std::uint8_t* in,
+                     std::size_t         inl) override
+    {
+        std::uint8_t tag[16];
+        if (inl)
+        {
+            this->template crypt_partial<false>(out, in, inl);
+        }
+        this->gen_tag(tag);
+        if (std::memcmp(tag, tag_, 16) != 0)
+        {
+            throw std::runtime_error("invalid ocb ciphertext");
+        }
+    }
+};
+
+} // namespace block_cipher_mode
+
+#endif
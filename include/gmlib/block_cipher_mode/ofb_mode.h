@@ -2,18 +2,23 @@
 #define BLOCK_CIPHER_MODE_OFB_MODE_H
 
 #include <gmlib/block_cipher_mode/block_cipher_mode.h>
+#include <gmlib/block_cipher_mode/internal/ofb_key_stream.h>
 #include <gmlib/memory_utils/memxor.h>
 
+#include <memory>
 #include <stdexcept>
 
 namespace block_cipher_mode {
 
 template <class Cipher>
-class OfbCryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+class OfbCryptor final
+    : public BlockCipherModeImpl<Cipher::BLOCK_SIZE, OfbCryptor<Cipher>>
 {
     static_assert(type_traits::is_valid_cipher<Cipher>::value,
                   "invalid block cipher class");
 
+    friend class BlockCipherModeImpl<Cipher::BLOCK_SIZE, OfbCryptor>;
+
 public:
     static constexpr const char* NAME_SUFFIX = "/OFB";
 
@@ -88,6 +93,9 @@ private:
     Cipher       cipher_;
     std::uint8_t iv_[Cipher::BLOCK_SIZE];
 
+    /// @brief key stream filled ahead by a helper thread, see precompute
+    std::unique_ptr<internal::OfbKeyStreamRing<Cipher>> ring_;
+
 public:
     OfbCryptor() = default;
 
@@ -99,16 +107,49 @@ public:
 public:
     void init(const std::uint8_t* user_key, const std::uint8_t* iv)
     {
+        if (ring_)
+        {
+            ring_->stop();
+        }
         cipher_.set_key(user_key, Cipher::ENCRYPTION);
         std::memcpy(iv_, iv, Cipher::BLOCK_SIZE);
     }
 
     void reset(const std::uint8_t* iv) noexcept
     {
-        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        if (ring_)
+        {
+            ring_->stop();
+        }
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE, OfbCryptor>::reset();
         std::memcpy(iv_, iv, Cipher::BLOCK_SIZE);
     }
 
+    /**
+     * @brief               generate key stream ahead on a helper thread
+     * @details             the key stream of OFB only depends on key and iv,
+     *                      so it can be filled before the data arrives. The
+     *                      following update/do_final calls consume it first
+     *                      and fall back to inline generation after.
+     * @param[in] block_num number of key stream blocks to precompute
+     */
+    void precompute(std::size_t block_num)
+    {
+        if (ring_ && ring_->remain())
+        {
+            throw std::runtime_error("ofb key stream precompute in progress");
+        }
+        if (block_num == 0)
+        {
+            return;
+        }
+        if (!ring_)
+        {
+            ring_.reset(new internal::OfbKeyStreamRing<Cipher>());
+        }
+        ring_->start(cipher_, iv_, block_num);
+    }
+
 private:
     void gen_key_stream(std::uint8_t* out, std::size_t block_num)
     {
@@ -129,14 +170,34 @@ private:
                        const std::uint8_t* in,
                        std::size_t         block_num) override
     {
-        constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+        constexpr std::size_t BLOCK_SIZE  = Cipher::BLOCK_SIZE;
+        constexpr std::size_t BATCH_NUM   = internal::OFB_KEY_STREAM_BATCH;
+        constexpr std::size_t BATCH_BYTES = BLOCK_SIZE * BATCH_NUM;
 
-        std::uint8_t key_stream[BLOCK_SIZE];
-        while (block_num)
+        if (ring_ && ring_->remain())
         {
-            this->gen_key_stream(key_stream, 1);
-            memory_utils::memxor<BLOCK_SIZE>(out, in, key_stream);
-            in += BLOCK_SIZE, out += BLOCK_SIZE, block_num--;
+            std::size_t n = ring_->remain();
+            if (n > block_num)
+            {
+                n = block_num;
+            }
+            ring_->consume(out, in, n * BLOCK_SIZE, iv_);
+            in += n * BLOCK_SIZE, out += n * BLOCK_SIZE, block_num -= n;
+        }
+
+        alignas(64) std::uint8_t key_stream[BATCH_BYTES];
+        while (block_num >= BATCH_NUM)
+        {
+            this->gen_key_stream(key_stream, BATCH_NUM);
+            memory_utils::memxor<BATCH_BYTES>(out, in, key_stream);
+            in += BATCH_BYTES, out += BATCH_BYTES;
+            block_num -= BATCH_NUM;
+        }
+        if (block_num)
+        {
+            std::size_t remain_bytes = block_num * BLOCK_SIZE;
+            this->gen_key_stream(key_stream, block_num);
+            memory_utils::memxor_n(out, in, key_stream, remain_bytes);
         }
     }
 
@@ -150,6 +211,11 @@ private:
         {
             return;
         }
+        if (ring_ && ring_->remain())
+        {
+            ring_->consume(out, in, inl, iv_);
+            return;
+        }
         std::uint8_t key_stream[BLOCK_SIZE];
         this->gen_key_stream(key_stream, 1);
         memory_utils::memxor_n(out, in, key_stream, inl);
@@ -0,0 +1,503 @@
+#ifndef BLOCK_CIPHER_MODE_XTS_MODE_H
+#define BLOCK_CIPHER_MODE_XTS_MODE_H
+
+#include <gmlib/block_cipher_mode/block_cipher_mode.h>
+#include <gmlib/block_cipher_mode/internal/xts_mul.h>
+#include <gmlib/memory_utils/endian.h>
+#include <gmlib/memory_utils/memxor.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace block_cipher_mode {
+
+/**
+ * @brief   XTS mode common part (IEEE P1619), with ciphertext stealing
+ * @details user_key = key1 || key2, key1 crypts the data and key2 encrypts
+ *          the iv (data unit number) into the initial tweak
+ */
+template <class Cipher>
+class XtsCryptor : public BlockCipherModeImpl<Cipher::BLOCK_SIZE>
+{
+    static_assert(type_traits::is_valid_cipher<Cipher>::value,
+                  "invalid block cipher class");
+    static_assert(Cipher::BLOCK_SIZE == 16, "xts need BLOCK_SIZE=16");
+
+public:
+    static constexpr std::size_t BLOCK_SIZE   = Cipher::BLOCK_SIZE;
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN * 2;
+
+protected:
+    Cipher       cipher_;
+    Cipher       tweak_cipher_;
+    int          enc_;
+    std::uint8_t tweak_[16];
+    std::uint8_t xts_buf_[2 * 16];
+    std::size_t  xts_buf_size_;
+
+protected:
+    XtsCryptor() noexcept : enc_(Cipher::ENCRYPTION), xts_buf_size_(0)
+    {
+    }
+
+    void init(const std::uint8_t* user_key, const std::uint8_t* iv, int enc)
+    {
+        enc_ = enc;
+        cipher_.set_key(user_key, enc);
+        tweak_cipher_.set_key(user_key + Cipher::USER_KEY_LEN,
+                              Cipher::ENCRYPTION);
+        this->reset(iv);
+    }
+
+public:
+    void reset(const std::uint8_t* iv) noexcept
+    {
+        this->BlockCipherModeImpl<Cipher::BLOCK_SIZE>::reset();
+        tweak_cipher_.encrypt_block(tweak_, iv);
+        xts_buf_size_ = 0;
+    }
+
+    /**
+     * @brief               crypt one data unit (sector)
+     * @param[out]  out     output, len bytes
+     * @param[in]   in      input, len bytes
+     * @param[in]   len     data unit length, not less than BLOCK_SIZE
+     * @param[in]   iv      16-bytes data unit number (tweak before key2)
+     * @note                const, does not touch the update/do_final state
+     */
+    void crypt_sector(std::uint8_t*       out,
+                      const std::uint8_t* in,
+                      std::size_t         len,
+                      const std::uint8_t  iv[16]) const
+    {
+        std::uint8_t tweak[16];
+        tweak_cipher_.encrypt_block(tweak, iv);
+        this->crypt_unit(out, in, len, tweak);
+    }
+
+    /**
+     * @brief                   crypt consecutive data units (sectors),
+     *                          the data unit number of sector i is
+     *                          sector_index + i, 128-bit little endian
+     * @param[out]  out         output, sector_size x sector_num bytes
+     * @param[in]   in          input, sector_size x sector_num bytes
+     * @param[in]   sector_size data unit length, not less than BLOCK_SIZE
+     * @param[in]   sector_num  data unit number
+     * @param[in]   sector_index    data unit number of the first sector
+     * @note                    const, does not touch the update/do_final
+     *                          state
+     */
+    void crypt_sectors(std::uint8_t*       out,
+                       const std::uint8_t* in,
+                       std::size_t         sector_size,
+                       std::size_t         sector_num,
+                       std::uint64_t       sector_index) const
+    {
+        constexpr std::size_t PARALLEL_NUM = Cipher::PARALLEL_NUM;
+
+        if (sector_size < BLOCK_SIZE)
+        {
+            throw std::runtime_error("xts data unit shorter than a block");
+        }
+        std::uint8_t  tweaks[16 * PARALLEL_NUM];
+        std::uint64_t index_hi = 0;
+        while (sector_num)
+        {
+            std::size_t n = (sector_num < PARALLEL_NUM) ? sector_num
+                                                        : PARALLEL_NUM;
+            // encrypt data unit numbers in parallel
+            for (std::size_t i = 0; i < n; i++)
+            {
+                std::uint64_t lo = sector_index + i;
+                std::uint64_t hi = index_hi + ((lo < sector_index) ? 1 : 0);
+                memory_utils::store64_le(tweaks + 16 * i + 0, lo);
+                memory_utils::store64_le(tweaks + 16 * i + 8, hi);
+            }
+            tweak_cipher_.encrypt_blocks(tweaks, tweaks, n);
+            for (std::size_t i = 0; i < n; i++)
+            {
+                this->crypt_unit(out, in, sector_size, tweaks + 16 * i);
+                out += sector_size, in += sector_size;
+            }
+            if (sector_index + n < sector_index)
+            {
+                index_hi++;
+            }
+            sector_index += n, sector_num -= n;
+        }
+    }
+
+public:
+    /**
+     * @brief   the last full block is held back until do_final, because
+     *          ciphertext stealing rewrites it if a partial block follows
+     */
+    void update(std::uint8_t*       out,
+                std::size_t*        outl,
+                const std::uint8_t* in,
+                std::size_t         inl) override
+    {
+        if (inl == 0)
+        {
+            *outl = 0;
+            return;
+        }
+        std::uint8_t* out_base = out;
+        if (xts_buf_size_ >= BLOCK_SIZE && xts_buf_size_ + inl >= 2 * 16)
+        {
+            this->crypt_blocks(out, xts_buf_, 1, tweak_);
+            xts_buf_size_ -= BLOCK_SIZE, out += BLOCK_SIZE;
+            std::memmove(xts_buf_, xts_buf_ + BLOCK_SIZE, xts_buf_size_);
+        }
+        if (xts_buf_size_ + inl < 2 * BLOCK_SIZE)
+        {
+            std::memcpy(xts_buf_ + xts_buf_size_, in, inl);
+            xts_buf_size_ += inl, *outl = (std::size_t)(out - out_base);
+            return;
+        }
+        if (xts_buf_size_)
+        {
+            std::size_t size = BLOCK_SIZE - xts_buf_size_;
+            std::memcpy(xts_buf_ + xts_buf_size_, in, size);
+            in += size, inl -= size;
+            this->crypt_blocks(out, xts_buf_, 1, tweak_);
+            xts_buf_size_ = 0, out += BLOCK_SIZE;
+        }
+        if (inl >= 2 * BLOCK_SIZE)
+        {
+            std::size_t block_num = inl / BLOCK_SIZE - 1;
+            this->crypt_blocks(out, in, block_num, tweak_);
+            out += block_num * BLOCK_SIZE;
+            in += block_num * BLOCK_SIZE, inl -= block_num * BLOCK_SIZE;
+        }
+        std::memcpy(xts_buf_, in, inl);
+        xts_buf_size_ = inl, *outl = (std::size_t)(out - out_base);
+    }
+
+    void do_final(std::uint8_t*       out,
+                  std::size_t*        outl,
+                  const std::uint8_t* in  = nullptr,
+                  std::size_t         inl = 0) override
+    {
+        this->XtsCryptor::update(out, outl, in, inl);
+        out += *outl;
+        this->XtsCryptor::final_block(out, xts_buf_, xts_buf_size_);
+        *outl += xts_buf_size_;
+        xts_buf_size_ = 0;
+    }
+
+protected:
+    /**
+     * @brief   crypt block_num full blocks, tweak is updated
+     */
+    void crypt_blocks(std::uint8_t*       out,
+                      const std::uint8_t* in,
+                      std::size_t         block_num,
+                      std::uint8_t        tweak[16]) const
+    {
+        constexpr std::size_t PARALLEL_NUM   = Cipher::PARALLEL_NUM;
+        constexpr std::size_t PARALLEL_BYTES = BLOCK_SIZE * PARALLEL_NUM;
+
+        std::uint8_t T[PARALLEL_BYTES], buffer[PARALLEL_BYTES];
+        while (block_num >= PARALLEL_NUM)
+        {
+            internal::xts_gen_tweaks(T, tweak, PARALLEL_NUM);
+            memory_utils::memxor<PARALLEL_BYTES>(buffer, in, T);
+            this->crypt_n(buffer, buffer, PARALLEL_NUM);
+            memory_utils::memxor<PARALLEL_BYTES>(out, buffer, T);
+            in += PARALLEL_BYTES, out += PARALLEL_BYTES;
+            block_num -= PARALLEL_NUM;
+        }
+        if (block_num)
+        {
+            std::size_t remain_bytes = block_num * BLOCK_SIZE;
+            internal::xts_gen_tweaks(T, tweak, block_num);
+            memory_utils::memxor_n(buffer, in, T, remain_bytes);
+            this->crypt_n(buffer, buffer, block_num);
+            memory_utils::memxor_n(out, buffer, T, remain_bytes);
+        }
+    }
+
+    /**
+     * @brief   crypt the last BLOCK_SIZE <= inl < 2 x BLOCK_SIZE bytes,
+     *          with ciphertext stealing when inl != BLOCK_SIZE
+     */
+    void crypt_tail(std::uint8_t*       out,
+                    const std::uint8_t* in,
+                    std::size_t         inl,
+                    std::uint8_t        tweak[16]) const
+    {
+        std::size_t r = inl - BLOCK_SIZE;
+        if (r == 0)
+        {
+            this->crypt_blocks(out, in, 1, tweak);
+            return;
+        }
+        // enc: CC = E(P[m-1], T[m-1]), C[m-1] = E(P[m] || CC[r:], T[m])
+        // dec: PP = D(C[m-1], T[m]),   P[m-1] = D(C[m] || PP[r:], T[m-1])
+        std::uint8_t T[2 * 16], head[BLOCK_SIZE], last[BLOCK_SIZE];
+        internal::xts_gen_tweaks(T, tweak, 2);
+        std::uint8_t* first_tweak = (enc_ == Cipher::ENCRYPTION) ? T : T + 16;
+        std::uint8_t* last_tweak  = (enc_ == Cipher::ENCRYPTION) ? T + 16 : T;
+
+        std::memcpy(last, in + BLOCK_SIZE, r);
+        memory_utils::memxor<BLOCK_SIZE>(head, in, first_tweak);
+        this->crypt_n(head, head, 1);
+        memory_utils::memxor<BLOCK_SIZE>(head, head, first_tweak);
+        std::memcpy(last + r, head + r, BLOCK_SIZE - r);
+        std::memcpy(out + BLOCK_SIZE, head, r);
+        memory_utils::memxor<BLOCK_SIZE>(last, last, last_tweak);
+        this->crypt_n(last, last, 1);
+        memory_utils::memxor<BLOCK_SIZE>(out, last, last_tweak);
+    }
+
+private:
+    void crypt_n(std::uint8_t*       out,
+                 const std::uint8_t* in,
+                 std::size_t         block_num) const
+    {
+        if (enc_ == Cipher::ENCRYPTION)
+        {
+            cipher_.encrypt_blocks(out, in, block_num);
+        }
+        else
+        {
+            cipher_.decrypt_blocks(out, in, block_num);
+        }
+    }
+
+    void crypt_unit(std::uint8_t*       out,
+                    const std::uint8_t* in,
+                    std::size_t         len,
+                    std::uint8_t        tweak[16]) const
+    {
+        if (len < BLOCK_SIZE)
+        {
+            throw std::runtime_error("xts data unit shorter than a block");
+        }
+        std::size_t block_num = len / BLOCK_SIZE;
+        if (len % BLOCK_SIZE)
+        {
+            block_num--;
+        }
+        this->crypt_blocks(out, in, block_num, tweak);
+        std::size_t size = block_num * BLOCK_SIZE;
+        if (size != len)
+        {
+            this->crypt_tail(out + size, in + size, len - size, tweak);
+        }
+    }
+
+    void update_blocks(std::uint8_t*       out,
+                       const std::uint8_t* in,
+                       std::size_t         block_num) override
+    {
+        this->crypt_blocks(out, in, block_num, tweak_);
+    }
+
+    void final_block(std::uint8_t*       out,
+                     const std::uint8_t* in,
+                     std::size_t         inl) override
+    {
+        if (inl == 0)
+        {
+            return;
+        }
+        if (inl < BLOCK_SIZE)
+        {
+            throw std::runtime_error("input data length in XTS mode needs "
+                                     "to be at least BLOCK_SIZE");
+        }
+        this->crypt_tail(out, in, inl, tweak_);
+    }
+};
+
+template <class Cipher>
+class XtsEncryptor final : public XtsCryptor<Cipher>
+{
+public:
+    static constexpr const char* NAME_SUFFIX = "/XTS-ENC";
+
+    static constexpr std::size_t NAME_STR_LEN = Cipher::NAME_STR_LEN + 8;
+
+    static constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN * 2;
+
+public:
+    const char* fetch_name() const noexcept override
+    {
+        static char name[NAME_STR_LEN + 1] = {0};
+        static bool inited                 = false;
+        if (inited == false)
+        {
+            char* name_part1 = name;
+            char* name_part2 = name + Cipher::NAME_STR_LEN;
+            std::memcpy(name_part1, Cipher::NAME, Cipher::NAME_STR_LEN);
+            std::memcpy(name_part2, NAME_SUFFIX,
+                        NAME_STR_LEN - Cipher::NAME_STR_LEN);
+            inited = true;
+        }
+        return name;
+    }
+
+    std::size_t fetch_name_str_len() const noexcept override
+    {
+        return NAME_STR_LEN;
+    }
+
+    std::size_t fetch_block_size() const noexcept override
+    {
+        return BLOCK_SIZE;
+    }
+
+    std::size_t fetch_user_key_len() const noexcept override
+    {
+        return USER_KEY_LEN;
+    }
+
+public:
+    std::size_t init(const ConstParameter& params) override
+    {
+        const auto& item_user_key = params.find(ParamKey::USER_KEY);
+        const auto& item_iv       = params.find(ParamKey::IV);
+
+        if (item_user_key == params.end())
+        {
+            throw std::runtime_error("init need user_key");
+        }
+        if (item_user_key->second.second != USER_KEY_LEN)
+        {
+            throw std::runtime_error("invalid user_key len");
+        }
+        if (item_iv == params.end())
+        {
+            throw std::runtime_error("init need iv");
+        }
+        if (item_iv->second.second != BLOCK_SIZE)
+        {
+            throw std::runtime_error("invalid iv len");
+        }
+
+        this->init(
+            static_cast<const std::uint8_t*>(item_user_key->second.first), //
+            static_cast<const std::uint8_t*>(item_iv->second.first)        //
+        );
+        return ParamKey::USER_KEY | ParamKey::IV;
+    }
+
+public:
+    XtsEncryptor() = default;
+
+    /**
+     * @param[in]   user_key    key1 || key2, 2 x Cipher::USER_KEY_LEN bytes
+     * @param[in]   iv          16-bytes data unit number
+     */
+    XtsEncryptor(const std::uint8_t* user_key, const std::uint8_t* iv)
+    {
+        this->init(user_key, iv);
+    }
+
+public:
+    void init(const std::uint8_t* user_key, const std::uint8_t* iv)
+    {
+        this->XtsCryptor<Cipher>::init(user_key, iv, Cipher::ENCRYPTION);
+    }
+};
+
+template <class Cipher>
+class XtsDecryptor final : public XtsCryptor<Cipher>
+{
+public:
+    static constexpr const char* NAME_SUFFIX = "/XTS-DEC";
+
+    static constexpr std::size_t NAME_STR_LEN = Cipher::NAME_STR_LEN + 8;
+
+    static constexpr std::size_t BLOCK_SIZE = Cipher::BLOCK_SIZE;
+
+    static constexpr std::size_t USER_KEY_LEN = Cipher::USER_KEY_LEN * 2;
+
+public:
+    const char* fetch_name() const noexcept override
+    {
+        static char name[NAME_STR_LEN + 1] = {0};
+        static bool inited                 = false;
+        if (inited == false)
+        {
+            char* name_part1 = name;
+            char* name_part2 = name + Cipher::NAME_STR_LEN;
+            std::memcpy(name_part1, Cipher::NAME, Cipher::NAME_STR_LEN);
+            std::memcpy(name_part2, NAME_SUFFIX,
+                        NAME_STR_LEN - Cipher::NAME_STR_LEN);
+            inited = true;
+        }
+        return name;
+    }
+
+    std::size_t fetch_name_str_len() const noexcept override
+    {
+        return NAME_STR_LEN;
+    }
+
+    std::size_t fetch_block_size() const noexcept override
+    {
+        return BLOCK_SIZE;
+    }
+
+    std::size_t fetch_user_key_len() const noexcept override
+    {
+        return USER_KEY_LEN;
+    }
+
+public:
+    std::size_t init(const ConstParameter& params) override
+    {
+        const auto& item_user_key = params.find(ParamKey::USER_KEY);
+        const auto& item_iv       = params.find(ParamKey::IV);
+
+        if (item_user_key == params.end())
+        {
+            throw std::runtime_error("init need user_key");
+        }
+        if (item_user_key->second.second != USER_KEY_LEN)
+        {
+            throw std::runtime_error("invalid user_key len");
+        }
+        if (item_iv == params.end())
+        {
+            throw std::runtime_error("init need iv");
+        }
+        if (item_iv->second.second != BLOCK_SIZE)
+        {
+            throw std::runtime_error("invalid iv len");
+        }
+
+        this->init(
+            static_cast<const std::uint8_t*>(item_user_key->second.first), //
+            static_cast<const std::uint8_t*>(item_iv->second.first)        //
+        );
+        return ParamKey::USER_KEY | ParamKey::IV;
+    }
+
+public:
+    XtsDecryptor() = default;
+
+    /**
+     * @param[in]   user_key    key1 || key2, 2 x Cipher::USER_KEY_LEN bytes
+     * @param[in]   iv          16-bytes data unit number
+     */
+    XtsDecryptor(const std::uint8_t* user_key, const std::uint8_t* iv)
+    {
+        this->init(user_key, iv);
+    }
+
+public:
+    void init(const std::uint8_t* user_key, const std::uint8_t* iv)
+    {
+        this->XtsCryptor<Cipher>::init(user_key, iv, Cipher::DECRYPTION);
+    }
+};
+
+} // namespace block_cipher_mode
+
+#endif
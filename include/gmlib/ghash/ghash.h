@@ -18,8 +18,10 @@ namespace alg = ghash::internal::lut256;
 
 namespace ghash {
 
-class GHash : public hash_lib::HashImpl<alg::GHASH_BLOCK_SIZE>
+class GHash final : public hash_lib::HashImpl<alg::GHASH_BLOCK_SIZE, GHash>
 {
+    friend class hash_lib::HashImpl<alg::GHASH_BLOCK_SIZE, GHash>;
+
 public:
     static constexpr const char* NAME         = "GHash";
     static constexpr std::size_t NAME_STR_LEN = 5;
@@ -2,13 +2,22 @@
 #define HASH_LIB_HASH_H
 
 #include <gmlib/hash_lib/abc.h>
+#include <gmlib/memory_utils/iovec.h>
 
 #include <cstdio>
 #include <cstdlib>
+#include <type_traits>
 
 namespace hash_lib {
 
-template <std::size_t _BLOCK_SIZE>
+/**
+ * @brief   common buffering of hash algorithms
+ * @details with Derived = void, update_blocks / final_block are reached
+ *          through the vtable. A hash passing itself as Derived (CRTP) gets
+ *          direct, inlinable calls instead; the abc::Hash interface is
+ *          still there for type-erased use.
+ */
+template <std::size_t _BLOCK_SIZE, class Derived = void>
 class HashImpl : public abc::Hash
 {
 public:
@@ -38,6 +47,21 @@ protected:
 
     inline void reset() noexcept override;
 
+    /**
+     * @brief   input buffered until a block is complete
+     * @return  buffered_size() bytes, less than BLOCK_SIZE
+     */
+    inline const std::uint8_t* buffered_data() const noexcept;
+
+    inline std::size_t buffered_size() const noexcept;
+
+    /**
+     * @brief           replace the buffered input, used to restore a state
+     * @param[in]   in  input data, inl < BLOCK_SIZE
+     * @param[in]   inl input length (in bytes)
+     */
+    inline void set_buffered(const std::uint8_t* in, std::size_t inl) noexcept;
+
 public:
     inline void update(const std::uint8_t* in, std::size_t inl) override;
 
@@ -45,6 +69,15 @@ public:
                          const std::uint8_t* in  = nullptr,
                          std::size_t         inl = 0) override;
 
+    /**
+     * @brief               update with a scatter/gather input, fragments
+     *                      are hashed in place and only a block split
+     *                      across fragments goes through the buffer
+     * @param[in]   in      input fragments
+     * @param[in]   in_num  fragment number
+     */
+    inline void update_v(const memory_utils::IoVec* in, std::size_t in_num);
+
 private:
     virtual void update_blocks(const std::uint8_t* in,
                                std::size_t         block_num) = 0;
@@ -52,6 +85,16 @@ private:
     virtual void final_block(std::uint8_t*       digest,
                              const std::uint8_t* in,
                              std::size_t         inl) = 0;
+
+private:
+    inline void dispatch_update(const std::uint8_t* in, std::size_t inl);
+
+    inline void dispatch_update_blocks(const std::uint8_t* in,
+                                       std::size_t         block_num);
+
+    inline void dispatch_final_block(std::uint8_t*       digest,
+                                     const std::uint8_t* in,
+                                     std::size_t         inl);
 };
 
 // ======================
@@ -62,32 +105,33 @@ private:
                 __FILE__, __FUNCTION__, __LINE__);                      \
     std::exit(exit_code)
 
-template <std::size_t BLOCK_SIZE>
-const char* HashImpl<BLOCK_SIZE>::fetch_name() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+const char* HashImpl<BLOCK_SIZE, Derived>::fetch_name() const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t HashImpl<BLOCK_SIZE>::fetch_name_str_len() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t HashImpl<BLOCK_SIZE, Derived>::fetch_name_str_len() const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t HashImpl<BLOCK_SIZE>::fetch_block_size() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t HashImpl<BLOCK_SIZE, Derived>::fetch_block_size() const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t HashImpl<BLOCK_SIZE>::fetch_digest_size() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t HashImpl<BLOCK_SIZE, Derived>::fetch_digest_size() const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
 
-template <std::size_t BLOCK_SIZE>
-std::size_t HashImpl<BLOCK_SIZE>::fetch_security_strength() const noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t HashImpl<BLOCK_SIZE, Derived>::fetch_security_strength()
+    const noexcept
 {
     PRINT_ERR_AND_EXIT(-1);
 }
@@ -96,19 +140,41 @@ std::size_t HashImpl<BLOCK_SIZE>::fetch_security_strength() const noexcept
 
 // ==========================
 
-template <std::size_t BLOCK_SIZE>
-HashImpl<BLOCK_SIZE>::HashImpl() noexcept : buf_size_(0)
+template <std::size_t BLOCK_SIZE, class Derived>
+HashImpl<BLOCK_SIZE, Derived>::HashImpl() noexcept : buf_size_(0)
 {
 }
 
-template <std::size_t BLOCK_SIZE>
-void HashImpl<BLOCK_SIZE>::reset() noexcept
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::reset() noexcept
 {
     buf_size_ = 0;
 }
 
-template <std::size_t BLOCK_SIZE>
-void HashImpl<BLOCK_SIZE>::update(const std::uint8_t* in, std::size_t inl)
+template <std::size_t BLOCK_SIZE, class Derived>
+const std::uint8_t* HashImpl<BLOCK_SIZE, Derived>::buffered_data()
+    const noexcept
+{
+    return buf_;
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+std::size_t HashImpl<BLOCK_SIZE, Derived>::buffered_size() const noexcept
+{
+    return buf_size_;
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::set_buffered(const std::uint8_t* in,
+                                                 std::size_t inl) noexcept
+{
+    std::memcpy(buf_, in, inl);
+    buf_size_ = inl;
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::update(const std::uint8_t* in,
+                                           std::size_t         inl)
 {
     if (inl == 0)
     {
@@ -117,7 +183,7 @@ void HashImpl<BLOCK_SIZE>::update(const std::uint8_t* in, std::size_t inl)
     if (buf_size_ == 0)
     {
         std::size_t block_num = inl / BLOCK_SIZE;
-        this->update_blocks(in, block_num);
+        this->dispatch_update_blocks(in, block_num);
         in += block_num * BLOCK_SIZE, inl -= block_num * BLOCK_SIZE;
         if (inl)
         {
@@ -138,14 +204,14 @@ void HashImpl<BLOCK_SIZE>::update(const std::uint8_t* in, std::size_t inl)
 
         if (buf_size_ == BLOCK_SIZE)
         {
-            this->update_blocks(buf_, 1);
+            this->dispatch_update_blocks(buf_, 1);
             buf_size_ = 0;
         }
     }
     if (inl && buf_size_ == 0)
     {
-        std::size_t block_num = inl / 64;
-        this->update_blocks(in, block_num);
+        std::size_t block_num = inl / BLOCK_SIZE;
+        this->dispatch_update_blocks(in, block_num);
         in += block_num * BLOCK_SIZE, inl -= block_num * BLOCK_SIZE;
         if (inl)
         {
@@ -157,13 +223,70 @@ void HashImpl<BLOCK_SIZE>::update(const std::uint8_t* in, std::size_t inl)
     return;
 }
 
-template <std::size_t BLOCK_SIZE>
-void HashImpl<BLOCK_SIZE>::do_final(std::uint8_t*       digest,
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::do_final(std::uint8_t*       digest,
                                     const std::uint8_t* in,
                                     std::size_t         inl)
 {
-    this->update(in, inl);
-    this->final_block(digest, buf_, buf_size_);
+    this->dispatch_update(in, inl);
+    this->dispatch_final_block(digest, buf_, buf_size_);
+    buf_size_ = 0;
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::update_v(const memory_utils::IoVec* in,
+                                             std::size_t in_num)
+{
+    for (std::size_t i = 0; i < in_num; i++)
+    {
+        this->dispatch_update(static_cast<const std::uint8_t*>(in[i].iov_base),
+                              in[i].iov_len);
+    }
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::dispatch_update(const std::uint8_t* in,
+                                                    std::size_t         inl)
+{
+    if constexpr (std::is_void<Derived>::value)
+    {
+        this->update(in, inl);
+    }
+    else
+    {
+        static_cast<Derived*>(this)->Derived::update(in, inl);
+    }
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::dispatch_update_blocks(
+    const std::uint8_t* in,
+    std::size_t         block_num)
+{
+    if constexpr (std::is_void<Derived>::value)
+    {
+        this->update_blocks(in, block_num);
+    }
+    else
+    {
+        static_cast<Derived*>(this)->Derived::update_blocks(in, block_num);
+    }
+}
+
+template <std::size_t BLOCK_SIZE, class Derived>
+void HashImpl<BLOCK_SIZE, Derived>::dispatch_final_block(
+    std::uint8_t*       digest,
+    const std::uint8_t* in,
+    std::size_t         inl)
+{
+    if constexpr (std::is_void<Derived>::value)
+    {
+        this->final_block(digest, in, inl);
+    }
+    else
+    {
+        static_cast<Derived*>(this)->Derived::final_block(digest, in, inl);
+    }
 }
 
 } // namespace hash_lib
@@ -0,0 +1,93 @@
+#ifndef HASH_LIB_HKDF_H
+#define HASH_LIB_HKDF_H
+
+#include <gmlib/hash_lib/hmac.h>
+#include <gmlib/memory_utils/memzero.h>
+
+#include <stdexcept>
+
+namespace hash_lib {
+
+/**
+ * @brief                   HKDF-Extract (RFC 5869)
+ * @param[out]  prk         Hash::DIGEST_SIZE bytes pseudorandom key
+ * @param[in]   salt        optional salt, nullptr for none
+ * @param[in]   salt_len    salt length (in bytes)
+ * @param[in]   ikm         input keying material
+ * @param[in]   ikm_len     input keying material length (in bytes)
+ */
+template <class Hash>
+void hkdf_extract(std::uint8_t*       prk,
+                  const std::uint8_t* salt,
+                  std::size_t         salt_len,
+                  const std::uint8_t* ikm,
+                  std::size_t         ikm_len)
+{
+    // no salt is HashLen zero bytes, the same HMAC key as an empty one
+    HMac<Hash> hmac(salt, (salt == nullptr) ? 0 : salt_len);
+    hmac.do_final(prk, ikm, ikm_len);
+}
+
+/**
+ * @brief                   HKDF-Expand (RFC 5869)
+ * @param[out]  okm         output keying material
+ * @param[in]   okm_len     output length, at most 255 x Hash::DIGEST_SIZE
+ * @param[in]   prk         pseudorandom key
+ * @param[in]   prk_len     pseudorandom key length (in bytes)
+ * @param[in]   info        context information
+ * @param[in]   info_len    context information length (in bytes)
+ */
+template <class Hash>
+void hkdf_expand(std::uint8_t*       okm,
+                 std::size_t         okm_len,
+                 const std::uint8_t* prk,
+                 std::size_t         prk_len,
+                 const std::uint8_t* info,
+                 std::size_t         info_len)
+{
+    constexpr std::size_t DIGEST_SIZE = Hash::DIGEST_SIZE;
+    if (okm_len > 255 * DIGEST_SIZE)
+    {
+        throw std::runtime_error("invalid hkdf output length");
+    }
+
+    HMac<Hash>   hmac(prk, prk_len);
+    std::uint8_t T[DIGEST_SIZE];
+    for (std::uint8_t i = 1; okm_len != 0; i++)
+    {
+        if (i != 1)
+        {
+            hmac.update(T, DIGEST_SIZE);
+        }
+        hmac.update(info, info_len);
+        hmac.do_final(T, &i, 1);
+        std::size_t size = (okm_len < DIGEST_SIZE) ? okm_len : DIGEST_SIZE;
+        std::memcpy(okm, T, size);
+        okm += size, okm_len -= size;
+    }
+    memory_utils::memzero(T, sizeof(T));
+}
+
+/**
+ * @brief                   HKDF, Extract then Expand (RFC 5869)
+ * @see                     hkdf_extract, hkdf_expand
+ */
+template <class Hash>
+void hkdf(std::uint8_t*       okm,
+          std::size_t         okm_len,
+          const std::uint8_t* ikm,
+          std::size_t         ikm_len,
+          const std::uint8_t* salt,
+          std::size_t         salt_len,
+          const std::uint8_t* info,
+          std::size_t         info_len)
+{
+    std::uint8_t prk[Hash::DIGEST_SIZE];
+    hkdf_extract<Hash>(prk, salt, salt_len, ikm, ikm_len);
+    hkdf_expand<Hash>(okm, okm_len, prk, sizeof(prk), info, info_len);
+    memory_utils::memzero(prk, sizeof(prk));
+}
+
+} // namespace hash_lib
+
+#endif
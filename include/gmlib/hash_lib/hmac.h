@@ -2,6 +2,8 @@
 #define HASH_LIB_HMAC_H
 
 #include <gmlib/hash_lib/abc.h>
+#include <gmlib/memory_utils/iovec.h>
+#include <gmlib/memory_utils/memzero.h>
 
 namespace hash_lib {
 
@@ -15,8 +17,9 @@ public:
     static constexpr std::size_t DIGEST_SIZE = Hash::DIGEST_SIZE;
 
 private:
-    std::uint8_t K_[Hash::BLOCK_SIZE];
-    Hash         h_;
+    Hash inner_; // state after K ^ ipad
+    Hash outer_; // state after K ^ opad
+    Hash h_;
 
 public:
     HMac() = default;
@@ -27,31 +30,54 @@ public:
     }
 
 public:
+    /**
+     * @brief               set the key, the inner and outer pad blocks are
+     *                      hashed once here and their states kept
+     */
     void set_key(const std::uint8_t* key, std::size_t key_len)
     {
-        h_.reset();
-        std::memset(K_, 0, Hash::BLOCK_SIZE);
+        std::uint8_t K[Hash::BLOCK_SIZE] = {0};
         if (key_len > Hash::BLOCK_SIZE)
         {
             std::uint8_t digest[Hash::DIGEST_SIZE];
-            h_.do_final(digest, key, key_len);
             h_.reset();
+            h_.do_final(digest, key, key_len);
             std::size_t cpy_size = (Hash::BLOCK_SIZE < Hash::DIGEST_SIZE)
                                        ? Hash::BLOCK_SIZE
                                        : Hash::DIGEST_SIZE;
-            std::memcpy(K_, digest, cpy_size);
+            std::memcpy(K, digest, cpy_size);
+            memory_utils::memzero(digest, sizeof(digest));
         }
-        else
+        else if (key_len != 0)
         {
-            std::memcpy(K_, key, key_len);
+            std::memcpy(K, key, key_len);
         }
 
-        std::uint8_t i_pad[Hash::BLOCK_SIZE];
+        std::uint8_t pad[Hash::BLOCK_SIZE];
+        for (std::size_t i = 0; i < Hash::BLOCK_SIZE; i++)
+        {
+            pad[i] = K[i] ^ 0x36;
+        }
+        inner_.reset();
+        inner_.update(pad, Hash::BLOCK_SIZE);
         for (std::size_t i = 0; i < Hash::BLOCK_SIZE; i++)
         {
-            i_pad[i] = K_[i] ^ 0x36;
+            pad[i] = K[i] ^ 0x5c;
         }
-        h_.update(i_pad, Hash::BLOCK_SIZE);
+        outer_.reset();
+        outer_.update(pad, Hash::BLOCK_SIZE);
+        memory_utils::memzero(K, sizeof(K));
+        memory_utils::memzero(pad, sizeof(pad));
+
+        h_ = inner_;
+    }
+
+    /**
+     * @brief   back to the keyed state, without hashing the key again
+     */
+    void reset()
+    {
+        h_ = inner_;
     }
 
     void update(const std::uint8_t* msg, std::size_t msg_len)
@@ -59,24 +85,23 @@ public:
         h_.update(msg, msg_len);
     }
 
+    void update_v(const memory_utils::IoVec* msg, std::size_t msg_num)
+    {
+        h_.update_v(msg, msg_num);
+    }
+
+    /**
+     * @brief               output the MAC, then reset to the keyed state
+     */
     void do_final(std::uint8_t*       digest,
                   const std::uint8_t* msg     = nullptr,
                   std::size_t         msg_len = 0)
     {
-        this->update(msg, msg_len);
-
         std::uint8_t i_digest[Hash::DIGEST_SIZE];
-        std::uint8_t o_pad[Hash::BLOCK_SIZE];
-
-        h_.do_final(i_digest, nullptr, 0);
-        h_.reset();
-        for (std::size_t i = 0; i < Hash::BLOCK_SIZE; i++)
-        {
-            o_pad[i] = K_[i] ^ 0x5c;
-        }
-        h_.update(o_pad, Hash::BLOCK_SIZE);
-        h_.update(i_digest, Hash::DIGEST_SIZE);
-        h_.do_final(digest, nullptr, 0);
+        h_.do_final(i_digest, msg, msg_len);
+        h_ = outer_;
+        h_.do_final(digest, i_digest, Hash::DIGEST_SIZE);
+        h_ = inner_;
     }
 };
 
@@ -0,0 +1,61 @@
+#ifndef HASH_LIB_PBKDF2_H
+#define HASH_LIB_PBKDF2_H
+
+#include <gmlib/hash_lib/hmac.h>
+#include <gmlib/memory_utils/endian.h>
+#include <gmlib/memory_utils/memxor.h>
+#include <gmlib/memory_utils/memzero.h>
+
+#include <stdexcept>
+
+namespace hash_lib {
+
+/**
+ * @brief                   PBKDF2 with HMAC-Hash as PRF (RFC 8018)
+ * @param[out]  out         derived key
+ * @param[in]   out_len     derived key length (in bytes)
+ * @param[in]   password    password
+ * @param[in]   password_len password length (in bytes)
+ * @param[in]   salt        salt
+ * @param[in]   salt_len    salt length (in bytes)
+ * @param[in]   iter        iteration count, at least 1
+ */
+template <class Hash>
+void pbkdf2_hmac(std::uint8_t*       out,
+                 std::size_t         out_len,
+                 const std::uint8_t* password,
+                 std::size_t         password_len,
+                 const std::uint8_t* salt,
+                 std::size_t         salt_len,
+                 std::size_t         iter)
+{
+    constexpr std::size_t DIGEST_SIZE = Hash::DIGEST_SIZE;
+    if (iter == 0)
+    {
+        throw std::runtime_error("invalid pbkdf2 iteration count");
+    }
+
+    HMac<Hash>   hmac(password, password_len);
+    std::uint8_t U[DIGEST_SIZE], T[DIGEST_SIZE], index[4];
+    for (std::uint32_t i = 1; out_len != 0; i++)
+    {
+        memory_utils::store32_be(index, i);
+        hmac.update(salt, salt_len);
+        hmac.do_final(U, index, 4);
+        std::memcpy(T, U, DIGEST_SIZE);
+        for (std::size_t j = 1; j < iter; j++)
+        {
+            hmac.do_final(U, U, DIGEST_SIZE);
+            memory_utils::memxor<DIGEST_SIZE>(T, T, U);
+        }
+        std::size_t size = (out_len < DIGEST_SIZE) ? out_len : DIGEST_SIZE;
+        std::memcpy(out, T, size);
+        out += size, out_len -= size;
+    }
+    memory_utils::memzero(U, sizeof(U));
+    memory_utils::memzero(T, sizeof(T));
+}
+
+} // namespace hash_lib
+
+#endif
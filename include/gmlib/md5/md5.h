@@ -10,8 +10,10 @@ namespace alg = md5::internal::common;
 
 namespace md5 {
 
-class MD5 : public hash_lib::HashImpl<alg::MD5_BLOCK_SIZE>
+class MD5 final : public hash_lib::HashImpl<alg::MD5_BLOCK_SIZE, MD5>
 {
+    friend class hash_lib::HashImpl<alg::MD5_BLOCK_SIZE, MD5>;
+
 public:
     static constexpr const char* NAME = "MD5";
 
@@ -75,7 +77,7 @@ public:
      */
     void reset() noexcept override
     {
-        this->HashImpl<alg::MD5_BLOCK_SIZE>::reset();
+        this->HashImpl<alg::MD5_BLOCK_SIZE, MD5>::reset();
         alg::md5_reset(&ctx_);
     }
 
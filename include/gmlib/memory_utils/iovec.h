@@ -0,0 +1,32 @@
+#ifndef MEMORY_UTILS_IOVEC_H
+#define MEMORY_UTILS_IOVEC_H
+
+#include <cstddef>
+
+namespace memory_utils {
+
+/**
+ * @brief   one fragment of a scatter/gather input, like POSIX struct iovec
+ */
+struct IoVec
+{
+    const void* iov_base; // fragment data
+    std::size_t iov_len;  // fragment length (in bytes)
+};
+
+/**
+ * @brief   total length of n fragments
+ */
+static inline std::size_t iovec_len(const IoVec* iov, std::size_t n) noexcept
+{
+    std::size_t len = 0;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+} // namespace memory_utils
+
+#endif
@@ -0,0 +1,455 @@
+#ifndef MEMORY_UTILS_MAPPED_FILE_H
+#define MEMORY_UTILS_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace memory_utils {
+
+/**
+ * @brief   unit of work over a mapped file, a 2 MB huge page on x86-64
+ */
+constexpr std::size_t MAPPED_FILE_CHUNK_SIZE = 1 << 21;
+
+/**
+ * @brief   memory mapping of a whole file
+ * @details pages are read in on first access, the mapping is advised for
+ *          sequential access and read-ahead (and huge pages where the OS
+ *          allows them for files). An empty file maps to data() == nullptr
+ *          and size() == 0.
+ *
+ *          A read-write mapping writes a temporary file next to the target,
+ *          commit() renames it over the target once the data is complete.
+ *          Without commit() the temporary file is deleted, so a failed run
+ *          never leaves a truncated or partial target behind.
+ */
+class MappedFile
+{
+private:
+    std::uint8_t* data_     = nullptr;
+    std::size_t   size_     = 0;
+    bool          writable_ = false;
+    std::uint64_t dev_      = 0; // file identity, device (volume serial)
+    std::uint64_t ino_      = 0; // file identity, inode (file index)
+    std::string   path_;           // target of a read-write mapping
+    std::string   tmp_path_;       // written file, empty once committed
+#if defined(_WIN32)
+    HANDLE map_ = nullptr;
+#endif
+
+public:
+    /**
+     * @brief               map an existing file, read-only
+     * @param[in]   path    file path (UTF-8)
+     */
+    explicit MappedFile(const char* path)
+    {
+#if defined(_WIN32)
+        HANDLE file = MappedFile::open_file(path, GENERIC_READ,
+                                            FILE_SHARE_READ, OPEN_EXISTING,
+                                            FILE_FLAG_SEQUENTIAL_SCAN);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("failed to open file");
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || !this->identify(file))
+        {
+            CloseHandle(file);
+            throw std::runtime_error("failed to get file size");
+        }
+        if ((std::uint64_t)file_size.QuadPart > SIZE_MAX)
+        {
+            CloseHandle(file);
+            throw std::runtime_error("file too large to map");
+        }
+        this->map(file, (std::size_t)file_size.QuadPart);
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("failed to open file");
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("failed to get file size");
+        }
+        if (st.st_size < 0 || (std::uint64_t)st.st_size > SIZE_MAX)
+        {
+            close(fd);
+            throw std::runtime_error("file too large to map");
+        }
+        dev_ = (std::uint64_t)st.st_dev, ino_ = (std::uint64_t)st.st_ino;
+        this->map(fd, (std::size_t)st.st_size);
+#endif
+    }
+
+    /**
+     * @brief               map a new file of size bytes read-write, to
+     *                      replace (or create) path on commit()
+     * @param[in]   path    file path (UTF-8)
+     * @param[in]   size    file size (in bytes)
+     * @param[in]   other   optional mapped file that path must not be, the
+     *                      check is made on the existing path (so relative
+     *                      paths and hard links are caught)
+     */
+    MappedFile(const char*       path,
+               std::size_t       size,
+               const MappedFile* other = nullptr)
+        : writable_(true), path_(path)
+    {
+#if defined(_WIN32)
+        if (other != nullptr)
+        {
+            HANDLE target = MappedFile::open_file(
+                path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL);
+            if (target != INVALID_HANDLE_VALUE)
+            {
+                bool same = this->identify(target) && this->same_file(*other);
+                CloseHandle(target);
+                if (same)
+                {
+                    throw std::runtime_error("output file is the input file");
+                }
+            }
+        }
+        HANDLE file = INVALID_HANDLE_VALUE;
+        for (int n = 0; n < 100 && file == INVALID_HANDLE_VALUE; n++)
+        {
+            tmp_path_ = path_ + ".tmp" +
+                        std::to_string(GetCurrentProcessId()) + "-" +
+                        std::to_string(n);
+            file = MappedFile::open_file(
+                tmp_path_.c_str(), GENERIC_READ | GENERIC_WRITE, 0, CREATE_NEW,
+                FILE_ATTRIBUTE_NORMAL);
+            if (file == INVALID_HANDLE_VALUE &&
+                GetLastError() != ERROR_FILE_EXISTS)
+            {
+                break;
+            }
+        }
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            tmp_path_.clear();
+            throw std::runtime_error("failed to create file");
+        }
+        try
+        {
+            this->identify(file);
+            // the mapping grows the new file to size with zeros
+            this->map(file, size);
+        }
+        catch (...)
+        {
+            this->remove_tmp();
+            throw;
+        }
+#else
+        struct stat st;
+        if (other != nullptr && stat(path, &st) == 0 &&
+            (std::uint64_t)st.st_dev == other->dev_ &&
+            (std::uint64_t)st.st_ino == other->ino_)
+        {
+            throw std::runtime_error("output file is the input file");
+        }
+        int fd = -1;
+        for (int n = 0; n < 100 && fd < 0; n++)
+        {
+            tmp_path_ = path_ + ".tmp" + std::to_string(getpid()) + "-" +
+                        std::to_string(n);
+            fd = open(tmp_path_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+            if (fd < 0 && errno != EEXIST)
+            {
+                break;
+            }
+        }
+        if (fd < 0)
+        {
+            tmp_path_.clear();
+            throw std::runtime_error("failed to create file");
+        }
+        if (fstat(fd, &st) == 0)
+        {
+            dev_ = (std::uint64_t)st.st_dev, ino_ = (std::uint64_t)st.st_ino;
+        }
+        if ((std::uint64_t)size >
+                (std::uint64_t)std::numeric_limits<off_t>::max() ||
+            ftruncate(fd, (off_t)size) != 0)
+        {
+            close(fd);
+            this->remove_tmp();
+            throw std::runtime_error("failed to set file size");
+        }
+        try
+        {
+            this->map(fd, size);
+        }
+        catch (...)
+        {
+            this->remove_tmp();
+            throw;
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        this->unmap();
+        this->remove_tmp();
+    }
+
+public:
+    const std::uint8_t* data() const noexcept
+    {
+        return data_;
+    }
+
+    /**
+     * @brief   mapped data of a file opened read-write
+     */
+    std::uint8_t* writable_data() noexcept
+    {
+        return writable_ ? data_ : nullptr;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    /**
+     * @brief   unmap a read-write file and rename it over the target path,
+     *          after which data() is nullptr
+     */
+    void commit()
+    {
+        if (tmp_path_.empty())
+        {
+            throw std::runtime_error("no file to commit");
+        }
+        this->unmap();
+#if defined(_WIN32)
+        std::wstring from = MappedFile::widen(tmp_path_.c_str());
+        std::wstring to   = MappedFile::widen(path_.c_str());
+        if (from.empty() || to.empty() ||
+            !MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            throw std::runtime_error("failed to replace file");
+        }
+#else
+        if (std::rename(tmp_path_.c_str(), path_.c_str()) != 0)
+        {
+            throw std::runtime_error("failed to replace file");
+        }
+#endif
+        tmp_path_.clear();
+    }
+
+    /**
+     * @brief   whether both objects map the same file
+     */
+    bool same_file(const MappedFile& other) const noexcept
+    {
+        return dev_ == other.dev_ && ino_ == other.ino_;
+    }
+
+private:
+    void unmap() noexcept
+    {
+#if defined(_WIN32)
+        if (data_ != nullptr)
+        {
+            UnmapViewOfFile(data_);
+        }
+        if (map_ != nullptr)
+        {
+            CloseHandle(map_);
+        }
+        map_ = nullptr;
+#else
+        if (data_ != nullptr)
+        {
+            munmap(data_, size_);
+        }
+#endif
+        data_ = nullptr, size_ = 0;
+    }
+
+    /**
+     * @brief   delete the temporary file of an uncommitted read-write map
+     */
+    void remove_tmp() noexcept
+    {
+        if (tmp_path_.empty())
+        {
+            return;
+        }
+#if defined(_WIN32)
+        std::wstring wpath = MappedFile::widen(tmp_path_.c_str());
+        if (!wpath.empty())
+        {
+            DeleteFileW(wpath.c_str());
+        }
+#else
+        unlink(tmp_path_.c_str());
+#endif
+        tmp_path_.clear();
+    }
+
+#if defined(_WIN32)
+    /**
+     * @brief   UTF-8 path to UTF-16, empty on error
+     */
+    static std::wstring widen(const char* path) noexcept
+    {
+        int len = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path, -1,
+                                      nullptr, 0);
+        if (len <= 0)
+        {
+            return std::wstring();
+        }
+        try
+        {
+            std::wstring wpath((std::size_t)len, L'\0');
+            MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, path, -1,
+                                &wpath[0], len);
+            return wpath;
+        }
+        catch (const std::bad_alloc&)
+        {
+            return std::wstring();
+        }
+    }
+
+    /**
+     * @brief   CreateFileW on a UTF-8 path, INVALID_HANDLE_VALUE on error
+     */
+    static HANDLE open_file(const char* path,
+                            DWORD       access,
+                            DWORD       share,
+                            DWORD       disposition,
+                            DWORD       flags) noexcept
+    {
+        std::wstring wpath = MappedFile::widen(path);
+        if (wpath.empty())
+        {
+            SetLastError(ERROR_INVALID_NAME);
+            return INVALID_HANDLE_VALUE;
+        }
+        return CreateFileW(wpath.c_str(), access, share, nullptr, disposition,
+                           flags, nullptr);
+    }
+
+    /**
+     * @brief   read the file identity of an opened file
+     */
+    bool identify(HANDLE file) noexcept
+    {
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(file, &info))
+        {
+            return false;
+        }
+        dev_ = info.dwVolumeSerialNumber;
+        ino_ = ((std::uint64_t)info.nFileIndexHigh << 32) |
+               info.nFileIndexLow;
+        return true;
+    }
+
+    /**
+     * @brief   map size bytes of file, the file handle is always closed
+     */
+    void map(HANDLE file, std::size_t size)
+    {
+        size_ = size;
+        if (size_ != 0)
+        {
+            std::uint64_t size64  = size_;
+            DWORD         protect = writable_ ? PAGE_READWRITE : PAGE_READONLY;
+            map_ = CreateFileMappingA(file, nullptr, protect,
+                                      (DWORD)(size64 >> 32), (DWORD)size64,
+                                      nullptr);
+            if (map_ != nullptr)
+            {
+                data_ = (std::uint8_t*)MapViewOfFile(
+                    map_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+            }
+#if _WIN32_WINNT >= 0x0602
+            if (data_ != nullptr)
+            {
+                // read-ahead of the whole view, like MADV_WILLNEED
+                WIN32_MEMORY_RANGE_ENTRY range = {data_, size_};
+                PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+            }
+#endif
+        }
+        CloseHandle(file);
+        if (size_ != 0 && data_ == nullptr)
+        {
+            if (map_ != nullptr)
+            {
+                CloseHandle(map_);
+            }
+            throw std::runtime_error("failed to map file");
+        }
+    }
+#else
+    /**
+     * @brief   map size bytes of fd, fd is always closed
+     */
+    void map(int fd, std::size_t size)
+    {
+        size_ = size;
+        if (size_ != 0)
+        {
+            int   prot  = writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ;
+            int   flags = writable_ ? MAP_SHARED : MAP_PRIVATE;
+            void* p     = mmap(nullptr, size_, prot, flags, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                close(fd);
+                throw std::runtime_error("failed to map file");
+            }
+            // advice only, errors are ignored
+            madvise(p, size_, MADV_SEQUENTIAL);
+            madvise(p, size_, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+            madvise(p, size_, MADV_HUGEPAGE);
+#endif
+            data_ = (std::uint8_t*)p;
+        }
+        close(fd);
+    }
+#endif
+};
+
+} // namespace memory_utils
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef MEMORY_UTILS_MEMEQUAL_H
+#define MEMORY_UTILS_MEMEQUAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace memory_utils {
+
+/**
+ * @brief   compare secret data, every byte is read whatever the first
+ *          difference, so the time does not depend on where it is
+ * @return  true if the n bytes at a and b are equal
+ */
+static inline bool memequal(const void* a,
+                            const void* b,
+                            std::size_t n) noexcept
+{
+    using Byte = const volatile std::uint8_t;
+
+    Byte*        x    = static_cast<Byte*>(a);
+    Byte*        y    = static_cast<Byte*>(b);
+    std::uint8_t diff = 0;
+    while (n--)
+    {
+        diff |= *x++ ^ *y++;
+    }
+    return diff == 0;
+}
+
+} // namespace memory_utils
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef MEMORY_UTILS_MEMZERO_H
+#define MEMORY_UTILS_MEMZERO_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace memory_utils {
+
+/**
+ * @brief   clear secret data, the stores are not optimized away even when
+ *          the memory is released right after
+ */
+static inline void memzero(void* p, std::size_t n) noexcept
+{
+    volatile std::uint8_t* v = static_cast<volatile std::uint8_t*>(p);
+    while (n--)
+    {
+        *v++ = 0;
+    }
+}
+
+} // namespace memory_utils
+
+#endif
@@ -19,8 +19,10 @@ namespace alg = sha1::internal::common;
 
 namespace sha1 {
 
-class SHA1 : public hash_lib::HashImpl<alg::SHA1_BLOCK_SIZE>
+class SHA1 final : public hash_lib::HashImpl<alg::SHA1_BLOCK_SIZE, SHA1>
 {
+    friend class hash_lib::HashImpl<alg::SHA1_BLOCK_SIZE, SHA1>;
+
 public:
     static constexpr const char* NAME = "SHA1";
 
@@ -85,7 +87,7 @@ public:
      */
     void reset() noexcept override
     {
-        this->HashImpl<alg::SHA1_BLOCK_SIZE>::reset();
+        this->HashImpl<alg::SHA1_BLOCK_SIZE, SHA1>::reset();
         alg::sha1_reset(&ctx_);
     }
 
@@ -0,0 +1,64 @@
+#ifndef SM2_INTERNAL_SM2_BATCH_H
+#define SM2_INTERNAL_SM2_BATCH_H
+
+#include <gmlib/sm2/internal/sm2p256v1.h>
+
+#include <cstddef>
+
+namespace sm2::internal {
+
+/// @brief points handled together by the batch operations of SM2 keys
+constexpr std::size_t SM2_BATCH_NUM = 32;
+
+/**
+ * @brief           R[i] = P[i] in affine coordinates, for i < num
+ * @details         Montgomery's trick: one field inversion for the whole
+ *                  batch and 3 multiplications per point. The prefix
+ *                  products of Z are kept in the x coordinates of R.
+ * @param[out]  R   num affine points, must not overlap P
+ * @param[in]   P   num Jacobian points, infinity gives (0, 0)
+ * @param[in]   num point number
+ */
+inline void sm2_ec_j_to_a_batch(sm2_ec_a       R[],
+                                const sm2_ec_j P[],
+                                std::size_t    num) noexcept
+{
+    sm2_fp_t acc, zi, zi2;
+    sm2_fp_set_one(acc);
+    for (std::size_t i = 0; i < num; i++)
+    {
+        if (!sm2_ec_j_is_inf(P[i]))
+        {
+            sm2_fp_mul(acc, acc, P[i][2]);
+        }
+        sm2_fp_cpy(R[i][0], acc);
+    }
+    sm2_fp_inv(acc, acc);
+    for (std::size_t i = num; i-- != 0;)
+    {
+        if (sm2_ec_j_is_inf(P[i]))
+        {
+            sm2_fp_set_zero(R[i][0]);
+            sm2_fp_set_zero(R[i][1]);
+            continue;
+        }
+        // Z^-1 = (Z_0 ... Z_i)^-1 * (Z_0 ... Z_i-1)
+        if (i != 0)
+        {
+            sm2_fp_mul(zi, acc, R[i - 1][0]);
+        }
+        else
+        {
+            sm2_fp_cpy(zi, acc);
+        }
+        sm2_fp_mul(acc, acc, P[i][2]);
+        sm2_fp_sqr(zi2, zi);
+        sm2_fp_mul(R[i][0], P[i][0], zi2);
+        sm2_fp_mul(zi2, zi2, zi);
+        sm2_fp_mul(R[i][1], P[i][1], zi2);
+    }
+}
+
+} // namespace sm2::internal
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef SM2_INTERNAL_SM2_COMB_H
+#define SM2_INTERNAL_SM2_COMB_H
+
+#include <gmlib/sm2/internal/sm2_batch.h>
+#include <gmlib/sm2/internal/sm2p256v1.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace sm2::internal {
+
+/// @brief teeth of the comb, the table holds 2^SM2_COMB_TEETH points
+constexpr int SM2_COMB_TEETH = 6;
+
+/// @brief distance between two teeth (in bits)
+constexpr int SM2_COMB_SPACING = (256 + SM2_COMB_TEETH - 1) / SM2_COMB_TEETH;
+
+/**
+ * @brief   signatures of one key in a verify_batch from which a temporary
+ *          comb table is cheaper than interleaved wNAF, the table costs
+ *          about one verify to build
+ */
+constexpr std::size_t SM2_COMB_BATCH_MIN = 4;
+
+/**
+ * @brief   fixed-base comb table of a point P (Lim-Lee)
+ * @details with d = SM2_COMB_SPACING, T[m] = sum of [2^(i*d)]P over the set
+ *          bits i of m. T[0] is a copy of P, it is never used as a result.
+ */
+typedef struct sm2_comb_table
+{
+    sm2_ec_a T[1 << SM2_COMB_TEETH];
+} sm2_comb_table;
+
+/**
+ * @brief           build the comb table of P
+ * @param[out]  tb  comb table
+ * @param[in]   P   point, not infinity
+ */
+inline void sm2_comb_table_init(sm2_comb_table* tb, const sm2_ec_a P) noexcept
+{
+    sm2_ec_j B[SM2_COMB_TEETH], T[1 << SM2_COMB_TEETH];
+    // B[i] = [2^(i*d)]P
+    sm2_ec_j_from_a(B[0], P);
+    for (int i = 1; i < SM2_COMB_TEETH; i++)
+    {
+        sm2_ec_j_cpy(B[i], B[i - 1]);
+        for (int j = 0; j < SM2_COMB_SPACING; j++)
+        {
+            sm2_ec_j_dbl(B[i], B[i]);
+        }
+    }
+    sm2_ec_j_cpy(T[0], B[0]);
+    for (int m = 1; m < (1 << SM2_COMB_TEETH); m++)
+    {
+        int top = 0;
+        while ((m >> (top + 1)) != 0)
+        {
+            top++;
+        }
+        int rest = m ^ (1 << top);
+        if (rest == 0)
+        {
+            sm2_ec_j_cpy(T[m], B[top]);
+        }
+        else
+        {
+            sm2_ec_j_add(T[m], B[top], T[rest]);
+        }
+    }
+    sm2_ec_j_to_a_batch(tb->T, T, 1 << SM2_COMB_TEETH);
+}
+
+/**
+ * @brief   R = table[idx], every entry is read so the memory access
+ *          pattern does not depend on idx
+ */
+inline void sm2_comb_select(sm2_ec_a              R,
+                            const sm2_comb_table* tb,
+                            unsigned              idx) noexcept
+{
+    using limb_t = std::remove_extent_t<sm2_fp_t>;
+    constexpr std::size_t LIMB_NUM = sizeof(sm2_fp_t) / sizeof(limb_t);
+
+    for (int c = 0; c < 2; c++)
+    {
+        for (std::size_t l = 0; l < LIMB_NUM; l++)
+        {
+            R[c][l] = 0;
+        }
+    }
+    for (unsigned m = 0; m < (1U << SM2_COMB_TEETH); m++)
+    {
+        limb_t mask = (limb_t)0 - (limb_t)(m == idx);
+        for (int c = 0; c < 2; c++)
+        {
+            for (std::size_t l = 0; l < LIMB_NUM; l++)
+            {
+                R[c][l] |= tb->T[m][c][l] & mask;
+            }
+        }
+    }
+}
+
+/**
+ * @brief           R = [k]P with the comb table of P, SM2_COMB_SPACING - 1
+ *                  doublings and SM2_COMB_SPACING additions
+ * @param[out]  R   result point
+ * @param[in]   k   scalar (32 bytes, big endian)
+ * @param[in]   tb  comb table of P
+ */
+inline void sm2_ec_j_mul_comb(sm2_ec_j              R,
+                              const std::uint8_t    k[32],
+                              const sm2_comb_table* tb) noexcept
+{
+    using limb_t = std::remove_extent_t<sm2_fp_t>;
+    constexpr std::size_t LIMB_NUM = sizeof(sm2_fp_t) / sizeof(limb_t);
+
+    sm2_ec_a T;
+    sm2_ec_j S;
+    sm2_ec_j_set_inf(R);
+    for (int j = SM2_COMB_SPACING - 1; j >= 0; j--)
+    {
+        unsigned idx = 0;
+        for (int i = 0; i < SM2_COMB_TEETH; i++)
+        {
+            int bit = i * SM2_COMB_SPACING + j;
+            if (bit < 256)
+            {
+                idx |= (unsigned)((k[31 - bit / 8] >> (bit % 8)) & 1) << i;
+            }
+        }
+        sm2_ec_j_dbl(R, R);
+        sm2_comb_select(T, tb, idx);
+        sm2_ec_j_add_a(S, R, T);
+        // keep R for a zero column
+        limb_t mask = (limb_t)0 - (limb_t)(idx != 0);
+        for (int c = 0; c < 3; c++)
+        {
+            for (std::size_t l = 0; l < LIMB_NUM; l++)
+            {
+                R[c][l] = (S[c][l] & mask) | (R[c][l] & ~mask);
+            }
+        }
+    }
+}
+
+} // namespace sm2::internal
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef SM2_INTERNAL_SM2_WNAF_H
+#define SM2_INTERNAL_SM2_WNAF_H
+
+#include <gmlib/sm2/internal/sm2_batch.h>
+#include <gmlib/sm2/internal/sm2p256v1.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sm2::internal {
+
+/// @brief wNAF window of G, its table holds 2^(w-2) affine points
+constexpr int SM2_WNAF_G_WINDOW = 7;
+
+/// @brief wNAF window of a variable point, its table is built per point
+constexpr int SM2_WNAF_A_WINDOW = 5;
+
+/// @brief odd multiples in the table of a variable point
+constexpr int SM2_WNAF_A_TABLE_SIZE = 1 << (SM2_WNAF_A_WINDOW - 2);
+
+/// @brief digits of a 256-bit scalar in wNAF
+constexpr int SM2_WNAF_MAX_LEN = 257;
+
+/**
+ * @brief           width-w NAF of k, every non-zero digit is odd and
+ *                  less than 2^(w-1) in absolute value
+ * @param[out]  naf digits, least significant first
+ * @param[in]   k   scalar (32 bytes, big endian)
+ * @param[in]   w   window width, 2 to 8
+ * @return          digit number
+ * @note            variable time, for public scalars only
+ */
+inline int sm2_wnaf(std::int8_t        naf[SM2_WNAF_MAX_LEN],
+                    const std::uint8_t k[32],
+                    int                w) noexcept
+{
+    // 5 limbs, the top one takes the carry of a negative digit
+    std::uint64_t n[5] = {0};
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            n[i] |= (std::uint64_t)k[31 - 8 * i - j] << (8 * j);
+        }
+    }
+    const std::int64_t half = (std::int64_t)1 << (w - 1);
+    const std::int64_t mask = ((std::int64_t)1 << w) - 1;
+
+    int len = 0;
+    while ((n[0] | n[1] | n[2] | n[3] | n[4]) != 0)
+    {
+        std::int64_t d = 0;
+        if (n[0] & 1)
+        {
+            d = (std::int64_t)(n[0] & (std::uint64_t)mask);
+            if (d >= half)
+            {
+                d -= (std::int64_t)1 << w;
+            }
+            // n -= d
+            if (d > 0)
+            {
+                std::uint64_t borrow = (n[0] < (std::uint64_t)d);
+                n[0] -= (std::uint64_t)d;
+                for (int i = 1; i < 5 && borrow; i++)
+                {
+                    borrow = (n[i] == 0);
+                    n[i]--;
+                }
+            }
+            else
+            {
+                std::uint64_t carry;
+                n[0] += (std::uint64_t)(-d);
+                carry = (n[0] < (std::uint64_t)(-d));
+                for (int i = 1; i < 5 && carry; i++)
+                {
+                    n[i]++;
+                    carry = (n[i] == 0);
+                }
+            }
+        }
+        naf[len++] = (std::int8_t)d;
+        // n >>= 1
+        for (int i = 0; i < 4; i++)
+        {
+            n[i] = (n[i] >> 1) | (n[i + 1] << 63);
+        }
+        n[4] >>= 1;
+    }
+    return len;
+}
+
+/**
+ * @brief   odd multiples G, 3G, ..., (2^(w-1) - 1)G in affine coordinates,
+ *          built on first use
+ */
+inline const sm2_ec_a* sm2_wnaf_g_table() noexcept
+{
+    constexpr int TABLE_SIZE = 1 << (SM2_WNAF_G_WINDOW - 2);
+
+    struct Table
+    {
+        sm2_ec_a T[TABLE_SIZE];
+
+        Table() noexcept
+        {
+            sm2_ec_a G;
+            sm2_ec_j G2, S[TABLE_SIZE];
+            sm2_fp_from_bytes(G[0], SM2_CURVE_GX);
+            sm2_fp_from_bytes(G[1], SM2_CURVE_GY);
+            sm2_ec_j_from_a(S[0], G);
+            sm2_ec_j_dbl(G2, S[0]);
+            for (int i = 1; i < TABLE_SIZE; i++)
+            {
+                sm2_ec_j_add(S[i], S[i - 1], G2);
+            }
+            sm2_ec_j_to_a_batch(T, S, TABLE_SIZE);
+        }
+    };
+    static const Table table;
+    return table.T;
+}
+
+/**
+ * @brief           odd multiples P, 3P, ..., (2^(w-1) - 1)P of a variable
+ *                  point, for sm2_ec_j_mul_g_add_mul_table
+ * @param[out]  TP  table
+ * @param[in]   P   point
+ */
+inline void sm2_wnaf_table_init(sm2_ec_j       TP[SM2_WNAF_A_TABLE_SIZE],
+                                const sm2_ec_a P) noexcept
+{
+    sm2_ec_j P2;
+    sm2_ec_j_from_a(TP[0], P);
+    sm2_ec_j_dbl(P2, TP[0]);
+    for (int i = 1; i < SM2_WNAF_A_TABLE_SIZE; i++)
+    {
+        sm2_ec_j_add(TP[i], TP[i - 1], P2);
+    }
+}
+
+/**
+ * @brief           R = [s]G + [t]P by interleaved wNAF, all scalars share
+ *                  one doubling chain
+ * @param[out]  R   result point
+ * @param[in]   s   scalar of G (32 bytes, big endian)
+ * @param[in]   t   scalar of P (32 bytes, big endian)
+ * @param[in]   TP  wNAF table of P, from sm2_wnaf_table_init
+ * @note            variable time, for public scalars only (verification)
+ */
+inline void sm2_ec_j_mul_g_add_mul_table(
+    sm2_ec_j           R,
+    const std::uint8_t s[32],
+    const std::uint8_t t[32],
+    const sm2_ec_j     TP[SM2_WNAF_A_TABLE_SIZE]) noexcept
+{
+    const sm2_ec_a* TG = sm2_wnaf_g_table();
+    sm2_ec_j        Q;
+    sm2_ec_a        N;
+    std::int8_t     naf_s[SM2_WNAF_MAX_LEN], naf_t[SM2_WNAF_MAX_LEN];
+
+    int len_s = sm2_wnaf(naf_s, s, SM2_WNAF_G_WINDOW);
+    int len_t = sm2_wnaf(naf_t, t, SM2_WNAF_A_WINDOW);
+    int len   = (len_s > len_t) ? len_s : len_t;
+
+    sm2_ec_j_set_inf(R);
+    for (int i = len - 1; i >= 0; i--)
+    {
+        sm2_ec_j_dbl(R, R);
+        int ds = (i < len_s) ? naf_s[i] : 0;
+        int dt = (i < len_t) ? naf_t[i] : 0;
+        if (ds > 0)
+        {
+            sm2_ec_j_add_a(R, R, TG[ds / 2]);
+        }
+        else if (ds < 0)
+        {
+            sm2_ec_a_neg(N, TG[-ds / 2]);
+            sm2_ec_j_add_a(R, R, N);
+        }
+        if (dt > 0)
+        {
+            sm2_ec_j_add(R, R, TP[dt / 2]);
+        }
+        else if (dt < 0)
+        {
+            sm2_ec_j_neg(Q, TP[-dt / 2]);
+            sm2_ec_j_add(R, R, Q);
+        }
+    }
+}
+
+/**
+ * @brief           R = [s]G + [t]P by interleaved wNAF
+ * @param[out]  R   result point
+ * @param[in]   s   scalar of G (32 bytes, big endian)
+ * @param[in]   t   scalar of P (32 bytes, big endian)
+ * @param[in]   P   point
+ * @note            variable time, for public scalars only (verification)
+ */
+inline void sm2_ec_j_mul_g_add_mul_a(sm2_ec_j           R,
+                                     const std::uint8_t s[32],
+                                     const std::uint8_t t[32],
+                                     const sm2_ec_a     P) noexcept
+{
+    sm2_ec_j TP[SM2_WNAF_A_TABLE_SIZE];
+    sm2_wnaf_table_init(TP, P);
+    sm2_ec_j_mul_g_add_mul_table(R, s, t, TP);
+}
+
+} // namespace sm2::internal
+
+#endif
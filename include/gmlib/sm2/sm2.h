@@ -1,12 +1,21 @@
 #ifndef SM2_SM2_H
 #define SM2_SM2_H
 
+#include <gmlib/memory_utils/memzero.h>
 #include <gmlib/rng/rng.h>
 #include <gmlib/sm2/internal/sm2_alg.h>
+#include <gmlib/sm2/internal/sm2_batch.h>
+#include <gmlib/sm2/internal/sm2_comb.h>
+#include <gmlib/sm2/internal/sm2_wnaf.h>
 #include <gmlib/sm2/internal/sm2p256v1.h>
 
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 namespace sm2 {
 
@@ -39,6 +48,103 @@ private:
     /// @brief SM2 Public Key Point coordinate Data
     std::uint8_t x_[32], y_[32];
 
+    /// @brief Z of the default ID
+    std::uint8_t z_[Hash::DIGEST_SIZE];
+
+    /**
+     * @brief   Z of the last few non-default IDs, replaced round robin
+     * @details IDs longer than ID_MAX_LEN are not cached. Lookups are
+     *          guarded by a mutex, so a const key can be shared by threads.
+     */
+    class ZCache
+    {
+    public:
+        static constexpr std::size_t ENTRY_NUM  = 4;
+        static constexpr std::size_t ID_MAX_LEN = 64;
+
+    private:
+        struct Entry
+        {
+            std::size_t  id_len = SIZE_MAX; // SIZE_MAX for an empty entry
+            std::uint8_t id[ID_MAX_LEN];
+            std::uint8_t z[Hash::DIGEST_SIZE];
+        };
+
+        Entry              entry_[ENTRY_NUM];
+        std::size_t        next_ = 0;
+        mutable std::mutex mutex_;
+
+    public:
+        ZCache() noexcept = default;
+
+        ZCache(const ZCache& other) noexcept
+        {
+            std::lock_guard<std::mutex> lock(other.mutex_);
+            std::memcpy(entry_, other.entry_, sizeof(entry_));
+            next_ = other.next_;
+        }
+
+        ZCache& operator=(const ZCache& other) noexcept
+        {
+            if (this != &other)
+            {
+                std::scoped_lock lock(mutex_, other.mutex_);
+                std::memcpy(entry_, other.entry_, sizeof(entry_));
+                next_ = other.next_;
+            }
+            return *this;
+        }
+
+    public:
+        void clear() noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (Entry& e : entry_)
+            {
+                e.id_len = SIZE_MAX;
+            }
+            next_ = 0;
+        }
+
+        bool find(std::uint8_t        z[Hash::DIGEST_SIZE],
+                  const std::uint8_t* id,
+                  std::size_t         id_len) const noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const Entry& e : entry_)
+            {
+                if (e.id_len == id_len && std::memcmp(e.id, id, id_len) == 0)
+                {
+                    std::memcpy(z, e.z, Hash::DIGEST_SIZE);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void insert(const std::uint8_t z[Hash::DIGEST_SIZE],
+                    const std::uint8_t* id,
+                    std::size_t         id_len) noexcept
+        {
+            if (id_len > ID_MAX_LEN)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            Entry& e = entry_[next_];
+            e.id_len = id_len;
+            std::memcpy(e.id, id, id_len);
+            std::memcpy(e.z, z, Hash::DIGEST_SIZE);
+            next_ = (next_ + 1) % ENTRY_NUM;
+        }
+    };
+
+    /// @brief Z of non-default IDs
+    mutable ZCache z_cache_;
+
+    /// @brief comb table of P_, built by "precompute", shared by copies
+    std::shared_ptr<const internal::sm2_comb_table> comb_;
+
 public:
     /**
      * @brief   SM2 Public Key Initialize
@@ -46,6 +152,15 @@ public:
      */
     SM2PublicKey() noexcept = default;
 
+    /**
+     * @brief   copy a key, with its Z cache, the copy shares the comb table
+     * @note    there are no move operations, a move copies the key (the Z
+     *          cache holds a mutex) and leaves the source unchanged
+     */
+    SM2PublicKey(const SM2PublicKey&) = default;
+
+    SM2PublicKey& operator=(const SM2PublicKey&) = default;
+
     /**
      * @brief           SM2 Public Key Initialize and Set
      * @param[in]   x   x coordinate of Public Key (32-bytes, big endian)
@@ -68,6 +183,14 @@ public:
      */
     inline void get_pub(std::uint8_t x[32], std::uint8_t y[32]) const noexcept;
 
+    /**
+     * @brief   build a comb table for the Public Key point, "encrypt" and
+     *          "verify" then multiply it at fixed-base speed
+     * @note    worth it for a key used many times, the table takes 4 KB and
+     *          is dropped when the key is set again
+     */
+    inline void precompute();
+
 public:
     /**
      * @brief                   SM2 signature verify
@@ -85,6 +208,34 @@ public:
         const std::uint8_t* id = internal::SM2_DEFAULT_ID,
         std::size_t id_len     = internal::SM2_DEFAULT_ID_LEN) const noexcept;
 
+    /**
+     * @brief                   SM2 signature verify of num signatures
+     * @details                 the signatures are grouped by key, a key
+     *                          computes its Z and its table once for its
+     *                          group. A key without a comb table gets a
+     *                          temporary one when it has at least
+     *                          SM2_COMB_BATCH_MIN signatures. No signature
+     *                          needs a field inversion.
+     * @param[out]  result      num results, Verify Pass (true) or Not (false)
+     * @param[in]   pub         num Public Key pointers
+     * @param[in]   sig_rs      num signature pointers (64 bytes each)
+     * @param[in]   msg         num message pointers
+     * @param[in]   msg_len     num message lengths (in bytes)
+     * @param[in]   num         signature number
+     * @param[in]   id          id of every key
+     * @param[in]   id_len      id length (in bytes)
+     * @return                  All Pass (true) or Not (false)
+     */
+    static inline bool verify_batch(
+        bool*                     result,
+        const SM2PublicKey* const pub[],
+        const std::uint8_t* const sig_rs[],
+        const std::uint8_t* const msg[],
+        const std::size_t         msg_len[],
+        std::size_t               num,
+        const std::uint8_t*       id = internal::SM2_DEFAULT_ID,
+        std::size_t id_len           = internal::SM2_DEFAULT_ID_LEN);
+
     /**
      * @brief                   SM2 calculate ciphertext length
      * @param[in]   plaintext   plaintext data
@@ -113,6 +264,29 @@ public:
                         rng::Rng&           rng,
                         SM2EcPC             PC = SM2EcPC::UNCOMPRESSED) const;
 
+    /**
+     * @brief                   SM2 encrypt of num plaintexts
+     * @details                 the points [k]G and [k]P of a batch are
+     *                          converted to affine coordinates with one
+     *                          field inversion
+     * @param[out]  ciphertext  num pointers to ciphertext buffers, each of
+     *                          "ciphertext_len" bytes
+     * @param[out]  c_len       num ciphertext lengths (in bytes)
+     * @param[in]   plaintext   num plaintext pointers
+     * @param[in]   p_len       num plaintext lengths (in bytes)
+     * @param[in]   num         plaintext number
+     * @param[in]   rng         Random Number Generator
+     * @param[in]   PC          EC point PC
+     */
+    inline void encrypt_batch(
+        std::uint8_t* const       ciphertext[],
+        std::size_t               c_len[],
+        const std::uint8_t* const plaintext[],
+        const std::size_t         p_len[],
+        std::size_t               num,
+        rng::Rng&                 rng,
+        SM2EcPC                   PC = SM2EcPC::UNCOMPRESSED) const;
+
 private:
     /**
      * @brief                   SM2 encrypt
@@ -154,6 +328,70 @@ private:
                         std::size_t         msg_len,
                         const std::uint8_t* id,
                         std::size_t         id_len) const noexcept;
+
+    /**
+     * @brief   recompute the cached values after P_, x_ and y_ are set
+     */
+    inline void cache_pub_() noexcept;
+
+    /**
+     * @brief                   Z of an ID, from the cache when possible
+     * @param[out]  z           Z (DIGEST_SIZE bytes)
+     * @param[in]   id          id, less than 2^16 / 8 bytes
+     * @param[in]   id_len      id length (in bytes)
+     */
+    inline void compute_z_(std::uint8_t        z[Hash::DIGEST_SIZE],
+                           const std::uint8_t* id,
+                           std::size_t         id_len) const;
+
+    /**
+     * @brief           R = [k]P_, with the comb table when there is one
+     * @param[out]  R   result point
+     * @param[in]   k   scalar (32 bytes, big endian)
+     */
+    inline void mul_pub_(internal::sm2_ec_j R,
+                         const std::uint8_t k[32]) const noexcept;
+
+    /**
+     * @brief               R = [s]G + [t]P, by the comb table of P when
+     *                      given, else by interleaved wNAF
+     * @param[out]  R       result point
+     * @param[in]   s       scalar of G (32 bytes, big endian)
+     * @param[in]   t       scalar of P (32 bytes, big endian)
+     * @param[in]   comb    comb table of P, or nullptr
+     * @param[in]   TP      wNAF table of P, used when comb is nullptr
+     * @note                variable time, for verification only
+     */
+    static inline void mul_g_add_(
+        internal::sm2_ec_j              R,
+        const std::uint8_t              s[32],
+        const std::uint8_t              t[32],
+        const internal::sm2_comb_table* comb,
+        const internal::sm2_ec_j        TP[]) noexcept;
+
+    /**
+     * @brief               check r', s' in [1,n-1] and compute t
+     * @param[out]  r       r' mod n
+     * @param[out]  t       t = r' + s' mod n (32 bytes, big endian)
+     * @param[in]   sig_r   signature r (32 bytes)
+     * @param[in]   sig_s   signature s (32 bytes)
+     * @return              in range and t != 0 (true) or not (false)
+     */
+    static inline bool parse_sig_(internal::sm2_fn_t r,
+                                  std::uint8_t       t[32],
+                                  const std::uint8_t sig_r[32],
+                                  const std::uint8_t sig_s[32]) noexcept;
+
+    /**
+     * @brief           r' == e' + x1' mod n, checked on the Jacobian
+     *                  coordinates of R, so no field inversion is needed
+     * @param[in]   R   [s']G + [t]P
+     * @param[in]   r   r' mod n
+     * @param[in]   e   e' mod n
+     */
+    static inline bool check_r_(const internal::sm2_ec_j R,
+                                const internal::sm2_fn_t r,
+                                const internal::sm2_fn_t e) noexcept;
 };
 
 template <class Hash>
@@ -169,6 +407,9 @@ private:
     /// @brief SM2 Private Key Data
     std::uint8_t priv_[32];
 
+    /// @brief SM2 Private Key d mod n, and (1 + d)^-1 mod n
+    internal::sm2_fn_t d_, d1_inv_;
+
     /// @brief SM2 Public Key
     SM2PublicKey<Hash> pub_;
 
@@ -179,6 +420,24 @@ public:
      */
     SM2PrivateKey() noexcept = default;
 
+    /**
+     * @brief   copy a key, with its cached values
+     * @note    there are no move operations, a move copies the key (the Z
+     *          cache holds a mutex) and leaves the source unchanged, until
+     *          it is destroyed and cleared
+     */
+    SM2PrivateKey(const SM2PrivateKey&) = default;
+
+    SM2PrivateKey& operator=(const SM2PrivateKey&) = default;
+
+    /**
+     * @brief   clear the private key and the values derived from it
+     */
+    ~SM2PrivateKey()
+    {
+        this->clear_priv_();
+    }
+
     /**
      * @brief                   SM2 Private Key Initialize and Set
      * @param[in]   priv_key    private key data (32 bytes, big endian)
@@ -235,6 +494,18 @@ public:
      */
     inline void gen_priv(rng::Rng& rng);
 
+    /**
+     * @brief               SM2 Private Key Generate of num keys
+     * @details             the Public Key points are converted to affine
+     *                      coordinates with one field inversion per batch
+     * @param[out]  keys    num keys
+     * @param[in]   num     key number
+     * @param[in]   rng     Random Number Generator
+     */
+    static inline void gen_priv_batch(SM2PrivateKey keys[],
+                                      std::size_t   num,
+                                      rng::Rng&     rng);
+
     /**
      * @brief   fetch SM2 Public Key
      * @return  SM2 Public Key const reference
@@ -258,6 +529,27 @@ public:
                      const std::uint8_t* id = internal::SM2_DEFAULT_ID,
                      std::size_t id_len = internal::SM2_DEFAULT_ID_LEN) const;
 
+    /**
+     * @brief                   SM2 sign of num messages
+     * @details                 the points [k]G of a batch are converted to
+     *                          affine coordinates with one field inversion
+     * @param[out]  sig_rs      num pointers to SM2 signatures (64 bytes)
+     * @param[in]   msg         num message pointers
+     * @param[in]   msg_len     num message lengths (in bytes)
+     * @param[in]   num         message number
+     * @param[in]   rng         Random Number Generator
+     * @param[in]   id          id, less than 2^16 / 8 bytes
+     * @param[in]   id_len      id length (in bytes)
+     */
+    inline void sign_batch(
+        std::uint8_t* const       sig_rs[],
+        const std::uint8_t* const msg[],
+        const std::size_t         msg_len[],
+        std::size_t               num,
+        rng::Rng&                 rng,
+        const std::uint8_t*       id = internal::SM2_DEFAULT_ID,
+        std::size_t id_len           = internal::SM2_DEFAULT_ID_LEN) const;
+
     /**
      * @brief                   SM2 signature verify
      * @param[in]   sig_rs      signature (64 bytes)
@@ -361,6 +653,16 @@ private:
                          std::size_t         C3_len,
                          const std::uint8_t* C2,
                          std::size_t         C2_len) const;
+
+    /**
+     * @brief   recompute the cached values after priv_ is set
+     */
+    inline void cache_priv_() noexcept;
+
+    /**
+     * @brief   zeroize priv_, d_ and d1_inv_
+     */
+    inline void clear_priv_() noexcept;
 };
 
 // ==============================================
@@ -388,6 +690,7 @@ inline void SM2PublicKey<Hash>::set_pub(const std::uint8_t x[32],
     internal::sm2_ec_a_cpy(P_, T);
     std::memcpy(x_, x, 32);
     std::memcpy(y_, y, 32);
+    this->cache_pub_();
 }
 
 template <class Hash>
@@ -398,6 +701,14 @@ inline void SM2PublicKey<Hash>::get_pub(std::uint8_t x[32],
     std::memcpy(y, y_, 32);
 }
 
+template <class Hash>
+inline void SM2PublicKey<Hash>::precompute()
+{
+    auto comb = std::make_shared<internal::sm2_comb_table>();
+    internal::sm2_comb_table_init(comb.get(), P_);
+    comb_ = std::move(comb);
+}
+
 template <class Hash>
 inline bool SM2PublicKey<Hash>::verify(const std::uint8_t  sig_rs[64],
                                        const std::uint8_t* msg,
@@ -441,6 +752,79 @@ inline void SM2PublicKey<Hash>::encrypt(std::uint8_t*       ciphertext,
     *c_len = C1_len + C3_len + C2_len;
 }
 
+template <class Hash>
+inline void SM2PublicKey<Hash>::encrypt_batch(
+    std::uint8_t* const       ciphertext[],
+    std::size_t               c_len[],
+    const std::uint8_t* const plaintext[],
+    const std::size_t         p_len[],
+    std::size_t               num,
+    rng::Rng&                 rng,
+    SM2EcPC                   PC) const
+{
+    constexpr std::size_t BATCH_NUM = internal::SM2_BATCH_NUM;
+
+    internal::sm2_ec_j  J[2 * BATCH_NUM]; // [k]G, [k]P
+    internal::sm2_ec_a  A[2 * BATCH_NUM];
+    internal::sm2_num_t k;
+    std::uint8_t        _k[32];
+    std::uint8_t        x2y2[64];
+    for (std::size_t i = 0; i < num; i += BATCH_NUM)
+    {
+        std::size_t n = (num - i < BATCH_NUM) ? num - i : BATCH_NUM;
+        for (std::size_t j = 0; j < n; j++)
+        {
+            // k = random[1, n-1]
+            rng.gen(_k, 32);
+            internal::sm2_bn_from_bytes(k.bn, _k);
+            internal::sm2_bn_mod_n_sub1(k.bn);
+            internal::sm2_bn_add_uint32(k.bn, k.bn, 1);
+            internal::sm2_bn_to_bytes(_k, k.bn);
+            internal::sm2_ec_j_mul_g(J[2 * j], _k);
+            this->mul_pub_(J[2 * j + 1], _k);
+        }
+        internal::sm2_ec_j_to_a_batch(A, J, 2 * n);
+        for (std::size_t j = 0; j < n; j++)
+        {
+            std::uint8_t* C1 = ciphertext[i + j];
+            std::uint8_t* C3 = C1 + ((PC == SM2EcPC::COMPRESSED) ? 33 : 65);
+            std::uint8_t* C2 = C3 + Hash::DIGEST_SIZE;
+            // C2 = M xor KDF, an all-zero KDF output needs a new k
+            internal::sm2_ec_a_to_bytes04(x2y2, A[2 * j + 1]);
+            if (internal::sm2_kdf_xor<Hash>(C2, plaintext[i + j],
+                                            p_len[i + j], x2y2, 64))
+            {
+                this->encrypt(ciphertext[i + j], &c_len[i + j],
+                              plaintext[i + j], p_len[i + j], rng, PC);
+                continue;
+            }
+            // C3 = Hash(x2 || M || y2)
+            Hash hash;
+            hash.update(x2y2 + 0, 32);
+            hash.update(plaintext[i + j], p_len[i + j]);
+            hash.update(x2y2 + 32, 32);
+            hash.do_final(C3);
+            //
+            if (PC == SM2EcPC::UNCOMPRESSED)
+            {
+                internal::sm2_ec_a_to_bytes_uncompressed(C1, A[2 * j]);
+            }
+            else if (PC == SM2EcPC::MIX)
+            {
+                internal::sm2_ec_a_to_bytes_mix(C1, A[2 * j]);
+            }
+            else
+            {
+                internal::sm2_ec_a_to_bytes_compressed(C1, A[2 * j]);
+            }
+            c_len[i + j] = (std::size_t)(C2 - C1) + p_len[i + j];
+        }
+    }
+    memory_utils::memzero(&k, sizeof(k));
+    memory_utils::memzero(_k, sizeof(_k));
+    memory_utils::memzero(x2y2, sizeof(x2y2));
+}
+
 template <class Hash>
 inline bool SM2PublicKey<Hash>::verify_(const std::uint8_t  sig_r[32],
                                         const std::uint8_t  sig_s[32],
@@ -449,55 +833,240 @@ inline bool SM2PublicKey<Hash>::verify_(const std::uint8_t  sig_r[32],
                                         const std::uint8_t* id,
                                         std::size_t id_len) const noexcept
 {
-    std::uint8_t        Z[Hash::DIGEST_SIZE], t[32];
-    internal::sm2_num_t e, r, s, tmp;
-    internal::sm2_ec_t  sG, tP;
+    std::uint8_t       Z[Hash::DIGEST_SIZE], t[32];
+    internal::sm2_fn_t e, r;
+    internal::sm2_ec_j R, TP[internal::SM2_WNAF_A_TABLE_SIZE];
 
-    // r' in [1,n-1]?, s' in [1,n-1]?
-    internal::sm2_bn_from_bytes(r.bn, sig_r);
-    internal::sm2_bn_from_bytes(s.bn, sig_s);
-    internal::sm2_bn_from_bytes(tmp.bn, internal::SM2_CURVE_N);
-    if (internal::sm2_bn_equal_zero(r.bn) ||
-        internal::sm2_bn_cmp(r.bn, tmp.bn) >= 0 ||
-        internal::sm2_bn_equal_zero(s.bn) ||
-        internal::sm2_bn_cmp(s.bn, tmp.bn) >= 0)
+    // r' in [1,n-1]?, s' in [1,n-1]?, t = r' + s' mod n
+    if (!SM2PublicKey::parse_sig_(r, t, sig_r, sig_s))
     {
         return false;
     }
     // H(Z || M)
-    internal::sm2_compute_z<Hash>(Z, id, id_len, x_, y_);
+    this->compute_z_(Z, id, id_len);
     Hash hash;
     hash.update(Z, Hash::DIGEST_SIZE);
     hash.update(msg, msg_len);
     hash.do_final(Z);
-    // t = r' + s' mod n
-    internal::sm2_fn_from_bytes(r.fn, sig_r);
-    internal::sm2_fn_from_bytes(s.fn, sig_s);
-    internal::sm2_fn_add(tmp.fn, r.fn, s.fn);
+    internal::sm2_fn_from_bytes_ex(e, Z, Hash::DIGEST_SIZE);
+    // x1', y1' = [s']G + [t]P
+    if (comb_ == nullptr)
+    {
+        internal::sm2_wnaf_table_init(TP, P_);
+    }
+    SM2PublicKey::mul_g_add_(R, sig_s, t, comb_.get(), TP);
+    // R = e' + x1' mod n
+    return SM2PublicKey::check_r_(R, r, e);
+}
+
+template <class Hash>
+inline bool SM2PublicKey<Hash>::verify_batch(
+    bool*                     result,
+    const SM2PublicKey* const pub[],
+    const std::uint8_t* const sig_rs[],
+    const std::uint8_t* const msg[],
+    const std::size_t         msg_len[],
+    std::size_t               num,
+    const std::uint8_t*       id,
+    std::size_t               id_len)
+{
+    std::uint8_t       Z[Hash::DIGEST_SIZE], E[Hash::DIGEST_SIZE], t[32];
+    internal::sm2_fn_t e, r;
+    internal::sm2_ec_j R, TP[internal::SM2_WNAF_A_TABLE_SIZE];
+    bool               all_ok = true;
+
+    // group the signatures by key, in their order within a key
+    std::vector<std::size_t> order(num);
+    for (std::size_t i = 0; i < num; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [pub](std::size_t a, std::size_t b) {
+                         return std::less<const SM2PublicKey*>()(pub[a],
+                                                                 pub[b]);
+                     });
+    std::unique_ptr<internal::sm2_comb_table> tmp_comb;
+    for (std::size_t g = 0; g < num;)
+    {
+        const SM2PublicKey* P   = pub[order[g]];
+        std::size_t         end = g + 1;
+        while (end < num && pub[order[end]] == P)
+        {
+            end++;
+        }
+        // the comb table of P, a temporary one for a key with enough
+        // signatures, or its wNAF table
+        const internal::sm2_comb_table* comb = P->comb_.get();
+        if (comb == nullptr && end - g >= internal::SM2_COMB_BATCH_MIN)
+        {
+            if (tmp_comb == nullptr)
+            {
+                tmp_comb = std::make_unique<internal::sm2_comb_table>();
+            }
+            internal::sm2_comb_table_init(tmp_comb.get(), P->P_);
+            comb = tmp_comb.get();
+        }
+        else if (comb == nullptr)
+        {
+            internal::sm2_wnaf_table_init(TP, P->P_);
+        }
+        P->compute_z_(Z, id, id_len);
+        for (; g < end; g++)
+        {
+            std::size_t         i     = order[g];
+            const std::uint8_t* sig_r = sig_rs[i];
+            const std::uint8_t* sig_s = sig_rs[i] + 32;
+            result[i]                 = false;
+            if (!SM2PublicKey::parse_sig_(r, t, sig_r, sig_s))
+            {
+                all_ok = false;
+                continue;
+            }
+            Hash hash;
+            hash.update(Z, Hash::DIGEST_SIZE);
+            hash.update(msg[i], msg_len[i]);
+            hash.do_final(E);
+            internal::sm2_fn_from_bytes_ex(e, E, Hash::DIGEST_SIZE);
+            SM2PublicKey::mul_g_add_(R, sig_s, t, comb, TP);
+            result[i] = SM2PublicKey::check_r_(R, r, e);
+            all_ok    = all_ok && result[i];
+        }
+    }
+    return all_ok;
+}
+
+template <class Hash>
+inline void SM2PublicKey<Hash>::mul_g_add_(
+    internal::sm2_ec_j              R,
+    const std::uint8_t              s[32],
+    const std::uint8_t              t[32],
+    const internal::sm2_comb_table* comb,
+    const internal::sm2_ec_j        TP[]) noexcept
+{
+    if (comb != nullptr)
+    {
+        internal::sm2_ec_j sG;
+        internal::sm2_ec_j_mul_g(sG, s);
+        internal::sm2_ec_j_mul_comb(R, t, comb);
+        internal::sm2_ec_j_add(R, sG, R);
+    }
+    else
+    {
+        internal::sm2_ec_j_mul_g_add_mul_table(R, s, t, TP);
+    }
+}
+
+template <class Hash>
+inline bool SM2PublicKey<Hash>::parse_sig_(
+    internal::sm2_fn_t r,
+    std::uint8_t       t[32],
+    const std::uint8_t sig_r[32],
+    const std::uint8_t sig_s[32]) noexcept
+{
+    internal::sm2_num_t rr, ss, tmp;
+    internal::sm2_bn_from_bytes(rr.bn, sig_r);
+    internal::sm2_bn_from_bytes(ss.bn, sig_s);
+    internal::sm2_bn_from_bytes(tmp.bn, internal::SM2_CURVE_N);
+    if (internal::sm2_bn_equal_zero(rr.bn) ||
+        internal::sm2_bn_cmp(rr.bn, tmp.bn) >= 0 ||
+        internal::sm2_bn_equal_zero(ss.bn) ||
+        internal::sm2_bn_cmp(ss.bn, tmp.bn) >= 0)
+    {
+        return false;
+    }
+    internal::sm2_fn_from_bytes(r, sig_r);
+    internal::sm2_fn_from_bytes(ss.fn, sig_s);
+    internal::sm2_fn_add(tmp.fn, r, ss.fn);
     if (internal::sm2_fn_equal_zero(tmp.fn))
     {
         return false;
     }
     internal::sm2_fn_to_bytes(t, tmp.fn);
-    // x1', y1' = [s']G + [t]P
-    internal::sm2_fp_from_bytes(tP.a[0], x_);
-    internal::sm2_fp_from_bytes(tP.a[1], y_);
-    internal::sm2_ec_j_mul_g(sG.j, sig_s);
-    internal::sm2_ec_j_mul_a(tP.j, t, tP.a);
-    internal::sm2_ec_j_add(tP.j, sG.j, tP.j);
-    internal::sm2_ec_j_to_a(tP.a, tP.j);
-    // R = e' + x1' mod n
-    internal::sm2_fn_from_fp(tmp.fn, tP.a[0]);
-    internal::sm2_fn_from_bytes_ex(e.fn, Z, Hash::DIGEST_SIZE);
-    internal::sm2_fn_add(tmp.fn, e.fn, tmp.fn);
-    if (internal::sm2_fn_equal(tmp.fn, r.fn))
+    return true;
+}
+
+template <class Hash>
+inline bool SM2PublicKey<Hash>::check_r_(const internal::sm2_ec_j R,
+                                         const internal::sm2_fn_t r,
+                                         const internal::sm2_fn_t e) noexcept
+{
+    // p - n
+    static const std::uint8_t P_SUB_N[32] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //
+        0x8D, 0xFC, 0x20, 0x93, 0xDE, 0x39, 0xFA, 0xD5, //
+        0xAC, 0x44, 0x0B, 0xF6, 0xC6, 0x2A, 0xBE, 0xDC, //
+    };
+    internal::sm2_num_t v, w, bound;
+    internal::sm2_fp_t  x, zz, n;
+    if (internal::sm2_ec_j_is_inf(R))
+    {
+        return false;
+    }
+    // x1' = X / Z^2, x1' mod n = r' - e' = v, so x1' is v or v + n (< p)
+    internal::sm2_fn_sub(v.fn, r, e);
+    internal::sm2_fn_to_fp(x, v.fn);
+    internal::sm2_fp_sqr(zz, R[2]);
+    internal::sm2_fp_mul(x, x, zz);
+    if (internal::sm2_fp_equal(x, R[0]))
     {
         return true;
     }
-    else
+    internal::sm2_fn_to_bn(w.bn, v.fn);
+    internal::sm2_bn_from_bytes(bound.bn, P_SUB_N);
+    if (internal::sm2_bn_cmp(w.bn, bound.bn) >= 0)
     {
         return false;
     }
+    internal::sm2_fp_from_bn(x, w.bn);
+    internal::sm2_fp_from_bytes(n, internal::SM2_CURVE_N);
+    internal::sm2_fp_add(x, x, n);
+    internal::sm2_fp_mul(x, x, zz);
+    return internal::sm2_fp_equal(x, R[0]);
+}
+
+template <class Hash>
+inline void SM2PublicKey<Hash>::cache_pub_() noexcept
+{
+    internal::sm2_compute_z<Hash>(z_, internal::SM2_DEFAULT_ID,
+                                  internal::SM2_DEFAULT_ID_LEN, x_, y_);
+    z_cache_.clear();
+    comb_.reset();
+}
+
+template <class Hash>
+inline void SM2PublicKey<Hash>::compute_z_(std::uint8_t z[Hash::DIGEST_SIZE],
+                                           const std::uint8_t* id,
+                                           std::size_t         id_len) const
+{
+    if (id_len == internal::SM2_DEFAULT_ID_LEN &&
+        std::memcmp(id, internal::SM2_DEFAULT_ID, id_len) == 0)
+    {
+        std::memcpy(z, z_, Hash::DIGEST_SIZE);
+        return;
+    }
+    if (z_cache_.find(z, id, id_len))
+    {
+        return;
+    }
+    internal::sm2_compute_z<Hash>(z, id, id_len, x_, y_);
+    z_cache_.insert(z, id, id_len);
+}
+
+template <class Hash>
+inline void SM2PublicKey<Hash>::mul_pub_(
+    internal::sm2_ec_j R,
+    const std::uint8_t k[32]) const noexcept
+{
+    if (comb_ != nullptr)
+    {
+        internal::sm2_ec_j_mul_comb(R, k, comb_.get());
+    }
+    else
+    {
+        internal::sm2_ec_j_mul_a(R, k, P_);
+    }
 }
 
 template <class Hash>
@@ -529,7 +1098,7 @@ retry:
     internal::sm2_ec_j_mul_g(kG.j, _k);
     internal::sm2_ec_j_to_a(kG.a, kG.j);
     // x2,y2 = [k]P
-    internal::sm2_ec_j_mul_a(kP.j, _k, P_);
+    this->mul_pub_(kP.j, _k);
     internal::sm2_ec_j_to_a(kP.a, kP.j);
     internal::sm2_ec_a_to_bytes04(x2y2, kP.a);
     // C2 = M xor KDF
@@ -592,6 +1161,48 @@ inline void SM2PrivateKey<Hash>::gen_priv(rng::Rng& rng)
     internal::sm2_ec_a_cpy(pub_.P_, dG.a);
     internal::sm2_fp_to_bytes(pub_.x_, dG.a[0]);
     internal::sm2_fp_to_bytes(pub_.y_, dG.a[1]);
+    pub_.cache_pub_();
+    this->cache_priv_();
+    memory_utils::memzero(priv_key, sizeof(priv_key));
+    memory_utils::memzero(d, sizeof(d));
+}
+
+template <class Hash>
+inline void SM2PrivateKey<Hash>::gen_priv_batch(SM2PrivateKey keys[],
+                                                std::size_t   num,
+                                                rng::Rng&     rng)
+{
+    constexpr std::size_t BATCH_NUM = internal::SM2_BATCH_NUM;
+
+    internal::sm2_ec_j dG[BATCH_NUM];
+    internal::sm2_ec_a P[BATCH_NUM];
+    internal::sm2_bn_t d;
+    for (std::size_t i = 0; i < num; i += BATCH_NUM)
+    {
+        std::size_t n = (num - i < BATCH_NUM) ? num - i : BATCH_NUM;
+        for (std::size_t j = 0; j < n; j++)
+        {
+            SM2PrivateKey& key = keys[i + j];
+            // gen priv_key, [1, n-2]
+            rng.gen(key.priv_, 32);
+            internal::sm2_bn_from_bytes(d, key.priv_);
+            internal::sm2_bn_mod_n_sub1(d);
+            internal::sm2_bn_add_uint32(d, d, 1);
+            internal::sm2_bn_to_bytes(key.priv_, d);
+            internal::sm2_ec_j_mul_g(dG[j], key.priv_); // never inf
+        }
+        internal::sm2_ec_j_to_a_batch(P, dG, n);
+        for (std::size_t j = 0; j < n; j++)
+        {
+            SM2PrivateKey& key = keys[i + j];
+            internal::sm2_ec_a_cpy(key.pub_.P_, P[j]);
+            internal::sm2_fp_to_bytes(key.pub_.x_, P[j][0]);
+            internal::sm2_fp_to_bytes(key.pub_.y_, P[j][1]);
+            key.pub_.cache_pub_();
+            key.cache_priv_();
+        }
+    }
+    memory_utils::memzero(d, sizeof(d));
 }
 
 template <class Hash>
@@ -602,10 +1213,16 @@ inline void SM2PrivateKey<Hash>::set_priv(const std::uint8_t priv_key[32])
     internal::sm2_bn_from_bytes(d, priv_key);
     internal::sm2_bn_cpy(t, d);
     internal::sm2_bn_mod_n_sub1(t);
-    if (internal::sm2_bn_equal_zero(d) || internal::sm2_bn_cmp(d, t) != 0)
+    bool valid = !internal::sm2_bn_equal_zero(d) &&
+                 internal::sm2_bn_cmp(d, t) == 0;
+    memory_utils::memzero(d, sizeof(d));
+    memory_utils::memzero(t, sizeof(t));
+    if (!valid)
     {
         throw std::runtime_error("invalid sm2 PrivateKey");
     }
+    // the old key is cleared before the new one is derived
+    this->clear_priv_();
     std::memcpy(priv_, priv_key, 32);
     // set pub
     internal::sm2_ec_j dG;
@@ -613,6 +1230,8 @@ inline void SM2PrivateKey<Hash>::set_priv(const std::uint8_t priv_key[32])
     internal::sm2_ec_j_to_a(pub_.P_, dG);
     internal::sm2_fp_to_bytes(pub_.x_, pub_.P_[0]);
     internal::sm2_fp_to_bytes(pub_.y_, pub_.P_[1]);
+    pub_.cache_pub_();
+    this->cache_priv_();
 }
 
 template <class Hash>
@@ -626,6 +1245,8 @@ inline void SM2PrivateKey<Hash>::set_priv_and_pub(
     std::memcpy(pub_.y_, pub_y, 32);
     internal::sm2_fp_from_bytes(pub_.P_[0], pub_x);
     internal::sm2_fp_from_bytes(pub_.P_[1], pub_y);
+    pub_.cache_pub_();
+    this->cache_priv_();
 }
 
 template <class Hash>
@@ -663,6 +1284,77 @@ inline void SM2PrivateKey<Hash>::sign(std::uint8_t        sig_rs[64],
     this->sign_(sig_rs + 0, sig_rs + 32, msg, msg_len, rng, id, id_len);
 }
 
+template <class Hash>
+inline void SM2PrivateKey<Hash>::sign_batch(
+    std::uint8_t* const       sig_rs[],
+    const std::uint8_t* const msg[],
+    const std::size_t         msg_len[],
+    std::size_t               num,
+    rng::Rng&                 rng,
+    const std::uint8_t*       id,
+    std::size_t               id_len) const
+{
+    constexpr std::size_t BATCH_NUM = internal::SM2_BATCH_NUM;
+
+    std::uint8_t         Z[Hash::DIGEST_SIZE], E[Hash::DIGEST_SIZE];
+    std::uint8_t         _k[BATCH_NUM][32];
+    internal::sm2_ec_j   kG[BATCH_NUM];
+    internal::sm2_ec_a   kGa[BATCH_NUM];
+    internal::sm2_num_t  e, r, s, k;
+    internal::sm2_num_t& tmp = e;
+
+    pub_.compute_z_(Z, id, id_len);
+    for (std::size_t i = 0; i < num; i += BATCH_NUM)
+    {
+        std::size_t n = (num - i < BATCH_NUM) ? num - i : BATCH_NUM;
+        for (std::size_t j = 0; j < n; j++)
+        {
+            // k = random[1, n-1]
+            rng.gen(_k[j], 32);
+            internal::sm2_bn_from_bytes(k.bn, _k[j]);
+            internal::sm2_bn_mod_n_sub1(k.bn);
+            internal::sm2_bn_add_uint32(k.bn, k.bn, 1);
+            internal::sm2_bn_to_bytes(_k[j], k.bn);
+            // x1,y1 = [k]G
+            internal::sm2_ec_j_mul_g(kG[j], _k[j]);
+        }
+        internal::sm2_ec_j_to_a_batch(kGa, kG, n);
+        for (std::size_t j = 0; j < n; j++)
+        {
+            std::uint8_t* sig_r = sig_rs[i + j];
+            std::uint8_t* sig_s = sig_rs[i + j] + 32;
+            // e = H(Z || M)
+            Hash hash;
+            hash.update(Z, Hash::DIGEST_SIZE);
+            hash.update(msg[i + j], msg_len[i + j]);
+            hash.do_final(E);
+            // r = e + x1 mod n
+            internal::sm2_fn_from_bytes_ex(e.fn, E, Hash::DIGEST_SIZE);
+            internal::sm2_fn_from_fp(r.fn, kGa[j][0]);
+            internal::sm2_fn_add(r.fn, e.fn, r.fn);
+            // s = (1+da)^-1 * (k - r * da) mod n
+            internal::sm2_fn_from_bytes(k.fn, _k[j]);
+            internal::sm2_fn_add(tmp.fn, r.fn, k.fn);
+            bool retry = internal::sm2_fn_equal_zero(r.fn) ||
+                         internal::sm2_fn_equal_zero(tmp.fn);
+            internal::sm2_fn_mul(tmp.fn, r.fn, d_);
+            internal::sm2_fn_sub(k.fn, k.fn, tmp.fn);
+            internal::sm2_fn_mul(s.fn, d1_inv_, k.fn);
+            // if r=0 or r+k=n or s=0, sign again with a new k
+            if (retry || internal::sm2_fn_equal_zero(s.fn))
+            {
+                this->sign_(sig_r, sig_s, msg[i + j], msg_len[i + j], rng, id,
+                            id_len);
+                continue;
+            }
+            internal::sm2_fn_to_bytes(sig_r, r.fn);
+            internal::sm2_fn_to_bytes(sig_s, s.fn);
+        }
+    }
+    memory_utils::memzero(_k, sizeof(_k));
+    memory_utils::memzero(&k, sizeof(k));
+}
+
 template <class Hash>
 inline bool SM2PrivateKey<Hash>::verify(const std::uint8_t  sig_rs[64],
                                         const std::uint8_t* msg,
@@ -748,12 +1440,12 @@ inline void SM2PrivateKey<Hash>::sign_(std::uint8_t        sig_r[32],
                                        std::size_t         id_len) const
 {
     std::uint8_t         Z[Hash::DIGEST_SIZE];
-    internal::sm2_num_t  e, r, s, da, k;
+    internal::sm2_num_t  e, r, s, k;
     internal::sm2_ec_t   kG;
     internal::sm2_num_t& tmp = e;
 
     std::uint8_t _k[32];
-    internal::sm2_compute_z<Hash>(Z, id, id_len, pub_.x_, pub_.y_);
+    pub_.compute_z_(Z, id, id_len);
 
     Hash hash;
     hash.update(Z, Hash::DIGEST_SIZE);
@@ -783,13 +1475,9 @@ retry:
         goto retry;
     }
     // s = (1+da)^-1 * (k - r * da) mod n
-    internal::sm2_fn_from_bytes(da.fn, priv_);
-    internal::sm2_fn_set_one(s.fn);
-    internal::sm2_fn_add(s.fn, s.fn, da.fn);
-    internal::sm2_fn_inv(s.fn, s.fn);
-    internal::sm2_fn_mul(tmp.fn, r.fn, da.fn);
+    internal::sm2_fn_mul(tmp.fn, r.fn, d_);
     internal::sm2_fn_sub(k.fn, k.fn, tmp.fn);
-    internal::sm2_fn_mul(s.fn, s.fn, k.fn);
+    internal::sm2_fn_mul(s.fn, d1_inv_, k.fn);
     if (internal::sm2_fn_equal_zero(s.fn))
     {
         goto retry;
@@ -799,6 +1487,24 @@ retry:
     internal::sm2_fn_to_bytes(sig_s, s.fn);
 }
 
+template <class Hash>
+inline void SM2PrivateKey<Hash>::cache_priv_() noexcept
+{
+    // d in [1, n-2], so 1 + d is never zero mod n
+    internal::sm2_fn_from_bytes(d_, priv_);
+    internal::sm2_fn_set_one(d1_inv_);
+    internal::sm2_fn_add(d1_inv_, d1_inv_, d_);
+    internal::sm2_fn_inv(d1_inv_, d1_inv_);
+}
+
+template <class Hash>
+inline void SM2PrivateKey<Hash>::clear_priv_() noexcept
+{
+    memory_utils::memzero(priv_, sizeof(priv_));
+    memory_utils::memzero(d_, sizeof(d_));
+    memory_utils::memzero(d1_inv_, sizeof(d1_inv_));
+}
+
 template <class Hash>
 inline void SM2PrivateKey<Hash>::decrypt_(std::uint8_t*       plaintext,
                                           std::size_t*        p_len,
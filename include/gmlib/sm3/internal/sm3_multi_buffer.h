@@ -0,0 +1,281 @@
+#ifndef SM3_INTERNAL_SM3_MULTI_BUFFER_H
+#define SM3_INTERNAL_SM3_MULTI_BUFFER_H
+
+#include <gmlib/memory_utils/endian.h>
+#include <gmlib/sm3/internal/sm3_const.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(CPU_FLAG_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace sm3::internal::multi_buffer {
+
+/**
+ * @brief   message number compressed together, one message per 32-bit lane
+ */
+constexpr std::size_t SM3_LANE_NUM = 8;
+
+/**
+ * @brief   SM3 state of SM3_LANE_NUM messages, state[i][lane]
+ */
+typedef struct Sm3MultiBufferCTX
+{
+    alignas(32) std::uint32_t state[8][SM3_LANE_NUM];
+} Sm3MultiBufferCTX;
+
+#if defined(CPU_FLAG_AVX2)
+
+/**
+ * @brief   SM3_LANE_NUM x 32-bit words in one AVX2 register
+ */
+struct Vec
+{
+    __m256i v;
+
+    static Vec load(const std::uint32_t* p) noexcept
+    {
+        return {_mm256_load_si256((const __m256i*)p)};
+    }
+
+    static void store(std::uint32_t* p, Vec a) noexcept
+    {
+        _mm256_store_si256((__m256i*)p, a.v);
+    }
+
+    static Vec set1(std::uint32_t n) noexcept
+    {
+        return {_mm256_set1_epi32((int)n)};
+    }
+
+    friend Vec operator+(Vec a, Vec b) noexcept
+    {
+        return {_mm256_add_epi32(a.v, b.v)};
+    }
+
+    friend Vec operator^(Vec a, Vec b) noexcept
+    {
+        return {_mm256_xor_si256(a.v, b.v)};
+    }
+
+    friend Vec operator&(Vec a, Vec b) noexcept
+    {
+        return {_mm256_and_si256(a.v, b.v)};
+    }
+
+    friend Vec operator|(Vec a, Vec b) noexcept
+    {
+        return {_mm256_or_si256(a.v, b.v)};
+    }
+
+    // ~a & b
+    static Vec andnot(Vec a, Vec b) noexcept
+    {
+        return {_mm256_andnot_si256(a.v, b.v)};
+    }
+
+    template <int N>
+    static Vec rotl(Vec a) noexcept
+    {
+        return {_mm256_or_si256(_mm256_slli_epi32(a.v, N),
+                                _mm256_srli_epi32(a.v, 32 - N))};
+    }
+};
+
+#else
+
+/**
+ * @brief   SM3_LANE_NUM x 32-bit words, lane-wise loops
+ */
+struct Vec
+{
+    std::uint32_t v[SM3_LANE_NUM];
+
+    static Vec load(const std::uint32_t* p) noexcept
+    {
+        Vec r;
+        for (std::size_t i = 0; i < SM3_LANE_NUM; i++)
+        {
+            r.v[i] = p[i];
+        }
+        return r;
+    }
+
+    static void store(std::uint32_t* p, Vec a) noexcept
+    {
+        for (std::size_t i = 0; i < SM3_LANE_NUM; i++)
+        {
+            p[i] = a.v[i];
+        }
+    }
+
+    static Vec set1(std::uint32_t n) noexcept
+    {
+        Vec r;
+        for (std::size_t i = 0; i < SM3_LANE_NUM; i++)
+        {
+            r.v[i] = n;
+        }
+        return r;
+    }
+
+#define SM3_MB_VEC_OP(op)                               \
+    friend Vec operator op(Vec a, Vec b) noexcept       \
+    {                                                   \
+        for (std::size_t i = 0; i < SM3_LANE_NUM; i++)  \
+        {                                               \
+            a.v[i] = a.v[i] op b.v[i];                  \
+        }                                               \
+        return a;                                       \
+    }
+
+    SM3_MB_VEC_OP(+)
+    SM3_MB_VEC_OP(^)
+    SM3_MB_VEC_OP(&)
+    SM3_MB_VEC_OP(|)
+
+#undef SM3_MB_VEC_OP
+
+    // ~a & b
+    static Vec andnot(Vec a, Vec b) noexcept
+    {
+        for (std::size_t i = 0; i < SM3_LANE_NUM; i++)
+        {
+            a.v[i] = ~a.v[i] & b.v[i];
+        }
+        return a;
+    }
+
+    template <int N>
+    static Vec rotl(Vec a) noexcept
+    {
+        for (std::size_t i = 0; i < SM3_LANE_NUM; i++)
+        {
+            a.v[i] = (a.v[i] << N) | (a.v[i] >> (32 - N));
+        }
+        return a;
+    }
+};
+
+#endif
+
+static inline Vec sm3_p0(Vec x) noexcept
+{
+    return x ^ Vec::rotl<9>(x) ^ Vec::rotl<17>(x);
+}
+
+static inline Vec sm3_p1(Vec x) noexcept
+{
+    return x ^ Vec::rotl<15>(x) ^ Vec::rotl<23>(x);
+}
+
+/**
+ * @brief           set the state of one lane to the SM3 IV
+ */
+static inline void sm3_multi_buffer_init_lane(Sm3MultiBufferCTX* ctx,
+                                              std::size_t lane) noexcept
+{
+    for (int i = 0; i < 8; i++)
+    {
+        ctx->state[i][lane] = SM3_IV[i];
+    }
+}
+
+/**
+ * @brief           store the state of one lane as a 32-byte digest
+ */
+static inline void sm3_multi_buffer_get_digest(const Sm3MultiBufferCTX* ctx,
+                                               std::size_t              lane,
+                                               std::uint8_t digest[32]) noexcept
+{
+    for (int i = 0; i < 8; i++)
+    {
+        memory_utils::store32_be(digest + 4 * i, ctx->state[i][lane]);
+    }
+}
+
+/**
+ * @brief           compress one block in every lane
+ * @param ctx       multi-buffer state
+ * @param M         message words M[i][lane], 32-bytes aligned
+ */
+static inline void sm3_multi_buffer_compress_words(
+    Sm3MultiBufferCTX*  ctx,
+    const std::uint32_t M[16][SM3_LANE_NUM]) noexcept
+{
+    Vec W[68];
+    for (int i = 0; i < 16; i++)
+    {
+        W[i] = Vec::load(M[i]);
+    }
+    for (int i = 16; i < 68; i++)
+    {
+        W[i] = sm3_p1(W[i - 16] ^ W[i - 9] ^ Vec::rotl<15>(W[i - 3])) ^
+               Vec::rotl<7>(W[i - 13]) ^ W[i - 6];
+    }
+    Vec A = Vec::load(ctx->state[0]), B = Vec::load(ctx->state[1]);
+    Vec C = Vec::load(ctx->state[2]), D = Vec::load(ctx->state[3]);
+    Vec E = Vec::load(ctx->state[4]), F = Vec::load(ctx->state[5]);
+    Vec G = Vec::load(ctx->state[6]), H = Vec::load(ctx->state[7]);
+    for (int i = 0; i < 64; i++)
+    {
+        Vec a12 = Vec::rotl<12>(A);
+        Vec ss1 = Vec::rotl<7>(a12 + E + Vec::set1(SM3_T[i]));
+        Vec ss2 = ss1 ^ a12;
+        Vec ff, gg;
+        if (i < 16)
+        {
+            ff = A ^ B ^ C;
+            gg = E ^ F ^ G;
+        }
+        else
+        {
+            ff = (A & B) | (A & C) | (B & C);
+            gg = (E & F) | Vec::andnot(E, G);
+        }
+        Vec tt1 = ff + D + ss2 + (W[i] ^ W[i + 4]);
+        Vec tt2 = gg + H + ss1 + W[i];
+        D = C, C = Vec::rotl<9>(B), B = A, A = tt1;
+        H = G, G = Vec::rotl<19>(F), F = E, E = sm3_p0(tt2);
+    }
+    Vec::store(ctx->state[0], A ^ Vec::load(ctx->state[0]));
+    Vec::store(ctx->state[1], B ^ Vec::load(ctx->state[1]));
+    Vec::store(ctx->state[2], C ^ Vec::load(ctx->state[2]));
+    Vec::store(ctx->state[3], D ^ Vec::load(ctx->state[3]));
+    Vec::store(ctx->state[4], E ^ Vec::load(ctx->state[4]));
+    Vec::store(ctx->state[5], F ^ Vec::load(ctx->state[5]));
+    Vec::store(ctx->state[6], G ^ Vec::load(ctx->state[6]));
+    Vec::store(ctx->state[7], H ^ Vec::load(ctx->state[7]));
+}
+
+/**
+ * @brief           compress block_num blocks in every lane
+ * @param ctx       multi-buffer state
+ * @param data      data[j] is 64 x block_num bytes of lane j
+ * @param block_num block number of each lane
+ */
+static inline void sm3_multi_buffer_compress(
+    Sm3MultiBufferCTX*        ctx,
+    const std::uint8_t* const data[SM3_LANE_NUM],
+    std::size_t               block_num) noexcept
+{
+    alignas(32) std::uint32_t M[16][SM3_LANE_NUM];
+    for (std::size_t n = 0; n < block_num; n++)
+    {
+        for (std::size_t j = 0; j < SM3_LANE_NUM; j++)
+        {
+            const std::uint8_t* block = data[j] + 64 * n;
+            for (int i = 0; i < 16; i++)
+            {
+                M[i][j] = memory_utils::load32_be(block + 4 * i);
+            }
+        }
+        sm3_multi_buffer_compress_words(ctx, M);
+    }
+}
+
+} // namespace sm3::internal::multi_buffer
+
+#endif
@@ -0,0 +1,170 @@
+#if defined(CPU_FLAG_SSSE3) || defined(CPU_FLAG_AVX2)
+#ifndef SM3_INTERNAL_SM3_SSSE3_H
+#define SM3_INTERNAL_SM3_SSSE3_H
+
+#include <gmlib/memory_utils/endian.h>
+#include <gmlib/sm3/internal/sm3_const.h>
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace sm3::internal::ssse3 {
+
+constexpr std::size_t SM3_BLOCK_SIZE        = 64;
+constexpr std::size_t SM3_DIGEST_SIZE       = 32;
+constexpr std::size_t SM3_SECURITY_STRENGTH = 16;
+
+typedef struct Sm3CTX
+{
+    std::uint32_t state[8];
+    std::uint64_t data_bits;
+} Sm3CTX;
+
+static inline std::uint32_t rotl(std::uint32_t x, int n) noexcept
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+template <int N>
+static inline __m128i mm_rotl_epi32(__m128i x) noexcept
+{
+    return _mm_or_si128(_mm_slli_epi32(x, N), _mm_srli_epi32(x, 32 - N));
+}
+
+static inline __m128i mm_sm3_p1(__m128i x) noexcept
+{
+    return _mm_xor_si128(
+        x, _mm_xor_si128(mm_rotl_epi32<15>(x), mm_rotl_epi32<23>(x)));
+}
+
+/**
+ * @brief       message expansion of one block, 4 words per step
+ * @details     W[j] needs W[j-3], so the 4th word of a step is first
+ *              computed without W[j] and fixed afterwards, P1 being linear
+ */
+static inline void sm3_expand(std::uint32_t       W[68],
+                              std::uint32_t       W1[64],
+                              const std::uint8_t* block) noexcept
+{
+    const __m128i BSWAP32 =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (int i = 0; i < 4; i++)
+    {
+        __m128i m = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+        _mm_storeu_si128((__m128i*)(W + 4 * i), _mm_shuffle_epi8(m, BSWAP32));
+    }
+    for (int j = 16; j < 68; j += 4)
+    {
+        // W[j-3], W[j-2], W[j-1], 0
+        __m128i z = _mm_srli_si128(_mm_loadu_si128((__m128i*)(W + j - 4)), 4);
+        __m128i t = _mm_xor_si128(_mm_loadu_si128((__m128i*)(W + j - 16)),
+                                  _mm_loadu_si128((__m128i*)(W + j - 9)));
+        t         = mm_sm3_p1(_mm_xor_si128(t, mm_rotl_epi32<15>(z)));
+        t         = _mm_xor_si128(
+            t, mm_rotl_epi32<7>(_mm_loadu_si128((__m128i*)(W + j - 13))));
+        t = _mm_xor_si128(t, _mm_loadu_si128((__m128i*)(W + j - 6)));
+        // add the missing P1(W[j] <<< 15) to W[j+3]
+        __m128i u = mm_rotl_epi32<15>(_mm_slli_si128(t, 12));
+        t         = _mm_xor_si128(t, mm_sm3_p1(u));
+        _mm_storeu_si128((__m128i*)(W + j), t);
+    }
+    for (int j = 0; j < 64; j += 4)
+    {
+        __m128i w = _mm_xor_si128(_mm_loadu_si128((__m128i*)(W + j)),
+                                  _mm_loadu_si128((__m128i*)(W + j + 4)));
+        _mm_storeu_si128((__m128i*)(W1 + j), w);
+    }
+}
+
+#define SM3_SSSE3_ROUND(j, FF, GG)                                  \
+    do                                                              \
+    {                                                               \
+        std::uint32_t a12 = rotl(A, 12);                            \
+        std::uint32_t ss1 = rotl(a12 + E + SM3_T[j], 7);            \
+        std::uint32_t tt1 = (FF) + D + (ss1 ^ a12) + W1[j];         \
+        std::uint32_t tt2 = (GG) + H + ss1 + W[j];                  \
+        D = C, C = rotl(B, 9), B = A, A = tt1;                      \
+        H = G, G = rotl(F, 19), F = E;                              \
+        E = tt2 ^ rotl(tt2, 9) ^ rotl(tt2, 17);                     \
+    } while (0)
+
+static inline void sm3_compress(std::uint32_t       state[8],
+                                const std::uint8_t* in,
+                                std::size_t         block_num) noexcept
+{
+    alignas(16) std::uint32_t W[68];
+    alignas(16) std::uint32_t W1[64];
+    for (; block_num; block_num--, in += SM3_BLOCK_SIZE)
+    {
+        sm3_expand(W, W1, in);
+        std::uint32_t A = state[0], B = state[1], C = state[2], D = state[3];
+        std::uint32_t E = state[4], F = state[5], G = state[6], H = state[7];
+        for (int j = 0; j < 16; j++)
+        {
+            SM3_SSSE3_ROUND(j, A ^ B ^ C, E ^ F ^ G);
+        }
+        for (int j = 16; j < 64; j++)
+        {
+            SM3_SSSE3_ROUND(j, (A & B) | (A & C) | (B & C),
+                            (E & F) | (~E & G));
+        }
+        state[0] ^= A, state[1] ^= B, state[2] ^= C, state[3] ^= D;
+        state[4] ^= E, state[5] ^= F, state[6] ^= G, state[7] ^= H;
+    }
+}
+
+#undef SM3_SSSE3_ROUND
+
+static inline void sm3_reset(Sm3CTX* ctx) noexcept
+{
+    std::memcpy(ctx->state, SM3_IV, sizeof(SM3_IV));
+    ctx->data_bits = 0;
+}
+
+static inline void sm3_init(Sm3CTX* ctx) noexcept
+{
+    sm3_reset(ctx);
+}
+
+static inline int sm3_update_blocks(Sm3CTX*             ctx,
+                                    const std::uint8_t* in,
+                                    std::size_t         block_num) noexcept
+{
+    sm3_compress(ctx->state, in, block_num);
+    ctx->data_bits += (std::uint64_t)block_num * SM3_BLOCK_SIZE * 8;
+    return 0;
+}
+
+static inline int sm3_final_block(Sm3CTX*             ctx,
+                                  std::uint8_t        digest[32],
+                                  const std::uint8_t* in,
+                                  std::size_t         inl) noexcept
+{
+    if (inl >= SM3_BLOCK_SIZE)
+    {
+        return -1;
+    }
+    std::uint8_t buf[2 * SM3_BLOCK_SIZE] = {0};
+    std::size_t  block_num = (inl + 9 <= SM3_BLOCK_SIZE) ? 1 : 2;
+    if (inl != 0)
+    {
+        std::memcpy(buf, in, inl);
+    }
+    buf[inl] = 0x80;
+    memory_utils::store64_be(buf + block_num * SM3_BLOCK_SIZE - 8,
+                             ctx->data_bits + inl * 8);
+    sm3_compress(ctx->state, buf, block_num);
+    for (int i = 0; i < 8; i++)
+    {
+        memory_utils::store32_be(digest + 4 * i, ctx->state[i]);
+    }
+    return 0;
+}
+
+} // namespace sm3::internal::ssse3
+
+#endif
+#endif
@@ -2,10 +2,16 @@
 #define SM3_SM3_H
 
 #include <gmlib/hash_lib/hash.h>
+#include <gmlib/memory_utils/endian.h>
 
 #include <stdexcept>
 
-#if defined(SUPPORT_SM3_YANG15)
+#if defined(CPU_FLAG_SSSE3) || defined(CPU_FLAG_AVX2)
+#include <gmlib/sm3/internal/sm3_ssse3.h>
+namespace sm3 {
+namespace alg = sm3::internal::ssse3;
+} // namespace sm3
+#elif defined(SUPPORT_SM3_YANG15)
 #include <gmlib/sm3/internal/sm3_yang15.h>
 namespace sm3 {
 namespace alg = sm3::internal::yang15;
@@ -23,8 +29,10 @@ namespace sm3 {
  * @brief   SM3 cryptographic hash algorithm
  * @details GB/T 32905-2016
  */
-class SM3 : public hash_lib::HashImpl<alg::SM3_BLOCK_SIZE>
+class SM3 final : public hash_lib::HashImpl<alg::SM3_BLOCK_SIZE, SM3>
 {
+    friend class hash_lib::HashImpl<alg::SM3_BLOCK_SIZE, SM3>;
+
 public:
     static constexpr const char* NAME = "SM3";
 
@@ -39,6 +47,9 @@ public:
     /// @brief SM3 Security Strength (in bytes)
     static constexpr std::size_t SECURITY_STRENGTH = alg::SM3_SECURITY_STRENGTH;
 
+    /// @brief SM3 exported state size (in bytes)
+    static constexpr std::size_t STATE_SIZE = 4 + 1 + 32 + 8 + 1 + BLOCK_SIZE;
+
 private:
     /// @brief SM3 private Context
     alg::Sm3CTX ctx_;
@@ -88,10 +99,63 @@ public:
      */
     void reset() noexcept override
     {
-        this->HashImpl<alg::SM3_BLOCK_SIZE>::reset();
+        this->HashImpl<alg::SM3_BLOCK_SIZE, SM3>::reset();
         alg::sm3_reset(&ctx_);
     }
 
+    /**
+     * @brief               export the mid-state, to resume hashing later
+     * @details             STATE_SIZE bytes, all integers big-endian:
+     *                      "SM3S" | version 0x01 | state[8] (u32) |
+     *                      hashed bits (u64) | buffered length (u8) |
+     *                      64 bytes buffered input, zero padded.
+     *                      The state holds message data, protect it
+     *                      like the message.
+     * @param[out]  state   STATE_SIZE bytes
+     */
+    void export_state(std::uint8_t state[STATE_SIZE]) const noexcept
+    {
+        std::uint8_t* p = state;
+        std::memcpy(p, "SM3S", 4), p[4] = 0x01, p += 5;
+        for (int i = 0; i < 8; i++, p += 4)
+        {
+            memory_utils::store32_be(p, ctx_.state[i]);
+        }
+        memory_utils::store64_be(p, ctx_.data_bits), p += 8;
+        std::size_t buf_size = this->buffered_size();
+        *p++                 = (std::uint8_t)buf_size;
+        std::memset(p, 0, BLOCK_SIZE);
+        std::memcpy(p, this->buffered_data(), buf_size);
+    }
+
+    /**
+     * @brief               restore a mid-state from "export_state"
+     * @param[in]   state   STATE_SIZE bytes
+     */
+    void import_state(const std::uint8_t state[STATE_SIZE])
+    {
+        const std::uint8_t* p = state;
+        if (std::memcmp(p, "SM3S", 4) != 0 || p[4] != 0x01)
+        {
+            throw std::runtime_error("invalid sm3 state");
+        }
+        p += 5;
+        std::uint32_t h[8];
+        for (int i = 0; i < 8; i++, p += 4)
+        {
+            h[i] = memory_utils::load32_be(p);
+        }
+        std::uint64_t data_bits = memory_utils::load64_be(p);
+        std::size_t   buf_size  = p[8];
+        if (data_bits % (BLOCK_SIZE * 8) != 0 || buf_size >= BLOCK_SIZE)
+        {
+            throw std::runtime_error("invalid sm3 state");
+        }
+        std::memcpy(ctx_.state, h, sizeof(h));
+        ctx_.data_bits = data_bits;
+        this->set_buffered(p + 9, buf_size);
+    }
+
 private:
     /**
      * @brief                   SM3 message update
@@ -0,0 +1,34 @@
+#ifndef SM3_SM3_FILE_H
+#define SM3_SM3_FILE_H
+
+#include <gmlib/memory_utils/mapped_file.h>
+#include <gmlib/sm3/sm3.h>
+
+namespace sm3 {
+
+/**
+ * @brief               SM3 digest of a file, read through a memory map
+ * @details             SM3 is sequential and runs on one thread, see
+ *                      sm3_tree_file for a parallel (tree) digest
+ * @param[out]  digest  32-bytes digest
+ * @param[in]   path    file path (UTF-8)
+ */
+inline void sm3_file(std::uint8_t* digest, const char* path)
+{
+    constexpr std::size_t CHUNK_SIZE = memory_utils::MAPPED_FILE_CHUNK_SIZE;
+
+    memory_utils::MappedFile file(path);
+    const std::uint8_t*      data = file.data();
+    std::size_t              len  = file.size();
+    SM3                      sm3;
+    while (len > CHUNK_SIZE)
+    {
+        sm3.update(data, CHUNK_SIZE);
+        data += CHUNK_SIZE, len -= CHUNK_SIZE;
+    }
+    sm3.do_final(digest, data, len);
+}
+
+} // namespace sm3
+
+#endif
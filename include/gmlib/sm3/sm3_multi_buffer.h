@@ -0,0 +1,338 @@
+#ifndef SM3_SM3_MULTI_BUFFER_H
+#define SM3_SM3_MULTI_BUFFER_H
+
+#include <gmlib/memory_utils/endian.h>
+#include <gmlib/memory_utils/memzero.h>
+#include <gmlib/sm3/internal/sm3_multi_buffer.h>
+#include <gmlib/sm3/sm3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace sm3 {
+
+/**
+ * @brief   one message hashed by SM3MultiBuffer
+ * @details the message is prefix (if any) followed by msg. The job, prefix
+ *          and msg have to stay alive until the job is returned by "submit"
+ *          or "flush", digest is written right before that.
+ */
+struct Sm3Job
+{
+    const std::uint8_t* prefix;  // optional 64-bytes block, or nullptr
+    const std::uint8_t* msg;     // message
+    std::size_t         msg_len; // message length (in bytes)
+    std::uint8_t*       digest;  // 32-bytes digest output
+};
+
+/**
+ * @brief   SM3 of LANE_NUM independent messages in parallel SIMD lanes
+ * @details "submit" hands a job to a free lane. Once every lane is busy it
+ *          compresses all lanes together until one of them finishes, and
+ *          returns that job, so messages of any length can be streamed
+ *          through. "flush" finishes the remaining jobs one by one.
+ */
+class SM3MultiBuffer
+{
+public:
+    static constexpr std::size_t BLOCK_SIZE  = alg::SM3_BLOCK_SIZE;
+    static constexpr std::size_t DIGEST_SIZE = alg::SM3_DIGEST_SIZE;
+    static constexpr std::size_t LANE_NUM =
+        internal::multi_buffer::SM3_LANE_NUM;
+
+private:
+    /// @brief a lane hashes up to 3 segments: prefix, full blocks and tail
+    struct Lane
+    {
+        Sm3Job*             job  = nullptr;
+        bool                done = false;
+        const std::uint8_t* seg_data[3];
+        std::size_t         seg_block[3];
+        std::size_t         seg_idx;
+        std::size_t         seg_num;
+        std::uint8_t        tail[2 * BLOCK_SIZE]; // last bytes and padding
+    };
+
+    internal::multi_buffer::Sm3MultiBufferCTX ctx_;
+    Lane                                      lanes_[LANE_NUM];
+    std::size_t                               busy_num_ = 0;
+
+public:
+    SM3MultiBuffer() noexcept = default;
+
+    SM3MultiBuffer(const SM3MultiBuffer&) = delete;
+
+    SM3MultiBuffer& operator=(const SM3MultiBuffer&) = delete;
+
+public:
+    /**
+     * @brief           hand a job to a free lane
+     * @param[in]   job job to hash
+     * @return          nullptr while a lane is still free, otherwise a
+     *                  finished job (not necessarily the submitted one)
+     */
+    Sm3Job* submit(Sm3Job* job) noexcept
+    {
+        std::size_t j = 0;
+        while (lanes_[j].job != nullptr)
+        {
+            j++;
+        }
+        this->lane_init(j, job);
+        if (++busy_num_ < LANE_NUM)
+        {
+            return nullptr;
+        }
+        return this->run();
+    }
+
+    /**
+     * @brief   finish one of the submitted jobs
+     * @return  finished job, or nullptr if no job is left
+     */
+    Sm3Job* flush() noexcept
+    {
+        if (busy_num_ == 0)
+        {
+            return nullptr;
+        }
+        return this->run();
+    }
+
+private:
+    void lane_init(std::size_t j, Sm3Job* job) noexcept
+    {
+        Lane& lane = lanes_[j];
+        lane.job   = job;
+        lane.done  = false;
+
+        std::size_t n = 0;
+        if (job->prefix != nullptr)
+        {
+            lane.seg_data[n]  = job->prefix;
+            lane.seg_block[n] = 1;
+            n++;
+        }
+        std::size_t full_len = job->msg_len / BLOCK_SIZE * BLOCK_SIZE;
+        if (full_len != 0)
+        {
+            lane.seg_data[n]  = job->msg;
+            lane.seg_block[n] = full_len / BLOCK_SIZE;
+            n++;
+        }
+        std::size_t rem = job->msg_len - full_len;
+        std::size_t tail_block = (rem + 9 <= BLOCK_SIZE) ? 1 : 2;
+        std::size_t tail_len   = tail_block * BLOCK_SIZE;
+        std::uint64_t bits     = (std::uint64_t)job->msg_len * 8;
+        if (job->prefix != nullptr)
+        {
+            bits += BLOCK_SIZE * 8;
+        }
+        if (rem != 0)
+        {
+            std::memcpy(lane.tail, job->msg + full_len, rem);
+        }
+        lane.tail[rem] = 0x80;
+        std::memset(lane.tail + rem + 1, 0, tail_len - rem - 1 - 8);
+        memory_utils::store64_be(lane.tail + tail_len - 8, bits);
+        lane.seg_data[n]  = lane.tail;
+        lane.seg_block[n] = tail_block;
+        n++;
+
+        lane.seg_idx = 0;
+        lane.seg_num = n;
+        internal::multi_buffer::sm3_multi_buffer_init_lane(&ctx_, j);
+    }
+
+    /**
+     * @brief   compress all busy lanes until one of them finishes
+     */
+    Sm3Job* run() noexcept
+    {
+        const std::uint8_t* data[LANE_NUM];
+        while (true)
+        {
+            for (Lane& lane : lanes_)
+            {
+                if (lane.job != nullptr && lane.done)
+                {
+                    Sm3Job* job = lane.job;
+                    lane.job    = nullptr;
+                    busy_num_--;
+                    return job;
+                }
+            }
+            // every busy lane runs the blocks left in its shortest segment,
+            // idle lanes hash the same data and their state is dropped
+            std::size_t         block_num = SIZE_MAX;
+            const std::uint8_t* any       = nullptr;
+            for (Lane& lane : lanes_)
+            {
+                if (lane.job != nullptr)
+                {
+                    std::size_t n = lane.seg_block[lane.seg_idx];
+                    block_num     = (n < block_num) ? n : block_num;
+                    any           = lane.seg_data[lane.seg_idx];
+                }
+            }
+            for (std::size_t j = 0; j < LANE_NUM; j++)
+            {
+                const Lane& lane = lanes_[j];
+                data[j] = (lane.job != nullptr) ? lane.seg_data[lane.seg_idx]
+                                                : any;
+            }
+            internal::multi_buffer::sm3_multi_buffer_compress(&ctx_, data,
+                                                              block_num);
+            for (std::size_t j = 0; j < LANE_NUM; j++)
+            {
+                Lane& lane = lanes_[j];
+                if (lane.job == nullptr)
+                {
+                    continue;
+                }
+                lane.seg_data[lane.seg_idx] += BLOCK_SIZE * block_num;
+                lane.seg_block[lane.seg_idx] -= block_num;
+                if (lane.seg_block[lane.seg_idx] == 0 &&
+                    ++lane.seg_idx == lane.seg_num)
+                {
+                    internal::multi_buffer::sm3_multi_buffer_get_digest(
+                        &ctx_, j, lane.job->digest);
+                    lane.done = true;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief               SM3 digest of num messages, hashed LANE_NUM at a time
+ * @param[out]  digest  num pointers to 32-bytes digest outputs
+ * @param[in]   msg     num message pointers
+ * @param[in]   msg_len num message lengths (in bytes)
+ * @param[in]   num     message number
+ */
+inline void sm3_digest_many(std::uint8_t* const       digest[],
+                            const std::uint8_t* const msg[],
+                            const std::size_t         msg_len[],
+                            std::size_t               num) noexcept
+{
+    constexpr std::size_t LANE_NUM = SM3MultiBuffer::LANE_NUM;
+
+    SM3MultiBuffer mb;
+    Sm3Job         jobs[LANE_NUM];
+    Sm3Job*        free_job[LANE_NUM];
+    std::size_t    free_num = LANE_NUM;
+    for (std::size_t j = 0; j < LANE_NUM; j++)
+    {
+        free_job[j] = &jobs[j];
+    }
+    for (std::size_t i = 0; i < num; i++)
+    {
+        Sm3Job* job = free_job[--free_num];
+        *job        = {nullptr, msg[i], msg_len[i], digest[i]};
+        Sm3Job* done = mb.submit(job);
+        if (done != nullptr)
+        {
+            free_job[free_num++] = done;
+        }
+    }
+    while (mb.flush() != nullptr)
+    {
+    }
+}
+
+/**
+ * @brief               HMAC-SM3 of num messages, each with its own key
+ * @details             the inner hash of a message is followed by its outer
+ *                      hash in the same job, so every lane stays busy
+ * @param[out]  digest  num pointers to 32-bytes MAC outputs
+ * @param[in]   key     num key pointers
+ * @param[in]   key_len num key lengths (in bytes)
+ * @param[in]   msg     num message pointers
+ * @param[in]   msg_len num message lengths (in bytes)
+ * @param[in]   num     message number
+ */
+inline void hmac_sm3_many(std::uint8_t* const       digest[],
+                          const std::uint8_t* const key[],
+                          const std::size_t         key_len[],
+                          const std::uint8_t* const msg[],
+                          const std::size_t         msg_len[],
+                          std::size_t               num)
+{
+    constexpr std::size_t LANE_NUM    = SM3MultiBuffer::LANE_NUM;
+    constexpr std::size_t BLOCK_SIZE  = SM3MultiBuffer::BLOCK_SIZE;
+    constexpr std::size_t DIGEST_SIZE = SM3MultiBuffer::DIGEST_SIZE;
+
+    SM3MultiBuffer mb;
+    Sm3Job         jobs[LANE_NUM];
+    std::uint8_t   pad[LANE_NUM][BLOCK_SIZE]; // K ^ ipad, then K ^ opad
+    bool           outer[LANE_NUM];
+    std::size_t    free_slot[LANE_NUM];
+    std::size_t    free_num = LANE_NUM;
+    for (std::size_t j = 0; j < LANE_NUM; j++)
+    {
+        free_slot[j] = j;
+    }
+
+    std::size_t next = 0;
+    Sm3Job*     done = nullptr;
+    while (true)
+    {
+        Sm3Job* job = nullptr;
+        if (done != nullptr)
+        {
+            std::size_t s = (std::size_t)(done - jobs);
+            if (!outer[s])
+            {
+                // inner digest ready, continue with the outer hash
+                for (std::size_t k = 0; k < BLOCK_SIZE; k++)
+                {
+                    pad[s][k] ^= 0x36 ^ 0x5c;
+                }
+                done->msg     = done->digest;
+                done->msg_len = DIGEST_SIZE;
+                outer[s]      = true;
+                job           = done;
+            }
+            else
+            {
+                free_slot[free_num++] = s;
+            }
+        }
+        if (job == nullptr && next < num)
+        {
+            std::size_t s = free_slot[--free_num];
+            std::memset(pad[s], 0, BLOCK_SIZE);
+            if (key_len[next] > BLOCK_SIZE)
+            {
+                SM3().do_final(pad[s], key[next], key_len[next]);
+            }
+            else if (key_len[next] != 0)
+            {
+                std::memcpy(pad[s], key[next], key_len[next]);
+            }
+            for (std::size_t k = 0; k < BLOCK_SIZE; k++)
+            {
+                pad[s][k] ^= 0x36;
+            }
+            jobs[s]  = {pad[s], msg[next], msg_len[next], digest[next]};
+            outer[s] = false;
+            job      = &jobs[s];
+            next++;
+        }
+        if (job != nullptr)
+        {
+            done = mb.submit(job);
+        }
+        else if ((done = mb.flush()) == nullptr)
+        {
+            break;
+        }
+    }
+    memory_utils::memzero(pad, sizeof(pad));
+}
+
+} // namespace sm3
+
+#endif
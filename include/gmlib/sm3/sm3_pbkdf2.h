@@ -0,0 +1,230 @@
+#ifndef SM3_SM3_PBKDF2_H
+#define SM3_SM3_PBKDF2_H
+
+#include <gmlib/hash_lib/hmac.h>
+#include <gmlib/memory_utils/endian.h>
+#include <gmlib/memory_utils/memzero.h>
+#include <gmlib/sm3/internal/sm3_multi_buffer.h>
+#include <gmlib/sm3/sm3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace sm3::internal::multi_buffer {
+
+/**
+ * @brief   one PBKDF2 output block T_index of one password
+ */
+struct Pbkdf2Block
+{
+    const std::uint8_t* password;
+    std::size_t         password_len;
+    const std::uint8_t* salt;
+    std::size_t         salt_len;
+    std::uint32_t       index;
+    std::uint8_t*       out;
+    std::size_t         out_len; // at most 32
+};
+
+/**
+ * @brief   PBKDF2-HMAC-SM3 of block_num output blocks, SM3_LANE_NUM blocks
+ *          at a time
+ * @details U_1 is computed with hash_lib::HMac. Every further iteration is
+ *          HMAC of a 32-bytes message, that is one compression from the
+ *          cached K ^ ipad state and one from the cached K ^ opad state,
+ *          both run on all lanes at once.
+ */
+static inline void sm3_pbkdf2_blocks(const Pbkdf2Block* block,
+                                     std::size_t        block_num,
+                                     std::size_t        iter)
+{
+    constexpr std::size_t BLOCK_SIZE  = 64;
+    constexpr std::size_t DIGEST_SIZE = 32;
+
+    Sm3MultiBufferCTX         ctx;
+    alignas(32) std::uint32_t M[16][SM3_LANE_NUM];
+    alignas(32) std::uint32_t IS[8][SM3_LANE_NUM]; // K ^ ipad state
+    alignas(32) std::uint32_t OS[8][SM3_LANE_NUM]; // K ^ opad state
+    alignas(32) std::uint32_t T[8][SM3_LANE_NUM];
+    std::uint8_t              K[SM3_LANE_NUM][BLOCK_SIZE];
+    std::uint8_t              U[DIGEST_SIZE];
+
+    for (; block_num != 0;)
+    {
+        std::size_t n = (block_num < SM3_LANE_NUM) ? block_num : SM3_LANE_NUM;
+
+        std::memset(K, 0, sizeof(K));
+        for (std::size_t j = 0; j < n; j++)
+        {
+            if (block[j].password_len > BLOCK_SIZE)
+            {
+                SM3().do_final(K[j], block[j].password,
+                               block[j].password_len);
+            }
+            else if (block[j].password_len != 0)
+            {
+                std::memcpy(K[j], block[j].password, block[j].password_len);
+            }
+        }
+        for (std::uint32_t pad : {0x36363636U, 0x5c5c5c5cU})
+        {
+            for (std::size_t j = 0; j < SM3_LANE_NUM; j++)
+            {
+                sm3_multi_buffer_init_lane(&ctx, j);
+                for (int i = 0; i < 16; i++)
+                {
+                    M[i][j] = memory_utils::load32_be(K[j] + 4 * i) ^ pad;
+                }
+            }
+            sm3_multi_buffer_compress_words(&ctx, M);
+            std::memcpy((pad == 0x36363636U) ? IS : OS, ctx.state,
+                        sizeof(IS));
+        }
+
+        // U_1 = HMAC(P, S || INT(i)), then M = U || padding of 96 bytes
+        std::memset(M, 0, sizeof(M));
+        for (std::size_t j = 0; j < n; j++)
+        {
+            std::uint8_t index[4];
+            memory_utils::store32_be(index, block[j].index);
+            hash_lib::HMac<SM3> hmac(block[j].password, block[j].password_len);
+            hmac.update(block[j].salt, block[j].salt_len);
+            hmac.do_final(U, index, 4);
+            for (int i = 0; i < 8; i++)
+            {
+                M[i][j] = memory_utils::load32_be(U + 4 * i);
+            }
+        }
+        for (std::size_t j = 0; j < SM3_LANE_NUM; j++)
+        {
+            M[8][j]  = 0x80000000;
+            M[15][j] = (BLOCK_SIZE + DIGEST_SIZE) * 8;
+        }
+        std::memcpy(T, M, sizeof(T));
+
+        for (std::size_t it = 1; it < iter; it++)
+        {
+            std::memcpy(ctx.state, IS, sizeof(IS));
+            sm3_multi_buffer_compress_words(&ctx, M);
+            std::memcpy(M, ctx.state, sizeof(ctx.state));
+            std::memcpy(ctx.state, OS, sizeof(OS));
+            sm3_multi_buffer_compress_words(&ctx, M);
+            std::memcpy(M, ctx.state, sizeof(ctx.state));
+            for (int i = 0; i < 8; i++)
+            {
+                for (std::size_t j = 0; j < SM3_LANE_NUM; j++)
+                {
+                    T[i][j] ^= M[i][j];
+                }
+            }
+        }
+
+        for (std::size_t j = 0; j < n; j++)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                memory_utils::store32_be(U + 4 * i, T[i][j]);
+            }
+            std::memcpy(block[j].out, U, block[j].out_len);
+        }
+        block += n, block_num -= n;
+    }
+    memory_utils::memzero(&ctx, sizeof(ctx));
+    memory_utils::memzero(M, sizeof(M));
+    memory_utils::memzero(IS, sizeof(IS));
+    memory_utils::memzero(OS, sizeof(OS));
+    memory_utils::memzero(T, sizeof(T));
+    memory_utils::memzero(K, sizeof(K));
+    memory_utils::memzero(U, sizeof(U));
+}
+
+} // namespace sm3::internal::multi_buffer
+
+namespace sm3 {
+
+/**
+ * @brief                   PBKDF2-HMAC-SM3 (RFC 8018), the output blocks
+ *                          run in parallel SIMD lanes
+ * @param[out]  out         derived key
+ * @param[in]   out_len     derived key length (in bytes)
+ * @param[in]   password    password
+ * @param[in]   password_len password length (in bytes)
+ * @param[in]   salt        salt
+ * @param[in]   salt_len    salt length (in bytes)
+ * @param[in]   iter        iteration count, at least 1
+ */
+inline void pbkdf2_hmac_sm3(std::uint8_t*       out,
+                            std::size_t         out_len,
+                            const std::uint8_t* password,
+                            std::size_t         password_len,
+                            const std::uint8_t* salt,
+                            std::size_t         salt_len,
+                            std::size_t         iter)
+{
+    using internal::multi_buffer::Pbkdf2Block;
+    if (iter == 0)
+    {
+        throw std::runtime_error("invalid pbkdf2 iteration count");
+    }
+    std::vector<Pbkdf2Block> block;
+    for (std::uint32_t i = 1; out_len != 0; i++)
+    {
+        std::size_t size = (out_len < SM3::DIGEST_SIZE) ? out_len
+                                                        : SM3::DIGEST_SIZE;
+        block.push_back({password, password_len, salt, salt_len, i, out, size});
+        out += size, out_len -= size;
+    }
+    internal::multi_buffer::sm3_pbkdf2_blocks(block.data(), block.size(),
+                                              iter);
+}
+
+/**
+ * @brief                   PBKDF2-HMAC-SM3 of num passwords, their output
+ *                          blocks all share the SIMD lanes
+ * @param[out]  out         num pointers to out_len bytes derived keys
+ * @param[in]   out_len     derived key length (in bytes)
+ * @param[in]   password    num password pointers
+ * @param[in]   password_len num password lengths (in bytes)
+ * @param[in]   salt        num salt pointers
+ * @param[in]   salt_len    num salt lengths (in bytes)
+ * @param[in]   iter        iteration count, at least 1
+ * @param[in]   num         password number
+ */
+inline void pbkdf2_hmac_sm3_many(std::uint8_t* const       out[],
+                                 std::size_t               out_len,
+                                 const std::uint8_t* const password[],
+                                 const std::size_t         password_len[],
+                                 const std::uint8_t* const salt[],
+                                 const std::size_t         salt_len[],
+                                 std::size_t               iter,
+                                 std::size_t               num)
+{
+    using internal::multi_buffer::Pbkdf2Block;
+    if (iter == 0)
+    {
+        throw std::runtime_error("invalid pbkdf2 iteration count");
+    }
+    std::vector<Pbkdf2Block> block;
+    for (std::size_t k = 0; k < num; k++)
+    {
+        std::uint8_t* p   = out[k];
+        std::size_t   len = out_len;
+        for (std::uint32_t i = 1; len != 0; i++)
+        {
+            std::size_t size = (len < SM3::DIGEST_SIZE) ? len
+                                                        : SM3::DIGEST_SIZE;
+            block.push_back({password[k], password_len[k], salt[k],
+                             salt_len[k], i, p, size});
+            p += size, len -= size;
+        }
+    }
+    internal::multi_buffer::sm3_pbkdf2_blocks(block.data(), block.size(),
+                                              iter);
+}
+
+} // namespace sm3
+
+#endif
@@ -0,0 +1,389 @@
+#ifndef SM3_SM3_TREE_H
+#define SM3_SM3_TREE_H
+
+#include <gmlib/memory_utils/mapped_file.h>
+#include <gmlib/sm3/sm3_multi_buffer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sm3 {
+
+/**
+ * @brief   SM3 tree hash, for inputs too large to hash on a single core
+ * @details the input is cut into leaves of leaf_size bytes (the last one
+ *          may be shorter, an empty input is one empty leaf). With a zero
+ *          block Z (64 bytes of 0x00):
+ *
+ *              leaf  = SM3(Z || leaf data)
+ *              node  = SM3(0x01 || left || right)
+ *
+ *          nodes are built level by level from the leaves, a node without
+ *          a right sibling moves up unchanged, the root is the digest.
+ *          Leaves are hashed by thread_num threads, each one running a
+ *          SM3MultiBuffer: the calling thread and thread_num - 1 workers,
+ *          started on the first batch and kept until destruction. The leaf
+ *          digests are kept, so a single leaf can be verified again later
+ *          without hashing the whole input.
+ *
+ *          update() gathers input in a buffer of thread_num x LANE_NUM
+ *          leaves, so every lane of every thread gets a leaf per batch.
+ *          The buffer costs thread_num x LANE_NUM x leaf_size bytes, e.g.
+ *          64 MiB for 8 threads and 1 MiB leaves; pick a smaller leaf_size
+ *          or thread_num to bound it. Input passed in whole batches is
+ *          hashed in place and never buffered.
+ */
+class SM3Tree
+{
+public:
+    static constexpr std::size_t DIGEST_SIZE = SM3MultiBuffer::DIGEST_SIZE;
+    static constexpr std::size_t DEFAULT_LEAF_SIZE = 1 << 20;
+
+private:
+    /// @brief leaves of one batch, taken one by one by the hashing threads
+    struct Batch
+    {
+        std::uint8_t*            leaf_digest;
+        const std::uint8_t*      data;
+        std::size_t              len;
+        std::size_t              leaf_num;
+        std::atomic<std::size_t> next{0};
+    };
+
+    std::size_t               leaf_size_;
+    std::size_t               thread_num_;
+    std::vector<std::uint8_t> buf_;      // batch_size_ bytes, on demand
+    std::size_t               batch_size_;
+    std::size_t               buf_size_ = 0;
+    std::vector<std::uint8_t> leaf_digest_;
+
+    std::vector<std::thread> workers_;
+    std::mutex               mtx_;
+    std::condition_variable  start_cv_, done_cv_;
+    Batch*                   batch_      = nullptr;
+    std::uint64_t            generation_ = 0; // batches handed out
+    std::size_t              running_    = 0; // workers still on batch_
+    bool                     stop_       = false;
+
+public:
+    /**
+     * @param[in]   leaf_size   leaf size (in bytes), multiple of 64
+     * @param[in]   thread_num  hashing threads, 0 for all hardware threads
+     */
+    explicit SM3Tree(std::size_t leaf_size  = DEFAULT_LEAF_SIZE,
+                     std::size_t thread_num = 0)
+        : leaf_size_(leaf_size), thread_num_(thread_num)
+    {
+        if (leaf_size == 0 || leaf_size % SM3MultiBuffer::BLOCK_SIZE != 0)
+        {
+            throw std::runtime_error("invalid sm3 tree leaf size");
+        }
+        if (thread_num_ == 0)
+        {
+            thread_num_ = std::thread::hardware_concurrency();
+            thread_num_ = (thread_num_ == 0) ? 1 : thread_num_;
+        }
+        std::size_t batch_leaf = thread_num_ * SM3MultiBuffer::LANE_NUM;
+        if (batch_leaf / SM3MultiBuffer::LANE_NUM != thread_num_ ||
+            batch_leaf > SIZE_MAX / leaf_size_)
+        {
+            throw std::runtime_error("sm3 tree batch too large");
+        }
+        batch_size_ = batch_leaf * leaf_size_;
+    }
+
+    SM3Tree(const SM3Tree&) = delete;
+
+    SM3Tree& operator=(const SM3Tree&) = delete;
+
+    ~SM3Tree()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (std::thread& th : workers_)
+        {
+            th.join();
+        }
+    }
+
+    void reset() noexcept
+    {
+        buf_size_ = 0;
+        leaf_digest_.clear();
+    }
+
+    /**
+     * @brief               absorb input, full leaves are hashed in batches
+     *                      of thread_num x LANE_NUM leaves
+     */
+    void update(const std::uint8_t* in, std::size_t inl)
+    {
+        const std::size_t batch = batch_size_;
+        while (inl != 0)
+        {
+            if (buf_size_ == 0 && inl >= batch)
+            {
+                // whole leaves straight from the input
+                std::size_t len = inl / leaf_size_ * leaf_size_;
+                this->append_leaves(in, len);
+                in += len, inl -= len;
+                continue;
+            }
+            if (buf_.size() != batch)
+            {
+                buf_.resize(batch);
+            }
+            std::size_t size = batch - buf_size_;
+            size             = (size > inl) ? inl : size;
+            std::memcpy(buf_.data() + buf_size_, in, size);
+            in += size, inl -= size, buf_size_ += size;
+            if (buf_size_ == batch)
+            {
+                this->append_leaves(buf_.data(), batch);
+                buf_size_ = 0;
+            }
+        }
+    }
+
+    /**
+     * @brief               absorb the last input and output the root
+     * @param[out]  digest  32-bytes root digest
+     */
+    void do_final(std::uint8_t*       digest,
+                  const std::uint8_t* in  = nullptr,
+                  std::size_t         inl = 0)
+    {
+        this->update(in, inl);
+        if (buf_size_ != 0 || leaf_digest_.empty())
+        {
+            this->append_leaves(buf_.data(), buf_size_);
+            buf_size_ = 0;
+        }
+        SM3Tree::root(digest, leaf_digest_.data(), this->leaf_num());
+    }
+
+    /**
+     * @brief   leaf number hashed so far
+     */
+    std::size_t leaf_num() const noexcept
+    {
+        return leaf_digest_.size() / DIGEST_SIZE;
+    }
+
+    /**
+     * @brief   leaf_num() x 32 bytes leaf digests, complete after do_final
+     */
+    const std::uint8_t* leaf_digest() const noexcept
+    {
+        return leaf_digest_.data();
+    }
+
+    /**
+     * @brief                   combine leaf digests into the root
+     * @param[out]  digest      32-bytes root digest
+     * @param[in]   leaf_digest leaf_num x 32 bytes leaf digests
+     * @param[in]   leaf_num    leaf number, at least 1
+     */
+    static void root(std::uint8_t*       digest,
+                     const std::uint8_t* leaf_digest,
+                     std::size_t         leaf_num)
+    {
+        constexpr std::size_t NODE_LEN = 1 + 2 * DIGEST_SIZE;
+
+        std::vector<std::uint8_t> level(leaf_digest,
+                                        leaf_digest + leaf_num * DIGEST_SIZE);
+        std::vector<std::uint8_t>        node;
+        std::vector<const std::uint8_t*> msg;
+        std::vector<std::size_t>         msg_len;
+        std::vector<std::uint8_t*>       out;
+        while (leaf_num > 1)
+        {
+            std::size_t pair_num = leaf_num / 2;
+            node.resize(pair_num * NODE_LEN);
+            msg.resize(pair_num), msg_len.assign(pair_num, NODE_LEN);
+            out.resize(pair_num);
+            for (std::size_t i = 0; i < pair_num; i++)
+            {
+                node[i * NODE_LEN] = 0x01;
+                std::memcpy(&node[i * NODE_LEN + 1],
+                            &level[2 * i * DIGEST_SIZE], 2 * DIGEST_SIZE);
+                msg[i] = &node[i * NODE_LEN];
+                out[i] = &level[i * DIGEST_SIZE];
+            }
+            // pairs are copied out before any digest is written
+            sm3_digest_many(out.data(), msg.data(), msg_len.data(), pair_num);
+            if (leaf_num % 2 != 0)
+            {
+                std::memmove(&level[pair_num * DIGEST_SIZE],
+                             &level[(leaf_num - 1) * DIGEST_SIZE], DIGEST_SIZE);
+            }
+            leaf_num = pair_num + leaf_num % 2;
+        }
+        std::memcpy(digest, level.data(), DIGEST_SIZE);
+    }
+
+    /**
+     * @brief                   tree hash of a memory buffer
+     * @param[out]  digest      32-bytes root digest
+     * @param[in]   data        input data, hashed in place
+     * @param[in]   len         input length (in bytes)
+     * @param[in]   leaf_size   leaf size (in bytes), multiple of 64
+     * @param[in]   thread_num  hashing threads, 0 for all hardware threads
+     */
+    static void digest(std::uint8_t*       digest,
+                       const std::uint8_t* data,
+                       std::size_t         len,
+                       std::size_t         leaf_size  = DEFAULT_LEAF_SIZE,
+                       std::size_t         thread_num = 0)
+    {
+        SM3Tree tree(leaf_size, thread_num);
+        tree.append_leaves(data, len);
+        SM3Tree::root(digest, tree.leaf_digest(), tree.leaf_num());
+    }
+
+private:
+    /**
+     * @brief   hash the leaves of data (at least one) in parallel and
+     *          append their digests
+     */
+    void append_leaves(const std::uint8_t* data, std::size_t len)
+    {
+        constexpr std::size_t LANE_NUM = SM3MultiBuffer::LANE_NUM;
+
+        std::size_t leaf_num = (len == 0) ? 1 : (len - 1) / leaf_size_ + 1;
+        // a batch smaller than one leaf per lane is not worth a wake-up
+        bool parallel = leaf_num > LANE_NUM && thread_num_ > 1;
+        if (parallel)
+        {
+            this->start_workers();
+        }
+        std::size_t old_size = leaf_digest_.size();
+        leaf_digest_.resize(old_size + leaf_num * DIGEST_SIZE);
+
+        Batch batch;
+        batch.leaf_digest = leaf_digest_.data() + old_size;
+        batch.data        = data;
+        batch.len         = len;
+        batch.leaf_num    = leaf_num;
+
+        if (parallel)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                batch_   = &batch;
+                running_ = workers_.size();
+                generation_++;
+            }
+            start_cv_.notify_all();
+        }
+        this->hash_batch(batch);
+        std::unique_lock<std::mutex> lock(mtx_);
+        done_cv_.wait(lock, [this] { return running_ == 0; });
+        batch_ = nullptr;
+    }
+
+    void start_workers()
+    {
+        // a failed start leaves the started workers parked, the
+        // destructor stops and joins them
+        while (workers_.size() + 1 < thread_num_)
+        {
+            workers_.emplace_back([this] { this->worker(); });
+        }
+    }
+
+    void worker() noexcept
+    {
+        std::uint64_t seen = 0;
+        while (true)
+        {
+            Batch* batch;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                start_cv_.wait(lock,
+                               [&] { return stop_ || generation_ != seen; });
+                if (stop_)
+                {
+                    return;
+                }
+                seen  = generation_;
+                batch = batch_;
+            }
+            this->hash_batch(*batch);
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (--running_ == 0)
+            {
+                done_cv_.notify_one();
+            }
+        }
+    }
+
+    /**
+     * @brief   take leaves of batch until none is left, LANE_NUM at a time
+     *          through a SM3MultiBuffer
+     */
+    void hash_batch(Batch& batch) const noexcept
+    {
+        constexpr std::size_t LANE_NUM = SM3MultiBuffer::LANE_NUM;
+        static const std::uint8_t ZERO_BLOCK[SM3MultiBuffer::BLOCK_SIZE] = {0};
+
+        SM3MultiBuffer mb;
+        Sm3Job         jobs[LANE_NUM];
+        Sm3Job*        free_job[LANE_NUM];
+        std::size_t    free_num = LANE_NUM;
+        for (std::size_t j = 0; j < LANE_NUM; j++)
+        {
+            free_job[j] = &jobs[j];
+        }
+        std::size_t i;
+        while ((i = batch.next.fetch_add(1, std::memory_order_relaxed)) <
+               batch.leaf_num)
+        {
+            std::size_t offset = i * leaf_size_;
+            std::size_t size   = batch.len - offset;
+            size               = (size > leaf_size_) ? leaf_size_ : size;
+
+            Sm3Job* job = free_job[--free_num];
+            *job        = {ZERO_BLOCK, batch.data + offset, size,
+                           batch.leaf_digest + i * DIGEST_SIZE};
+            Sm3Job* done = mb.submit(job);
+            if (done != nullptr)
+            {
+                free_job[free_num++] = done;
+            }
+        }
+        while (mb.flush() != nullptr)
+        {
+        }
+    }
+};
+
+/**
+ * @brief                   tree hash of a file, read through a memory map
+ * @param[out]  digest      32-bytes root digest
+ * @param[in]   path        file path (UTF-8)
+ * @param[in]   leaf_size   leaf size (in bytes), multiple of 64
+ * @param[in]   thread_num  hashing threads, 0 for all hardware threads
+ */
+inline void sm3_tree_file(std::uint8_t* digest,
+                          const char*   path,
+                          std::size_t   leaf_size  = SM3Tree::DEFAULT_LEAF_SIZE,
+                          std::size_t   thread_num = 0)
+{
+    memory_utils::MappedFile file(path);
+    SM3Tree::digest(digest, file.data(), file.size(), leaf_size, thread_num);
+}
+
+} // namespace sm3
+
+#endif
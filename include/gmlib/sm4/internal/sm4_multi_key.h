@@ -0,0 +1,365 @@
+#ifndef SM4_INTERNAL_SM4_MULTI_KEY_H
+#define SM4_INTERNAL_SM4_MULTI_KEY_H
+
+#include <gmlib/memory_utils/endian.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(CPU_FLAG_AES) && defined(CPU_FLAG_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace sm4::internal::multi_key {
+
+/**
+ * @brief   key number handled together, one key per 32-bit lane
+ */
+constexpr std::size_t SM4_LANE_NUM = 8;
+
+/**
+ * @brief   SM4 context of SM4_LANE_NUM independent keys
+ * @details round keys are stored transposed, round_key[i][lane], so one
+ *          round of all lanes is a single vector load
+ */
+typedef struct Sm4MultiKeyCTX
+{
+    alignas(32) std::uint32_t round_key[32][SM4_LANE_NUM];
+} Sm4MultiKeyCTX;
+
+constexpr std::uint32_t SM4_FK[4] = {
+    0xa3b1bac6, 0x56aa3350, 0x677d9197, 0xb27022dc,
+};
+
+constexpr std::uint32_t SM4_CK[32] = {
+    0x00070e15, 0x1c232a31, 0x383f464d, 0x545b6269,
+    0x70777e85, 0x8c939aa1, 0xa8afb6bd, 0xc4cbd2d9,
+    0xe0e7eef5, 0xfc030a11, 0x181f262d, 0x343b4249,
+    0x50575e65, 0x6c737a81, 0x888f969d, 0xa4abb2b9,
+    0xc0c7ced5, 0xdce3eaf1, 0xf8ff060d, 0x141b2229,
+    0x30373e45, 0x4c535a61, 0x686f767d, 0x848b9299,
+    0xa0a7aeb5, 0xbcc3cad1, 0xd8dfe6ed, 0xf4fb0209,
+    0x10171e25, 0x2c333a41, 0x484f565d, 0x646b7279,
+};
+
+/**
+ * The S-box is never a table lookup indexed by secret data. It is
+ * S(x) = A * (A * x + C)^-1 + C, with the inverse in GF(2^8) modulo
+ * x^8 + x^7 + x^6 + x^5 + x^4 + x^2 + 1, A the circulant matrix of 0xA7
+ * and C = 0xD3. The AES-NI path maps it onto AES SubBytes with two affine
+ * transforms instead.
+ */
+
+#if defined(CPU_FLAG_AES) && defined(CPU_FLAG_AVX2)
+
+namespace avx2 {
+
+template <int N>
+static inline __m256i rotl(__m256i x) noexcept
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, N),
+                           _mm256_srli_epi32(x, 32 - N));
+}
+
+/// @brief affine transform of every byte, as two 16-entry nibble lookups
+static inline __m256i affine(__m256i x, __m256i lo_t, __m256i hi_t) noexcept
+{
+    const __m256i MASK = _mm256_set1_epi8(0x0f);
+
+    __m256i lo = _mm256_and_si256(x, MASK);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi32(x, 4), MASK);
+    return _mm256_xor_si256(_mm256_shuffle_epi8(lo_t, lo),
+                            _mm256_shuffle_epi8(hi_t, hi));
+}
+
+/**
+ * @brief   S-box of every byte: the input affine map takes the SM4 field
+ *          into the AES one, aesenclast with a zero round key does SubBytes
+ *          (and ShiftRows, undone by a shuffle), the output affine map
+ *          takes the result back
+ */
+static inline __m256i tau(__m256i x) noexcept
+{
+    const __m256i PRE_LO  = _mm256_set_epi64x(
+        0xC7C1B4B222245157, 0x9197E2E474720701, 0xC7C1B4B222245157,
+        0x9197E2E474720701);
+    const __m256i PRE_HI  = _mm256_set_epi64x(
+        0xF052B91BF95BB012, 0xE240AB09EB49A200, 0xF052B91BF95BB012,
+        0xE240AB09EB49A200);
+    const __m256i POST_LO = _mm256_set_epi64x(
+        0xEDD14478172BBE82, 0x5B67F2CEA19D0834, 0xEDD14478172BBE82,
+        0x5B67F2CEA19D0834);
+    const __m256i POST_HI = _mm256_set_epi64x(
+        0x11CDBE62CC1063BF, 0xAE7201DD73AFDC00, 0x11CDBE62CC1063BF,
+        0xAE7201DD73AFDC00);
+    const __m256i INV_SHIFT_ROWS = _mm256_setr_epi8(
+        0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3, //
+        0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3);
+    const __m128i ZERO = _mm_setzero_si128();
+
+    x          = affine(x, PRE_LO, PRE_HI);
+    __m128i lo = _mm_aesenclast_si128(_mm256_castsi256_si128(x), ZERO);
+    __m128i hi = _mm_aesenclast_si128(_mm256_extracti128_si256(x, 1), ZERO);
+    x          = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    x          = _mm256_shuffle_epi8(x, INV_SHIFT_ROWS);
+    return affine(x, POST_LO, POST_HI);
+}
+
+static inline void enc_key_init(Sm4MultiKeyCTX* ctx,
+                                const std::uint32_t K[4][SM4_LANE_NUM]) noexcept
+{
+    __m256i k0 = _mm256_loadu_si256((const __m256i*)K[0]);
+    __m256i k1 = _mm256_loadu_si256((const __m256i*)K[1]);
+    __m256i k2 = _mm256_loadu_si256((const __m256i*)K[2]);
+    __m256i k3 = _mm256_loadu_si256((const __m256i*)K[3]);
+    for (int i = 0; i < 32; i++)
+    {
+        __m256i t = _mm256_xor_si256(_mm256_xor_si256(k1, k2), k3);
+        t         = tau(_mm256_xor_si256(t, _mm256_set1_epi32(SM4_CK[i])));
+        t = _mm256_xor_si256(t, _mm256_xor_si256(rotl<13>(t), rotl<23>(t)));
+        t = _mm256_xor_si256(k0, t);
+        _mm256_store_si256((__m256i*)ctx->round_key[i], t);
+        k0 = k1, k1 = k2, k2 = k3, k3 = t;
+    }
+}
+
+static inline void crypt_block(const Sm4MultiKeyCTX* ctx,
+                               std::uint32_t X[4][SM4_LANE_NUM]) noexcept
+{
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)X[0]);
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)X[1]);
+    __m256i x2 = _mm256_loadu_si256((const __m256i*)X[2]);
+    __m256i x3 = _mm256_loadu_si256((const __m256i*)X[3]);
+    for (int i = 0; i < 32; i++)
+    {
+        __m256i rk = _mm256_load_si256((const __m256i*)ctx->round_key[i]);
+        __m256i t  = _mm256_xor_si256(_mm256_xor_si256(x1, x2), x3);
+        t          = tau(_mm256_xor_si256(t, rk));
+        __m256i l  = _mm256_xor_si256(rotl<2>(t), rotl<10>(t));
+        l = _mm256_xor_si256(l, _mm256_xor_si256(rotl<18>(t), rotl<24>(t)));
+        t          = _mm256_xor_si256(_mm256_xor_si256(x0, t), l);
+        x0 = x1, x1 = x2, x2 = x3, x3 = t;
+    }
+    _mm256_storeu_si256((__m256i*)X[0], x3);
+    _mm256_storeu_si256((__m256i*)X[1], x2);
+    _mm256_storeu_si256((__m256i*)X[2], x1);
+    _mm256_storeu_si256((__m256i*)X[3], x0);
+}
+
+} // namespace avx2
+
+#endif
+
+namespace common {
+
+constexpr std::uint64_t LSB = 0x0101010101010101;
+
+static inline std::uint32_t rotl(std::uint32_t x, int n) noexcept
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+/// @brief rotate every byte of x right by N bits
+template <int N>
+static inline std::uint64_t rotr8(std::uint64_t x) noexcept
+{
+    constexpr std::uint64_t MASK = LSB * (0xff >> N);
+    return ((x >> N) & MASK) | ((x << (8 - N)) & ~MASK);
+}
+
+/// @brief A * x + C of every byte
+static inline std::uint64_t affine(std::uint64_t x) noexcept
+{
+    return x ^ rotr8<1>(x) ^ rotr8<2>(x) ^ rotr8<5>(x) ^ rotr8<7>(x) ^
+           (LSB * 0xd3);
+}
+
+/// @brief bytewise product in the SM4 S-box field, without branches
+static inline std::uint64_t gf_mul(std::uint64_t a, std::uint64_t b) noexcept
+{
+    std::uint64_t r = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        r ^= a & (((b >> i) & LSB) * 0xff);
+        a = ((a & (LSB * 0x7f)) << 1) ^ (((a >> 7) & LSB) * 0xf5);
+    }
+    return r;
+}
+
+/// @brief bytewise x^254, the inverse with 0 mapped to 0
+static inline std::uint64_t gf_inv(std::uint64_t x) noexcept
+{
+    std::uint64_t x2   = gf_mul(x, x);
+    std::uint64_t x3   = gf_mul(x2, x);
+    std::uint64_t x6   = gf_mul(x3, x3);
+    std::uint64_t x7   = gf_mul(x6, x);
+    std::uint64_t x12  = gf_mul(x6, x6);
+    std::uint64_t x15  = gf_mul(x12, x3);
+    std::uint64_t x30  = gf_mul(x15, x15);
+    std::uint64_t x60  = gf_mul(x30, x30);
+    std::uint64_t x120 = gf_mul(x60, x60);
+    std::uint64_t x127 = gf_mul(x120, x7);
+    return gf_mul(x127, x127);
+}
+
+/// @brief S-box of every byte of the SM4_LANE_NUM words, two per step
+static inline void tau(std::uint32_t t[SM4_LANE_NUM]) noexcept
+{
+    for (std::size_t j = 0; j < SM4_LANE_NUM; j += 2)
+    {
+        std::uint64_t w = ((std::uint64_t)t[j + 1] << 32) | t[j];
+        w               = affine(gf_inv(affine(w)));
+        t[j]            = (std::uint32_t)w;
+        t[j + 1]        = (std::uint32_t)(w >> 32);
+    }
+}
+
+static inline void enc_key_init(Sm4MultiKeyCTX* ctx,
+                                const std::uint32_t K[4][SM4_LANE_NUM]) noexcept
+{
+    std::uint32_t k[4][SM4_LANE_NUM], t[SM4_LANE_NUM];
+    std::memcpy(k, K, sizeof(k));
+    for (int i = 0; i < 32; i++)
+    {
+        // k[i % 4] is k0 of this round, k[(i + 1) % 4] ... k3
+        std::uint32_t* k0 = k[i % 4];
+        for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+        {
+            t[j] = k[(i + 1) % 4][j] ^ k[(i + 2) % 4][j] ^
+                   k[(i + 3) % 4][j] ^ SM4_CK[i];
+        }
+        tau(t);
+        for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+        {
+            k0[j] ^= t[j] ^ rotl(t[j], 13) ^ rotl(t[j], 23);
+            ctx->round_key[i][j] = k0[j];
+        }
+    }
+}
+
+static inline void crypt_block(const Sm4MultiKeyCTX* ctx,
+                               std::uint32_t X[4][SM4_LANE_NUM]) noexcept
+{
+    std::uint32_t x[4][SM4_LANE_NUM], t[SM4_LANE_NUM];
+    std::memcpy(x, X, sizeof(x));
+    for (int i = 0; i < 32; i++)
+    {
+        std::uint32_t* x0 = x[i % 4];
+        for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+        {
+            t[j] = x[(i + 1) % 4][j] ^ x[(i + 2) % 4][j] ^
+                   x[(i + 3) % 4][j] ^ ctx->round_key[i][j];
+        }
+        tau(t);
+        for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+        {
+            x0[j] ^= t[j] ^ rotl(t[j], 2) ^ rotl(t[j], 10) ^
+                     rotl(t[j], 18) ^ rotl(t[j], 24);
+        }
+    }
+    // after 32 rounds x[0] ~ x[3] hold X32 ~ X35, the output is reversed
+    for (int i = 0; i < 4; i++)
+    {
+        std::memcpy(X[i], x[3 - i], sizeof(x[0]));
+    }
+}
+
+} // namespace common
+
+#if defined(CPU_FLAG_AES) && defined(CPU_FLAG_AVX2)
+namespace alg = avx2;
+#else
+namespace alg = common;
+#endif
+
+/**
+ * @brief           SM4 key schedule of up to SM4_LANE_NUM keys (encryption)
+ * @param ctx       multi-key context
+ * @param user_key  key_num pointers to 16-byte secret keys
+ * @param key_num   key number, 1 <= key_num <= SM4_LANE_NUM, unused lanes
+ *                  get the all-zero key
+ */
+static inline void sm4_multi_key_enc_key_init(
+    Sm4MultiKeyCTX*           ctx,
+    const std::uint8_t* const user_key[],
+    std::size_t               key_num) noexcept
+{
+    std::uint32_t K[4][SM4_LANE_NUM] = {};
+    for (std::size_t j = 0; j < key_num; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            K[i][j] = memory_utils::load32_be(user_key[j] + 4 * i);
+        }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+        {
+            K[i][j] ^= SM4_FK[i];
+        }
+    }
+    alg::enc_key_init(ctx, K);
+}
+
+/**
+ * @brief           SM4 key schedule of up to SM4_LANE_NUM keys (decryption)
+ * @see             sm4_multi_key_enc_key_init
+ */
+static inline void sm4_multi_key_dec_key_init(
+    Sm4MultiKeyCTX*           ctx,
+    const std::uint8_t* const user_key[],
+    std::size_t               key_num) noexcept
+{
+    sm4_multi_key_enc_key_init(ctx, user_key, key_num);
+    for (int i = 0; i < 16; i++)
+    {
+        for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+        {
+            std::uint32_t t           = ctx->round_key[i][j];
+            ctx->round_key[i][j]      = ctx->round_key[31 - i][j];
+            ctx->round_key[31 - i][j] = t;
+        }
+    }
+}
+
+/**
+ * @brief           crypt one block in every lane, lane j with key j
+ * @param ctx       multi-key context, encryption or decryption schedule
+ * @param out       out[j] is the 16-byte output of lane j, or nullptr
+ * @param in        in[j] is the 16-byte input of lane j, or nullptr for an
+ *                  idle lane (out[j] must be nullptr too)
+ */
+static inline void sm4_multi_key_crypt_block(
+    const Sm4MultiKeyCTX*     ctx,
+    std::uint8_t* const       out[SM4_LANE_NUM],
+    const std::uint8_t* const in[SM4_LANE_NUM]) noexcept
+{
+    std::uint32_t X[4][SM4_LANE_NUM] = {};
+    for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+    {
+        if (in[j] != nullptr)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                X[i][j] = memory_utils::load32_be(in[j] + 4 * i);
+            }
+        }
+    }
+    alg::crypt_block(ctx, X);
+    for (std::size_t j = 0; j < SM4_LANE_NUM; j++)
+    {
+        if (out[j] != nullptr)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                memory_utils::store32_be(out[j] + 4 * i, X[i][j]);
+            }
+        }
+    }
+}
+
+} // namespace sm4::internal::multi_key
+
+#endif
@@ -17,7 +17,7 @@ namespace alg = internal::common;
  * @brief   SM4 Block Cipher
  * @details GB/T 32907-2016
  */
-class SM4 : public block_cipher_mode::BlockCipherImpl
+class SM4 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME = "SM4";
@@ -0,0 +1,45 @@
+#ifndef SM4_SM4_FILE_H
+#define SM4_SM4_FILE_H
+
+#include <gmlib/block_cipher_mode/ctr_file.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+namespace sm4 {
+
+/**
+ * @brief                   SM4-CTR encrypt or decrypt a whole file
+ * @param[in]   in_path     input file (UTF-8)
+ * @param[in]   out_path    output file (UTF-8), created or replaced once
+ *                          complete, must not be the input file
+ * @param[in]   user_key    16-bytes secret key
+ * @param[in]   iv          16-bytes initial counter
+ * @param[in]   thread_num  crypting threads, 0 for all hardware threads
+ * @see                     block_cipher_mode::ctr_crypt_file
+ */
+inline void sm4_ctr_file(const char*         in_path,
+                         const char*         out_path,
+                         const std::uint8_t* user_key,
+                         const std::uint8_t* iv,
+                         std::size_t         thread_num = 0)
+{
+    SM4CtrEncryptor ctr(user_key, iv);
+    block_cipher_mode::ctr_crypt_file(ctr, in_path, out_path, thread_num);
+}
+
+/**
+ * @brief                   SM4-CTR with a ready key schedule
+ * @param[in]   cipher      SM4::ENCRYPTION key schedule
+ */
+inline void sm4_ctr_file(const char*         in_path,
+                         const char*         out_path,
+                         const SM4&          cipher,
+                         const std::uint8_t* iv,
+                         std::size_t         thread_num = 0)
+{
+    SM4CtrEncryptor ctr(cipher, iv);
+    block_cipher_mode::ctr_crypt_file(ctr, in_path, out_path, thread_num);
+}
+
+} // namespace sm4
+
+#endif
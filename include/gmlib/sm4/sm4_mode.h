@@ -6,7 +6,9 @@
 #include <gmlib/block_cipher_mode/ctr_mode.h>
 #include <gmlib/block_cipher_mode/ecb_mode.h>
 #include <gmlib/block_cipher_mode/gcm_mode.h>
+#include <gmlib/block_cipher_mode/ocb_mode.h>
 #include <gmlib/block_cipher_mode/ofb_mode.h>
+#include <gmlib/block_cipher_mode/xts_mode.h>
 #include <gmlib/sm4/sm4.h>
 
 namespace sm4 {
@@ -17,9 +19,13 @@ using SM4EcbDecryptor = block_cipher_mode::EcbDecryptor<SM4>;
 using SM4CbcEncryptor = block_cipher_mode::CbcEncryptor<SM4>;
 using SM4CbcDecryptor = block_cipher_mode::CbcDecryptor<SM4>;
 
+using SM4CbcMultiEncryptor = block_cipher_mode::CbcMultiEncryptor<SM4>;
+
 using SM4CfbEncryptor = block_cipher_mode::CfbEncryptor<SM4>;
 using SM4CfbDecryptor = block_cipher_mode::CfbDecryptor<SM4>;
 
+using SM4CfbMultiEncryptor = block_cipher_mode::CfbMultiEncryptor<SM4>;
+
 using SM4OfbEncryptor = block_cipher_mode::OfbEncryptor<SM4>;
 using SM4OfbDecryptor = block_cipher_mode::OfbDecryptor<SM4>;
 
@@ -29,6 +35,12 @@ using SM4CtrDecryptor = block_cipher_mode::CtrDecryptor<SM4>;
 using SM4GcmEncryptor = block_cipher_mode::GcmEncryptor<SM4>;
 using SM4GcmDecryptor = block_cipher_mode::GcmDecryptor<SM4>;
 
+using SM4OcbEncryptor = block_cipher_mode::OcbEncryptor<SM4>;
+using SM4OcbDecryptor = block_cipher_mode::OcbDecryptor<SM4>;
+
+using SM4XtsEncryptor = block_cipher_mode::XtsEncryptor<SM4>;
+using SM4XtsDecryptor = block_cipher_mode::XtsDecryptor<SM4>;
+
 } // namespace sm4
 
 #endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#ifndef SM4_SM4_MULTI_KEY_H
+#define SM4_SM4_MULTI_KEY_H
+
+#include <gmlib/sm4/internal/sm4_multi_key.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace sm4 {
+
+/**
+ * @brief   SM4 with an independent key in every lane
+ * @details for workloads where each record has its own key: up to LANE_NUM
+ *          keys are expanded together, then their blocks are crypted
+ *          together, lane j always with key j. With AVX2 and AES-NI a lane
+ *          is a 32-bit SIMD lane, so neither step costs more than a
+ *          single-key one.
+ * @note    the S-box is computed without secret-indexed table lookups.
+ *          Without CPU_FLAG_AES and CPU_FLAG_AVX2 it is done arithmetically
+ *          on 64-bit words, which is constant time but about 13 times
+ *          slower than the AES-NI path.
+ */
+class SM4MultiKey
+{
+public:
+    static constexpr int ENCRYPTION = 1;
+    static constexpr int DECRYPTION = 0;
+
+    static constexpr std::size_t BLOCK_SIZE   = 16;
+    static constexpr std::size_t USER_KEY_LEN = 16;
+    static constexpr std::size_t LANE_NUM =
+        internal::multi_key::SM4_LANE_NUM;
+
+private:
+    internal::multi_key::Sm4MultiKeyCTX ctx_;
+    std::size_t                         key_num_ = 0;
+
+public:
+    /**
+     * @note    need to call the "set_key" function to Key Schedule
+     */
+    SM4MultiKey() noexcept = default;
+
+    SM4MultiKey(const std::uint8_t* const user_key[],
+                std::size_t               key_num,
+                int                       enc)
+    {
+        this->set_key(user_key, key_num, enc);
+    }
+
+public:
+    /**
+     * @brief                   Key Schedule of key_num keys at once
+     * @param[in]   user_key    key_num pointers to 16-bytes secret keys
+     * @param[in]   key_num     key number, 1 <= key_num <= LANE_NUM
+     * @param[in]   enc         ENCRYPTION or DECRYPTION
+     */
+    void set_key(const std::uint8_t* const user_key[],
+                 std::size_t               key_num,
+                 int                       enc)
+    {
+        if (key_num == 0 || key_num > LANE_NUM)
+        {
+            throw std::runtime_error("invalid sm4 multi-key key number");
+        }
+        if (enc == ENCRYPTION)
+        {
+            internal::multi_key::sm4_multi_key_enc_key_init(&ctx_, user_key,
+                                                            key_num);
+        }
+        else
+        {
+            internal::multi_key::sm4_multi_key_dec_key_init(&ctx_, user_key,
+                                                            key_num);
+        }
+        key_num_ = key_num;
+    }
+
+    std::size_t key_num() const noexcept
+    {
+        return key_num_;
+    }
+
+    /**
+     * @brief                   Encrypt Multiple Blocks with one key per lane
+     * @details                 lane j encrypts block_num[j] blocks (ECB)
+     *                          from in[j] to out[j] with key j, a lane with
+     *                          fewer blocks goes idle early. out[j] == in[j]
+     *                          is allowed.
+     * @param[out]  out         key_num output pointers
+     * @param[in]   in          key_num input pointers
+     * @param[in]   block_num   key_num block numbers
+     */
+    void encrypt_blocks(std::uint8_t* const       out[],
+                        const std::uint8_t* const in[],
+                        const std::size_t         block_num[]) const noexcept
+    {
+        this->crypt_blocks(out, in, block_num);
+    }
+
+    /**
+     * @brief                   Decrypt Multiple Blocks with one key per lane
+     * @see                     encrypt_blocks
+     */
+    void decrypt_blocks(std::uint8_t* const       out[],
+                        const std::uint8_t* const in[],
+                        const std::size_t         block_num[]) const noexcept
+    {
+        this->crypt_blocks(out, in, block_num);
+    }
+
+private:
+    void crypt_blocks(std::uint8_t* const       out[],
+                      const std::uint8_t* const in[],
+                      const std::size_t         block_num[]) const noexcept
+    {
+        std::size_t max_num = 0;
+        for (std::size_t j = 0; j < key_num_; j++)
+        {
+            max_num = (block_num[j] > max_num) ? block_num[j] : max_num;
+        }
+        std::uint8_t*       lane_out[LANE_NUM];
+        const std::uint8_t* lane_in[LANE_NUM];
+        for (std::size_t i = 0; i < max_num; i++)
+        {
+            for (std::size_t j = 0; j < LANE_NUM; j++)
+            {
+                bool active = j < key_num_ && i < block_num[j];
+                lane_out[j] = active ? out[j] + BLOCK_SIZE * i : nullptr;
+                lane_in[j]  = active ? in[j] + BLOCK_SIZE * i : nullptr;
+            }
+            internal::multi_key::sm4_multi_key_crypt_block(&ctx_, lane_out,
+                                                           lane_in);
+        }
+    }
+};
+
+} // namespace sm4
+
+#endif
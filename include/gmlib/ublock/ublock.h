@@ -13,7 +13,7 @@ namespace alg = internal::standard;
 namespace alg = internal::common;
 #endif
 
-class uBlock128128 : public block_cipher_mode::BlockCipherImpl
+class uBlock128128 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME = "uBlock-128-128";
@@ -152,7 +152,7 @@ public:
     }
 };
 
-class uBlock128256 : public block_cipher_mode::BlockCipherImpl
+class uBlock128256 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME = "uBlock-128-256";
@@ -291,7 +291,7 @@ public:
     }
 };
 
-class uBlock256256 : public block_cipher_mode::BlockCipherImpl
+class uBlock256256 final : public block_cipher_mode::BlockCipherImpl
 {
 public:
     static constexpr const char* NAME = "uBlock-256-256";
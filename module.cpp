@@ -8,10 +8,14 @@
 #include <iostream>
 #include <cstdint>
 #include <string>
+#include <gmlib/block_cipher_mode/key_cache.h>
+#include <gmlib/memory_utils/memzero.h>
 #include <gmlib/rng/std_rng.h>
 #include <gmlib/sm2/sm2.h>
 #include <gmlib/sm3/sm3.h>
+#include <gmlib/sm3/sm3_file.h>
 #include <gmlib/sm4/sm4.h>
+#include <gmlib/sm4/sm4_file.h>
 #include <gmlib/sm4/sm4_mode.h>
 
 using namespace Pectics;
@@ -40,6 +44,80 @@ constexpr uint8_t PUBLIC_KEY[2][32] = { {
 	0x57, 0x55, 0xb2, 0xab, 0xb8, 0xb7, 0x02, 0xb7,
 } };
 
+// process-wide SM4 key schedules, shared by all calls and threads
+using SM4KeyCache = block_cipher_mode::KeyScheduleCache<sm4::SM4, 512>;
+static SM4KeyCache SM4_KEY_CACHE;
+static const char* SM4_KEY_CAPSULE = "CryptUtils.SM4Key";
+
+// Base64 key string or SM4Key handle -> cached key schedule
+static bool ResolveSM4Key(PyObject* k, SM4KeyCache::Handle& key) {
+
+	// handle from SM4Key
+	if (PyCapsule_IsValid(k, SM4_KEY_CAPSULE)) {
+		key = *static_cast<SM4KeyCache::Handle*>(PyCapsule_GetPointer(k, SM4_KEY_CAPSULE));
+		return true;
+	}
+	if (!PyUnicode_Check(k)) {
+		PyErr_SetString(PyExc_TypeError, "Key is not a string or an SM4Key handle");
+		return false;
+	}
+
+	// Base64 string
+	PyObject* k_bytes = PyUnicode_AsUTF8String(k);
+	if (k_bytes == nullptr)
+		return false;
+	char* k_str;
+	Py_ssize_t key_len;
+	if (PyBytes_AsStringAndSize(k_bytes, &k_str, &key_len) < 0) {
+		Py_DECREF(k_bytes);
+		return false;
+	}
+	const uint8_t* k_data = reinterpret_cast<const uint8_t*>(k_str);
+	size_t decoded_len = key_len / 4 * 3;
+	if (key_len >= 1 && k_str[key_len - 1] == '=') decoded_len--;
+	if (key_len >= 2 && k_str[key_len - 2] == '=') decoded_len--;
+	if (key_len % 4 != 0 || decoded_len != sm4::SM4::USER_KEY_LEN) {
+		Py_DECREF(k_bytes);
+		PyErr_SetString(PyExc_ValueError, "Invalid SM4 key length");
+		return false;
+	}
+	uint8_t user_key[sm4::SM4::USER_KEY_LEN];
+	Base64::Decode(k_data, key_len, user_key);
+	Py_DECREF(k_bytes);
+	key = SM4_KEY_CACHE.get(user_key);
+	memory_utils::memzero(user_key, sizeof(user_key));
+	return true;
+}
+
+static void SM4KeyDestructor(PyObject* capsule) {
+	delete static_cast<SM4KeyCache::Handle*>(PyCapsule_GetPointer(capsule, SM4_KEY_CAPSULE));
+}
+
+static PyObject* C_SM4Key(PyObject*, PyObject* o) {
+
+	// resolve key through the cache
+	SM4KeyCache::Handle key;
+	if (!ResolveSM4Key(o, key))
+		return _Py_NULL;
+
+	// the handle keeps the key schedule alive
+	SM4KeyCache::Handle* handle = new SM4KeyCache::Handle(std::move(key));
+	PyObject* ret = PyCapsule_New(handle, SM4_KEY_CAPSULE, SM4KeyDestructor);
+	if (ret == nullptr)
+		delete handle;
+	return ret;
+}
+
+// recipient key, its comb table is built on first use
+static const sm2::SM2PublicKey<sm3::SM3>& RecipientKey() {
+	static const sm2::SM2PublicKey<sm3::SM3> key = [] {
+		sm2::SM2PublicKey<sm3::SM3> k(PUBLIC_KEY[0], PUBLIC_KEY[1]);
+		k.precompute();
+		return k;
+	}();
+	return key;
+}
+
 static PyObject* C_SM2Encrypt(PyObject*, PyObject* o) {
 
 	// check input
@@ -55,7 +133,7 @@ static PyObject* C_SM2Encrypt(PyObject*, PyObject* o) {
 	std::copy(text.begin(), text.end(), plain);
 
 	// init pub_key
-	sm2::SM2PublicKey<sm3::SM3> pub_key(PUBLIC_KEY[0], PUBLIC_KEY[1]);
+	const sm2::SM2PublicKey<sm3::SM3>& pub_key = RecipientKey();
 
 	// error: buffer overflow
 	if (pub_key.ciphertext_len(plain, plain_len) > BUFFER_SIZE) {
@@ -122,44 +200,36 @@ static PyObject* C_SM4Encrypt(PyObject*, PyObject* o) {
 
 	// Parse keywords
 	const char* t;
-	const char* k;
+	PyObject* k;
 	bool gzip = false;
-	if (!PyArg_ParseTuple(o, "ss|i", &t, &k, &gzip))
+	if (!PyArg_ParseTuple(o, "sO|i", &t, &k, &gzip))
 		return _Py_NULL;
 
 	uint8_t* text = reinterpret_cast<uint8_t*>(const_cast<char*>(t));
 	size_t len = strlen(t);
-	uint8_t* key_str = reinterpret_cast<uint8_t*>(const_cast<char*>(k));
-	size_t key_len = strlen(k);
 
-	// Parse key
-	uint8_t key[sm4::SM4::USER_KEY_LEN];
-	Base64::Decode(key_str, key_len, key);
+	// Resolve key, Base64 string or SM4Key handle
+	SM4KeyCache::Handle key;
+	if (!ResolveSM4Key(k, key))
+		return _Py_NULL;
 
-	// Initialize encryptor
-	sm4::SM4EcbEncryptor enc(key);
+	// Initialize encryptor, PKCS7 padding is applied by do_final
+	sm4::SM4EcbEncryptor enc(key->enc, true);
 
 	// gzip compress
 	if (gzip)
 		GZip::Compress(text, len, text, len);
 
-	// Parse text and apply PKCS7 padding
-	size_t block_size = sm4::SM4::BLOCK_SIZE;
-	size_t padded_len = block_size * (len / block_size + 1);
-	uint8_t* plain = new uint8_t[padded_len];
-	std::copy(text, text + len, plain);
-	std::fill(plain + len, plain + padded_len, padded_len - len);
-
 	// Encrypt
-	uint8_t* cipher = new uint8_t[BUFFER_SIZE];
+	size_t block_size = sm4::SM4::BLOCK_SIZE;
+	uint8_t* cipher = new uint8_t[block_size * (len / block_size + 1)];
 	size_t cipher_len;
-	enc.do_final(cipher, &cipher_len, plain, padded_len);
+	enc.do_final(cipher, &cipher_len, text, len);
 
 	// Encode to Base64
 	std::string ret = Base64::EncodeAsString(cipher, cipher_len);
 
 	// Return
-	delete[] plain;
 	delete[] cipher;
 	return PyUnicode_FromStringAndSize(ret.c_str(), ret.size());
 }
@@ -172,22 +242,21 @@ static PyObject* C_SM4Decrypt(PyObject*, PyObject* o) {
 
 	// parse keywords
 	const char* t;
-	const char* k;
+	PyObject* k;
 	bool gzip = false;
-	if (!PyArg_ParseTuple(o, "ss|i", &t, &k, &gzip))
+	if (!PyArg_ParseTuple(o, "sO|i", &t, &k, &gzip))
 		return _Py_NULL;
 
 	uint8_t* text = reinterpret_cast<uint8_t*>(const_cast<char*>(t));
 	size_t len = strlen(t);
-	uint8_t* key_str = reinterpret_cast<uint8_t*>(const_cast<char*>(k));
-	size_t key_len = strlen(k);
 
-	// parse key
-	uint8_t key[sm4::SM4::USER_KEY_LEN];
-	Base64::Decode(key_str, key_len, key);
+	// resolve key, Base64 string or SM4Key handle
+	SM4KeyCache::Handle key;
+	if (!ResolveSM4Key(k, key))
+		return _Py_NULL;
 
-	// init dec
-	sm4::SM4EcbDecryptor dec(key);
+	// init dec, PKCS7 padding is removed by do_final
+	sm4::SM4EcbDecryptor dec(key->dec, true);
 
 	// parse cipher length and decode
 	size_t cipher_len = len / 4 * 3;
@@ -201,28 +270,202 @@ static PyObject* C_SM4Decrypt(PyObject*, PyObject* o) {
 	// decrypt
 	uint8_t* plain = new uint8_t[BUFFER_SIZE];
 	size_t plain_len;
-	dec.do_final(plain, &plain_len, cipher, cipher_len);
+	try {
+		dec.do_final(plain, &plain_len, cipher, cipher_len);
+	}
+	catch (const std::exception&) {
+		// one message for every failure, so it is no padding oracle
+		delete[] plain;
+		delete[] cipher;
+		PyErr_SetString(PyExc_ValueError, "Decryption failed");
+		return _Py_NULL;
+	}
 
 	// gzip decompress
 	if (gzip)
 		GZip::Decompress(plain, plain_len, plain, plain_len);
 
-	// remove padding
-
-	size_t padding = plain[plain_len - 1];
-	std::string ret(plain, plain + plain_len - padding);
-
 	// return
+	PyObject* ret = PyUnicode_FromStringAndSize(reinterpret_cast<const char*>(plain), plain_len);
 	delete[] plain;
 	delete[] cipher;
-	return PyUnicode_FromStringAndSize(ret.c_str(), ret.size());
+	return ret;
+}
+
+static PyObject* C_SM4EncryptInPlace(PyObject*, PyObject* o) {
+
+	// check input
+	if (!PyTuple_Check(o))
+		return _Py_NULL;
+
+	// parse keywords, buf must be a bytearray
+	PyObject* buf;
+	PyObject* k;
+	if (!PyArg_ParseTuple(o, "YO", &buf, &k))
+		return _Py_NULL;
+
+	size_t len = PyByteArray_Size(buf);
+
+	// resolve key, Base64 string or SM4Key handle
+	SM4KeyCache::Handle key;
+	if (!ResolveSM4Key(k, key))
+		return _Py_NULL;
+
+	// grow by the PKCS7 padding, which is written by do_final
+	size_t block_size = sm4::SM4::BLOCK_SIZE;
+	if (PyByteArray_Resize(buf, block_size * (len / block_size + 1)) < 0)
+		return _Py_NULL;
+	uint8_t* data = reinterpret_cast<uint8_t*>(PyByteArray_AsString(buf));
+
+	// encrypt in place
+	sm4::SM4EcbEncryptor enc(key->enc, true);
+	size_t cipher_len;
+	enc.do_final(data, &cipher_len, data, len);
+
+	Py_RETURN_NONE;
+}
+
+static PyObject* C_SM4DecryptInPlace(PyObject*, PyObject* o) {
+
+	// check input
+	if (!PyTuple_Check(o))
+		return _Py_NULL;
+
+	// parse keywords, buf must be a bytearray
+	PyObject* buf;
+	PyObject* k;
+	if (!PyArg_ParseTuple(o, "YO", &buf, &k))
+		return _Py_NULL;
+
+	size_t len = PyByteArray_Size(buf);
+	uint8_t* data = reinterpret_cast<uint8_t*>(PyByteArray_AsString(buf));
+
+	// resolve key, Base64 string or SM4Key handle
+	SM4KeyCache::Handle key;
+	if (!ResolveSM4Key(k, key))
+		return _Py_NULL;
+
+	// ECB blocks are independent, so the last block is decrypted and
+	// checked into a scratch buffer first and a bad ciphertext leaves buf
+	// as it was
+	size_t block_size = sm4::SM4::BLOCK_SIZE;
+	uint8_t last[sm4::SM4::BLOCK_SIZE];
+	size_t last_len;
+	bool ok = len != 0 && len % block_size == 0;
+	if (ok) {
+		try {
+			sm4::SM4EcbDecryptor tail(key->dec, true);
+			tail.do_final(last, &last_len, data + len - block_size, block_size);
+		}
+		catch (const std::exception&) {
+			ok = false;
+		}
+	}
+	if (!ok) {
+		// one message for every failure, so it is no padding oracle
+		PyErr_SetString(PyExc_ValueError, "Decryption failed");
+		return _Py_NULL;
+	}
+
+	// decrypt the other blocks in place, then put the unpadded tail back
+	sm4::SM4EcbDecryptor dec(key->dec);
+	size_t plain_len;
+	dec.do_final(data, &plain_len, data, len - block_size);
+	memcpy(data + plain_len, last, last_len);
+	plain_len += last_len;
+
+	// drop the padding
+	if (PyByteArray_Resize(buf, plain_len) < 0)
+		return _Py_NULL;
+
+	Py_RETURN_NONE;
+}
+
+static PyObject* C_SM3File(PyObject*, PyObject* o) {
+
+	// check input
+	if (!PyTuple_Check(o))
+		return _Py_NULL;
+
+	// parse keywords
+	const char* path;
+	if (!PyArg_ParseTuple(o, "s", &path))
+		return _Py_NULL;
+
+	// hash through a memory map, without the GIL
+	uint8_t digest[sm3::SM3::DIGEST_SIZE];
+	std::string err;
+	Py_BEGIN_ALLOW_THREADS
+	try {
+		sm3::sm3_file(digest, path);
+	}
+	catch (const std::exception& e) {
+		err = e.what();
+	}
+	Py_END_ALLOW_THREADS
+	if (!err.empty()) {
+		PyErr_SetString(PyExc_OSError, err.c_str());
+		return _Py_NULL;
+	}
+
+	// return raw digest
+	return PyBytes_FromStringAndSize(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+static PyObject* C_SM4CtrFile(PyObject*, PyObject* o) {
+
+	// check input
+	if (!PyTuple_Check(o))
+		return _Py_NULL;
+
+	// parse keywords
+	const char* in_path;
+	const char* out_path;
+	PyObject* k;
+	const char* iv;
+	Py_ssize_t iv_len;
+	if (!PyArg_ParseTuple(o, "ssOy#", &in_path, &out_path, &k, &iv, &iv_len))
+		return _Py_NULL;
+	if (iv_len != sm4::SM4::BLOCK_SIZE) {
+		PyErr_SetString(PyExc_ValueError, "Invalid SM4 iv length");
+		return _Py_NULL;
+	}
+
+	// resolve key, Base64 string or SM4Key handle
+	SM4KeyCache::Handle key;
+	if (!ResolveSM4Key(k, key))
+		return _Py_NULL;
+
+	// crypt through memory maps on all cores, without the GIL
+	uint8_t counter[sm4::SM4::BLOCK_SIZE];
+	memcpy(counter, iv, sizeof(counter));
+	std::string err;
+	Py_BEGIN_ALLOW_THREADS
+	try {
+		sm4::sm4_ctr_file(in_path, out_path, key->enc, counter);
+	}
+	catch (const std::exception& e) {
+		err = e.what();
+	}
+	Py_END_ALLOW_THREADS
+	if (!err.empty()) {
+		PyErr_SetString(PyExc_OSError, err.c_str());
+		return _Py_NULL;
+	}
+
+	Py_RETURN_NONE;
 }
 
 static PyMethodDef methods[] = {
 	{ "SM2Encrypt", reinterpret_cast<PyCFunction>(C_SM2Encrypt), METH_O, "Encrypt text with SM2" },
 	{ "SM2Decrypt", reinterpret_cast<PyCFunction>(C_SM2Decrypt), METH_O, "Decrypt text with SM2" },
+	{ "SM4Key", reinterpret_cast<PyCFunction>(C_SM4Key), METH_O, "Resolve a Base64 SM4 key to a cached key schedule handle" },
 	{ "SM4Encrypt", reinterpret_cast<PyCFunction>(C_SM4Encrypt), METH_VARARGS, "Encrypt text with SM4" },
 	{ "SM4Decrypt", reinterpret_cast<PyCFunction>(C_SM4Decrypt), METH_VARARGS, "Decrypt text with SM4" },
+	{ "SM4EncryptInPlace", reinterpret_cast<PyCFunction>(C_SM4EncryptInPlace), METH_VARARGS, "Encrypt a bytearray with SM4 in place" },
+	{ "SM4DecryptInPlace", reinterpret_cast<PyCFunction>(C_SM4DecryptInPlace), METH_VARARGS, "Decrypt a bytearray with SM4 in place" },
+	{ "SM3File", reinterpret_cast<PyCFunction>(C_SM3File), METH_VARARGS, "Hash a file with SM3" },
+	{ "SM4CtrFile", reinterpret_cast<PyCFunction>(C_SM4CtrFile), METH_VARARGS, "Encrypt or decrypt a file with SM4-CTR" },
 	{ nullptr, nullptr, 0, nullptr },
 };
 
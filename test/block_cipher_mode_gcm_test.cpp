@@ -0,0 +1,240 @@
+/**
+ * GcmEncryptor / GcmDecryptor checks.
+ *
+ * Known answers from RFC 8998 (SM4-GCM) and OpenSSL AES-128-GCM, then
+ * several decryptions in a row with partial final blocks, each of which
+ * must still verify its own tag.
+ */
+#include <gmlib/aes/aes_mode.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x6C3);
+
+struct GcmVector
+{
+    const char* key;
+    const char* iv;
+    const char* aad;
+    const char* pt;
+    const char* ct;
+    const char* tag;
+};
+
+// RFC 8998 appendix A.1
+const GcmVector SM4_GCM_VECTOR = {
+    "0123456789abcdeffedcba9876543210",
+    "00001234567800000000abcd",
+    "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+    "aaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbccccccccccccccccdddddddddddddddd"
+    "eeeeeeeeeeeeeeeeffffffffffffffffeeeeeeeeeeeeeeeeaaaaaaaaaaaaaaaa",
+    "17f399f08c67d5ee19d0dc9969c4bb7d5fd46fd3756489069157b282bb200735"
+    "d82710ca5c22f0ccfa7cbf93d496ac15a56834cbcf98c397b4024a2691233b8d",
+    "83de3541e4c2b58177e065a9bf7b62ec",
+};
+
+/**
+ * OpenSSL AES-128-GCM, key = 0x00 ~ 0x0f, iv = 0xc0 ~ 0xcb, aad and
+ * plaintext are the first aad_len / pt_len bytes of 0x80, 0x81 ... and
+ * 0x00, 0x01 ...
+ */
+struct AesGcmVector
+{
+    std::size_t aad_len, pt_len;
+    const char* ct;
+    const char* tag;
+};
+
+const AesGcmVector AES_GCM_VECTORS[] = {
+    {0, 0, "", "6f3327b1c35fd87e351ae8d543aedfa7"},
+    {20, 0, "", "f9162735617d9671a907148c07d44bea"},
+    {0, 16, "bf25d7085212b91234f7c091fa159c06",
+     "9ab76f674a5b1012f304410d90a765b6"},
+    {20, 37,
+     "bf25d7085212b91234f7c091fa159c065ad2d158884cb8f387a467176f150ebd"
+     "d3c4f122ce",
+     "694248eb2f54f9db745de942725bee68"},
+    {64, 100,
+     "bf25d7085212b91234f7c091fa159c065ad2d158884cb8f387a467176f150ebd"
+     "d3c4f122ce8c129ac17172bca6c42e8776dc9d56ffb1bfc7a3646dc5299a3edf"
+     "115e612769b6417e98101327782d036e22de8997c985b7a9d26f93043f9a39e5"
+     "ba9c0c92",
+     "b86251e066abe3dd53c923d834ad943d"},
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+template <class Cryptor>
+std::vector<std::uint8_t> crypt(Cryptor&                         cryptor,
+                                const std::vector<std::uint8_t>& in)
+{
+    std::vector<std::uint8_t> out(in.size() + 16);
+    std::size_t               outl, total;
+    cryptor.update(out.data(), &outl, in.data(), in.size());
+    total = outl;
+    cryptor.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+template <class Enc, class Dec>
+void test_vector(const char*                      name,
+                 const std::vector<std::uint8_t>& key,
+                 const std::vector<std::uint8_t>& iv,
+                 const std::vector<std::uint8_t>& aad,
+                 const std::vector<std::uint8_t>& pt,
+                 const std::vector<std::uint8_t>& ct,
+                 const std::vector<std::uint8_t>& tag)
+{
+    std::vector<std::uint8_t> out_tag(16);
+    Enc enc(key.data(), iv.data(), iv.size(), aad.data(), aad.size());
+    check(crypt(enc, pt) == ct, name, "known answer");
+    enc.get_tag(out_tag.data());
+    check(out_tag == tag, name, "known answer tag");
+
+    Dec dec(key.data(), iv.data(), iv.size(), aad.data(), aad.size());
+    dec.set_tag(tag.data());
+    check(crypt(dec, ct) == pt, name, "known answer dec");
+}
+
+void test_known_answer()
+{
+    const GcmVector& v = SM4_GCM_VECTOR;
+    test_vector<sm4::SM4GcmEncryptor, sm4::SM4GcmDecryptor>(
+        "SM4 GCM", from_hex(v.key), from_hex(v.iv), from_hex(v.aad),
+        from_hex(v.pt), from_hex(v.ct), from_hex(v.tag));
+
+    std::vector<std::uint8_t> key(16), iv(12);
+    for (int i = 0; i < 16; i++)
+    {
+        key[i] = (std::uint8_t)i;
+    }
+    for (int i = 0; i < 12; i++)
+    {
+        iv[i] = (std::uint8_t)(0xc0 + i);
+    }
+    for (const AesGcmVector& a : AES_GCM_VECTORS)
+    {
+        std::vector<std::uint8_t> aad(a.aad_len), pt(a.pt_len);
+        for (std::size_t i = 0; i < aad.size(); i++)
+        {
+            aad[i] = (std::uint8_t)(0x80 + i);
+        }
+        for (std::size_t i = 0; i < pt.size(); i++)
+        {
+            pt[i] = (std::uint8_t)i;
+        }
+        test_vector<aes::AES128GcmEncryptor, aes::AES128GcmDecryptor>(
+            "AES128 GCM", key, iv, aad, pt, from_hex(a.ct), from_hex(a.tag));
+    }
+}
+
+/**
+ * decryptions of messages with a partial final block, one after another
+ * on fresh and on reset objects
+ */
+void test_repeated_decrypt()
+{
+    std::uint8_t key[16], iv[12];
+    for (std::uint8_t& b : key)
+    {
+        b = (std::uint8_t)rng();
+    }
+    sm4::SM4GcmDecryptor reused;
+    for (int round = 0; round < 50; round++)
+    {
+        for (std::uint8_t& b : iv)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::uint8_t> aad(rng() % 40), pt(1 + rng() % 100);
+        for (std::uint8_t& b : aad)
+        {
+            b = (std::uint8_t)rng();
+        }
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::uint8_t         tag[16];
+        sm4::SM4GcmEncryptor enc(key, iv, 12, aad.data(), aad.size());
+        auto                 ct = crypt(enc, pt);
+        enc.get_tag(tag);
+
+        sm4::SM4GcmDecryptor dec(key, iv, 12, aad.data(), aad.size());
+        dec.set_tag(tag);
+        check(crypt(dec, ct) == pt, "SM4 GCM", "decrypt");
+
+        if (round == 0)
+        {
+            reused.init(key, iv, 12, aad.data(), aad.size());
+        }
+        else
+        {
+            reused.reset(iv, 12, aad.data(), aad.size());
+        }
+        reused.set_tag(tag);
+        check(crypt(reused, ct) == pt, "SM4 GCM", "decrypt after reset");
+
+        tag[rng() % 16] ^= 0x20;
+        dec.reset(iv, 12, aad.data(), aad.size());
+        dec.set_tag(tag);
+        bool thrown = false;
+        try
+        {
+            crypt(dec, ct);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "SM4 GCM", "wrong tag rejected");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_repeated_decrypt();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all GCM checks passed\n");
+    return 0;
+}
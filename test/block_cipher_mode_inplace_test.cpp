@@ -0,0 +1,221 @@
+/**
+ * In-place (out == in) checks of every block cipher mode over SM4 and AES.
+ *
+ * Each case crypts random data twice with the same update() split, once
+ * into a separate buffer and once in place, and requires identical output
+ * (and tag). The in-place ciphertext is then decrypted in place again.
+ */
+#include <gmlib/aes/aes_mode.h>
+#include <gmlib/block_cipher_mode/block_cipher_mode.h>
+#include <gmlib/block_cipher_mode/xts_mode.h>
+#include <gmlib/memory_utils/memxor.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x5EED);
+
+template <class T, class = void>
+struct has_get_tag : std::false_type
+{
+};
+
+template <class T>
+struct has_get_tag<T, std::void_t<decltype(&T::get_tag)>> : std::true_type
+{
+};
+
+void fill(std::vector<std::uint8_t>& buf)
+{
+    for (std::uint8_t& b : buf)
+    {
+        b = (std::uint8_t)rng();
+    }
+}
+
+/**
+ * @brief               crypt len bytes in random update() pieces
+ * @param[in]   seed    piece lengths seed, the same seed gives the same
+ *                      split
+ * @return              output length
+ */
+template <class Mode>
+std::size_t crypt(Mode&               mode,
+                  std::uint8_t*       out,
+                  const std::uint8_t* in,
+                  std::size_t         len,
+                  unsigned            seed)
+{
+    std::mt19937 split(seed);
+    std::size_t  total = 0, offset = 0, outl;
+    while (offset < len)
+    {
+        // mix short pieces with whole multi-block runs
+        std::size_t n = (split() % 4 == 0) ? 16 * (split() % 40)
+                                           : split() % 70;
+        n             = (n > len - offset) ? len - offset : n;
+        mode.update(out + total, &outl, in + offset, n);
+        total += outl, offset += n;
+    }
+    mode.do_final(out + total, &outl);
+    return total + outl;
+}
+
+void check(bool ok, const char* name, const char* what, std::size_t len)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s, len = %zu\n", name, what, len);
+        fail_num++;
+    }
+}
+
+/**
+ * @param[in]   name        case name
+ * @param[in]   iv_len      iv length, 0 for none
+ * @param[in]   block_only  data length is a whole number of blocks
+ * @param[in]   min_len     shortest data length
+ */
+template <class Encryptor, class Decryptor>
+void test_mode(const char* name,
+               std::size_t iv_len,
+               bool        block_only,
+               std::size_t min_len = 0)
+{
+    for (int round = 0; round < 200; round++)
+    {
+        std::vector<std::uint8_t> key(Encryptor::USER_KEY_LEN), iv(iv_len);
+        std::vector<std::uint8_t> aad(rng() % 40);
+        fill(key), fill(iv), fill(aad);
+
+        std::size_t len = rng() % 1200;
+        len             = (len < min_len) ? min_len : len;
+        len             = block_only ? len / 16 * 16 : len;
+        std::vector<std::uint8_t> pt(len), ct(len + 32), buf(len + 32);
+        fill(pt);
+
+        std::uint8_t   tag1[16] = {0}, tag2[16] = {0};
+        ConstParameter params = {
+            {ParamKey::USER_KEY, {key.data(), key.size()}},
+            {ParamKey::IV, {iv.data(), iv.size()}},
+            {ParamKey::AAD, {aad.data(), aad.size()}},
+        };
+
+        // encrypt, separate buffers and in place
+        unsigned  seed = rng();
+        Encryptor enc1, enc2;
+        enc1.init(params);
+        enc2.init(params);
+        std::size_t ct_len = crypt(enc1, ct.data(), pt.data(), len, seed);
+        if (len != 0)
+        {
+            std::memcpy(buf.data(), pt.data(), len);
+        }
+        std::size_t buf_len = crypt(enc2, buf.data(), buf.data(), len, seed);
+        check(ct_len == buf_len &&
+                  std::memcmp(ct.data(), buf.data(), ct_len) == 0,
+              name, "in-place encryption", len);
+        if constexpr (has_get_tag<Encryptor>::value)
+        {
+            enc1.get_tag(tag1);
+            enc2.get_tag(tag2);
+            check(std::memcmp(tag1, tag2, 16) == 0, name, "in-place tag", len);
+            params[ParamKey::TAG] = {tag1, 16};
+        }
+
+        // decrypt in place with another split
+        Decryptor dec;
+        dec.init(params);
+        try
+        {
+            std::size_t pt_len =
+                crypt(dec, buf.data(), buf.data(), buf_len, rng());
+            check(pt_len == len &&
+                      (len == 0 ||
+                       std::memcmp(buf.data(), pt.data(), len) == 0),
+                  name, "in-place decryption", len);
+        }
+        catch (const std::exception&)
+        {
+            check(false, name, "in-place decryption throws", len);
+        }
+    }
+}
+
+/**
+ * CbcDecryptor::update_blocks xors each plaintext block with the previous
+ * ciphertext block back to front, so in place a ciphertext block is read
+ * before its slot is overwritten. Compare one-call in-place decryption of
+ * 1 ~ 3 x PARALLEL_NUM + 1 blocks with a block by block reference.
+ */
+template <class Cipher>
+void test_cbc_back_to_front(const char* name)
+{
+    constexpr std::size_t MAX_BLOCK = 3 * Cipher::PARALLEL_NUM + 1;
+
+    for (std::size_t block_num = 1; block_num <= MAX_BLOCK; block_num++)
+    {
+        std::vector<std::uint8_t> key(Cipher::USER_KEY_LEN), iv(16);
+        std::vector<std::uint8_t> ct(16 * block_num), ref(16 * block_num);
+        std::vector<std::uint8_t> buf;
+        fill(key), fill(iv), fill(ct);
+
+        Cipher cipher(key.data(), Cipher::DECRYPTION);
+        for (std::size_t i = 0; i < block_num; i++)
+        {
+            const std::uint8_t* prev = (i == 0) ? iv.data()
+                                                : ct.data() + 16 * (i - 1);
+            cipher.decrypt_block(ref.data() + 16 * i, ct.data() + 16 * i);
+            memory_utils::memxor<16>(ref.data() + 16 * i, ref.data() + 16 * i,
+                                     prev);
+        }
+
+        buf = ct;
+        CbcDecryptor<Cipher> dec(key.data(), iv.data());
+        std::size_t          outl;
+        dec.update(buf.data(), &outl, buf.data(), buf.size());
+        dec.do_final(buf.data() + outl, &outl);
+        check(buf == ref, name, "cbc back-to-front decryption", buf.size());
+    }
+}
+
+} // namespace
+
+#define TEST_MODE(Cipher, Mode, ...)                                     \
+    test_mode<Mode##Encryptor<Cipher>, Mode##Decryptor<Cipher>>(         \
+        #Cipher " " #Mode, __VA_ARGS__)
+
+#define TEST_CIPHER(Cipher)                 \
+    TEST_MODE(Cipher, Ecb, 0, true);        \
+    TEST_MODE(Cipher, Cbc, 16, true);       \
+    TEST_MODE(Cipher, Cfb, 16, false);      \
+    TEST_MODE(Cipher, Ofb, 16, false);      \
+    TEST_MODE(Cipher, Ctr, 16, false);      \
+    TEST_MODE(Cipher, Gcm, 12, false);      \
+    TEST_MODE(Cipher, Ocb, 12, false);      \
+    TEST_MODE(Cipher, Xts, 16, false, 16);  \
+    test_cbc_back_to_front<Cipher>(#Cipher)
+
+int main()
+{
+    TEST_CIPHER(sm4::SM4);
+    TEST_CIPHER(aes::AES128);
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all in-place checks passed\n");
+    return 0;
+}
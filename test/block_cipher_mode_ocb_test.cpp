@@ -0,0 +1,273 @@
+/**
+ * OcbEncryptor / OcbDecryptor checks.
+ *
+ * Known answers from OpenSSL AES-128-OCB on the RFC 7253 appendix A key
+ * and inputs (the first one is RFC 7253's first sample), then SM4 and AES
+ * round trips with split updates, the Ktop cache and tag rejection.
+ */
+#include <gmlib/aes/aes_mode.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x0CB);
+
+/**
+ * key = bytes 0x00 ~ 0x0f, associated data and plaintext are the first
+ * aad_len / pt_len bytes of 0x00, 0x01, ...
+ */
+struct OcbVector
+{
+    std::size_t iv_len, aad_len, pt_len;
+    const char* iv;
+    const char* ct;
+    const char* tag;
+};
+
+const OcbVector AES_OCB_VECTORS[] = {
+    {12, 0, 0,
+     "bbaa99887766554433221100",
+     "",
+     "785407bfffc8ad9edcc5520ac9111ee6"},
+    {12, 8, 8,
+     "bbaa99887766554433221101",
+     "6820b3657b6f615a",
+     "5725bda0d3b4eb3a257c9af1f8f03009"},
+    {12, 0, 8,
+     "bbaa99887766554433221102",
+     "6dd42c17cbf9c783",
+     "5dfd6e630e8f98eb3d2a49b0dc0f314e"},
+    {12, 8, 0,
+     "bbaa99887766554433221103",
+     "",
+     "be4d5464eae0130ab15fde803f261206"},
+    {12, 16, 16,
+     "bbaa99887766554433221104",
+     "571d535b60b277188be5147170a9a22c",
+     "3ad7a4ff3835b8c5701c1ccec8fc3358"},
+    {12, 24, 24,
+     "bbaa99887766554433221107",
+     "1ca2207308c87c010756104d8840ce1952f09673a448a122",
+     "c92c62241051f57356d7f3c90bb0e07f"},
+    {12, 40, 40,
+     "bbaa9988776655443322113f",
+     "03f8ee0abc3abbf1b736ef6bcb073689304441c7273b0b4e"
+     "d28ed2b99721b3c7f17da67a5ca59b12",
+     "ac40ad0fc0af611f7b18a4ea085ade26"},
+    {12, 40, 40,
+     "bbaa99887766554433221140",
+     "ace20b647af4c171ec87bbb7728052120fd739d260880b2e"
+     "5585151a4ddb45242ca78781f741d55e",
+     "2a48a68414126c7d22b4c92b65bae702"},
+    {1, 13, 47,
+     "a5",
+     "80be217a4d0d9cf8bf43c837c0252d17620361c8214b61ba"
+     "51850462389e5d2913cdaab7ba81b1d76271118ca85f51",
+     "ee5298358cafaafb0252774a49d16603"},
+    {15, 33, 63,
+     "a6a7a8a9aaabacadaeafb0b1b2b3b4",
+     "f0e69bb8e2ece7b83f8d5e962bc4e4370df7bc83686b217b"
+     "eea9f81d9afad0789eec130a098313702a0bccafd0f9e382"
+     "63329a82f20a9393437918a6689b56",
+     "6f1cacc45f0810583c1cb6211410d638"},
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+template <class Cryptor>
+std::vector<std::uint8_t> crypt(Cryptor&                         cryptor,
+                                const std::vector<std::uint8_t>& in,
+                                const std::vector<std::size_t>&  splits)
+{
+    std::vector<std::uint8_t> out(in.size() + 16);
+    std::size_t               pos = 0, total = 0, outl;
+    for (std::size_t i = 0; i <= splits.size(); i++)
+    {
+        std::size_t size = in.size() - pos;
+        if (i < splits.size() && splits[i] < size)
+        {
+            size = splits[i];
+        }
+        outl = 0;
+        cryptor.update(out.data() + total, &outl, in.data() + pos, size);
+        pos += size, total += outl;
+    }
+    cryptor.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+void test_known_answer()
+{
+    std::uint8_t key[16], data[64];
+    for (int i = 0; i < 16; i++)
+    {
+        key[i] = (std::uint8_t)i;
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        data[i] = (std::uint8_t)i;
+    }
+    // one encryptor, re-used with reset, exercises the Ktop cache
+    aes::AES128OcbEncryptor enc(key, data, 1, nullptr, 0);
+    for (const OcbVector& v : AES_OCB_VECTORS)
+    {
+        std::vector<std::uint8_t> iv = from_hex(v.iv), tag(16);
+        std::vector<std::uint8_t> pt(data, data + v.pt_len);
+        std::vector<std::uint8_t> ct = from_hex(v.ct);
+
+        enc.reset(iv.data(), v.iv_len, data, v.aad_len);
+        check(crypt(enc, pt, {}) == ct, "AES128 OCB", "known answer");
+        enc.get_tag(tag.data());
+        check(tag == from_hex(v.tag), "AES128 OCB", "known answer tag");
+
+        aes::AES128OcbDecryptor dec(key, iv.data(), v.iv_len, data,
+                                    v.aad_len);
+        dec.set_tag(tag.data());
+        check(crypt(dec, ct, {}) == pt, "AES128 OCB", "known answer dec");
+    }
+}
+
+template <class Enc, class Dec>
+void test_random(const char* name)
+{
+    for (int round = 0; round < 200; round++)
+    {
+        std::uint8_t key[Enc::USER_KEY_LEN], iv[15];
+        for (std::uint8_t& b : key)
+        {
+            b = (std::uint8_t)rng();
+        }
+        for (std::uint8_t& b : iv)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::size_t               iv_len = 1 + rng() % 15;
+        std::vector<std::uint8_t> aad(rng() % 300), pt(rng() % 1000);
+        for (std::uint8_t& b : aad)
+        {
+            b = (std::uint8_t)rng();
+        }
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::size_t> split(rng() % 8);
+        for (std::size_t& size : split)
+        {
+            size = rng() % 100;
+        }
+
+        std::uint8_t tag1[16], tag2[16];
+        Enc          enc(key, iv, iv_len, aad.data(), aad.size());
+        auto         ct = crypt(enc, pt, {});
+        enc.get_tag(tag1);
+        enc.reset(iv, iv_len, aad.data(), aad.size());
+        check(crypt(enc, pt, split) == ct, name, "split updates");
+        enc.get_tag(tag2);
+        check(std::memcmp(tag1, tag2, 16) == 0, name, "split updates tag");
+
+        Dec dec(key, iv, iv_len, aad.data(), aad.size());
+        dec.set_tag(tag1);
+        check(crypt(dec, ct, split) == pt, name, "decrypt");
+
+        // any flipped bit of tag, ciphertext or aad is rejected
+        const int where = round % 3;
+        if (where == 1 && ct.empty())
+        {
+            continue;
+        }
+        if (where == 2 && aad.empty())
+        {
+            continue;
+        }
+        tag2[rng() % 16] ^= 0x01;
+        if (where == 1)
+        {
+            ct[rng() % ct.size()] ^= 0x80;
+        }
+        if (where == 2)
+        {
+            aad[rng() % aad.size()] ^= 0x40;
+        }
+        dec.reset(iv, iv_len, aad.data(), aad.size());
+        dec.set_tag(where == 0 ? tag2 : tag1);
+        bool thrown = false;
+        try
+        {
+            crypt(dec, ct, split);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, name, "forgery rejected");
+    }
+}
+
+void test_iv_len()
+{
+    std::uint8_t key[16] = {0}, iv[16] = {0};
+    for (std::size_t iv_len : {(std::size_t)0, (std::size_t)16})
+    {
+        bool thrown = false;
+        try
+        {
+            sm4::SM4OcbEncryptor(key, iv, iv_len, nullptr, 0);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "SM4 OCB", "invalid iv len rejected");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_random<sm4::SM4OcbEncryptor, sm4::SM4OcbDecryptor>("SM4 OCB");
+    test_random<aes::AES128OcbEncryptor, aes::AES128OcbDecryptor>(
+        "AES128 OCB");
+    test_iv_len();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all OCB checks passed\n");
+    return 0;
+}
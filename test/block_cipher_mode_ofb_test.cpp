@@ -0,0 +1,214 @@
+/**
+ * OfbCryptor checks, with and without precompute.
+ *
+ * Known answer from OpenSSL SM4-OFB, fed in split updates with a partial
+ * last block, then precomputed streams shorter than, equal to and longer
+ * than the message (past the ring size) compared with inline generation.
+ */
+#include <gmlib/aes/aes_mode.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x0FB);
+
+const std::uint8_t KEY[16] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+    0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+};
+
+const std::uint8_t IV[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+// SM4-OFB of bytes 0x00 ~ 0x63
+const std::uint8_t SM4_OFB_CT[100] = {
+    0x06, 0x99, 0x9e, 0x62, 0x39, 0xa3, 0x6e, 0xaa, 0x22, 0x84, 0xfd, 0x89,
+    0xed, 0xa5, 0xf7, 0x65, 0xe3, 0xfe, 0x50, 0x5f, 0xa3, 0x96, 0x4c, 0x6a,
+    0x79, 0x46, 0xf6, 0x8f, 0xc1, 0x3e, 0xf6, 0x3f, 0x7b, 0x66, 0xba, 0x6b,
+    0xab, 0x2c, 0x21, 0x0f, 0x18, 0xc7, 0x2e, 0x0d, 0x08, 0x9d, 0x70, 0xcd,
+    0x07, 0x23, 0x7a, 0xf6, 0x4c, 0xdc, 0x5d, 0x0c, 0xc3, 0xcd, 0x30, 0xb1,
+    0xfe, 0x03, 0xc5, 0x10, 0xd7, 0xc5, 0x79, 0xf4, 0xf8, 0x37, 0x01, 0x7d,
+    0x5a, 0x99, 0x1f, 0xb1, 0xce, 0x31, 0x3d, 0x8f, 0x58, 0x8b, 0x1b, 0xe1,
+    0x6a, 0xa6, 0x76, 0xec, 0xaa, 0xd2, 0xfb, 0xd4, 0x34, 0x91, 0x9d, 0x9e,
+    0xae, 0x29, 0x28, 0xb4,
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+/**
+ * @brief           crypt in by updates of the given sizes, then do_final
+ * @param   splits  update sizes, the rest of in goes in a last update
+ */
+template <class Cryptor>
+std::vector<std::uint8_t> crypt(Cryptor&                        cryptor,
+                                const std::vector<std::uint8_t>& in,
+                                const std::vector<std::size_t>&  splits)
+{
+    std::vector<std::uint8_t> out(in.size() + Cryptor::BLOCK_SIZE);
+    std::size_t               pos = 0, total = 0, outl;
+    for (std::size_t i = 0; i <= splits.size(); i++)
+    {
+        std::size_t size = in.size() - pos;
+        if (i < splits.size() && splits[i] < size)
+        {
+            size = splits[i];
+        }
+        outl = 0;
+        cryptor.update(out.data() + total, &outl, in.data() + pos, size);
+        pos += size, total += outl;
+    }
+    cryptor.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+void test_known_answer()
+{
+    std::vector<std::uint8_t> pt(100);
+    for (std::size_t i = 0; i < pt.size(); i++)
+    {
+        pt[i] = (std::uint8_t)i;
+    }
+    std::vector<std::uint8_t> expect(SM4_OFB_CT, SM4_OFB_CT + 100);
+
+    const std::vector<std::size_t> splits[] = {
+        {},
+        {1, 15, 17, 31, 33},
+        {16, 16, 16, 16, 16, 16},
+        {7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7},
+    };
+    // 100 bytes is 7 key stream blocks, the last one partial
+    const std::size_t pre_nums[] = {0, 1, 3, 6, 7, 8, 20};
+    for (const auto& split : splits)
+    {
+        for (std::size_t pre_num : pre_nums)
+        {
+            sm4::SM4OfbEncryptor enc(KEY, IV);
+            enc.precompute(pre_num);
+            check(crypt(enc, pt, split) == expect, "SM4 OFB", "known answer");
+
+            // decrypt the same way, after a reset
+            enc.reset(IV);
+            enc.precompute(pre_num);
+            check(crypt(enc, expect, split) == pt, "SM4 OFB", "decrypt");
+        }
+    }
+}
+
+/**
+ * random messages and precompute lengths, including ones longer than the
+ * ring, compared with inline generation
+ */
+template <class Cryptor>
+void test_random(const char* name)
+{
+    for (int round = 0; round < 40; round++)
+    {
+        std::uint8_t key[Cryptor::USER_KEY_LEN], iv[Cryptor::BLOCK_SIZE];
+        for (std::uint8_t& b : key)
+        {
+            b = (std::uint8_t)rng();
+        }
+        for (std::uint8_t& b : iv)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::uint8_t> pt(rng() % 120000);
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::size_t> split(rng() % 20);
+        for (std::size_t& size : split)
+        {
+            size = rng() % 9000;
+        }
+        std::size_t pre_num = rng() % 9000;
+
+        Cryptor inline_enc(key, iv);
+        Cryptor pre_enc(key, iv);
+        pre_enc.precompute(pre_num);
+        check(crypt(pre_enc, pt, split) == crypt(inline_enc, pt, {}), name,
+              "precompute output");
+    }
+}
+
+void test_state()
+{
+    std::vector<std::uint8_t> pt(100);
+    for (std::size_t i = 0; i < pt.size(); i++)
+    {
+        pt[i] = (std::uint8_t)i;
+    }
+    std::vector<std::uint8_t> expect(SM4_OFB_CT, SM4_OFB_CT + 100);
+
+    // a second precompute while the first one is not consumed
+    {
+        sm4::SM4OfbEncryptor enc(KEY, IV);
+        bool                 thrown = false;
+        enc.precompute(10000);
+        try
+        {
+            enc.precompute(1);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "SM4 OFB", "precompute in progress rejected");
+    }
+    // moved while the helper thread runs
+    {
+        sm4::SM4OfbEncryptor enc(KEY, IV);
+        enc.precompute(5000);
+        sm4::SM4OfbEncryptor moved(std::move(enc));
+        check(crypt(moved, pt, {50}) == expect, "SM4 OFB", "moved");
+    }
+    // re-keyed and destroyed with unconsumed key stream
+    {
+        sm4::SM4OfbEncryptor enc(KEY, IV);
+        enc.precompute(9000);
+        enc.init(KEY, IV);
+        check(crypt(enc, pt, {}) == expect, "SM4 OFB", "init stops helper");
+        enc.precompute(9000);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_random<sm4::SM4OfbEncryptor>("SM4 OFB");
+    test_random<OfbEncryptor<aes::AES128>>("AES128 OFB");
+    test_state();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all OFB checks passed\n");
+    return 0;
+}
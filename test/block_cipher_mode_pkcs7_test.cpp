@@ -0,0 +1,306 @@
+/**
+ * PKCS7 padding checks (EcbEncryptor/EcbDecryptor, CbcEncryptor/CbcDecryptor).
+ *
+ * Known answers from OpenSSL SM4-CBC / SM4-ECB, round trips for every pad
+ * length 1 ~ 16 with split updates, pkcs7_check against a plain reference,
+ * and corrupted padding or length, which must all fail with the same error
+ * and leave no plaintext of the bad block in the output.
+ */
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x7C5);
+
+const char* ERROR_MESSAGE = "pkcs7 decryption failed";
+
+/**
+ * OpenSSL SM4-CBC, key = 0123456789abcdeffedcba9876543210,
+ * iv = 0x00 ~ 0x0f, plaintext is the first pt_len bytes of 0x00, 0x01 ...
+ */
+struct CbcVector
+{
+    std::size_t pt_len;
+    const char* ct;
+};
+
+const CbcVector SM4_CBC_VECTORS[] = {
+    {0, "4b910651754b5553f10cfa0c8a09e9e5"},
+    {1, "1959f0f91c5cde355e10f33c074317a7"},
+    {15, "4d950697534850c92dca2e02785d5ef4"},
+    {16, "2677f46b09c122cc975533105bd4a22a3b880e6867772522ae55d2f0ae7478ae"},
+    {17, "2677f46b09c122cc975533105bd4a22afa0d4b95a5e96da824f52031975c7efc"},
+    {31, "2677f46b09c122cc975533105bd4a22a1bb67ca6b6a7a8b99bec2690a9f3366d"},
+};
+
+// OpenSSL SM4-ECB, the same key, 20 bytes 0x00 ~ 0x13
+const char* SM4_ECB_20 =
+    "06989c613da668ad2a8df782e1a8f96a863272cc695ec2f5a2e22a66a13616a4";
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+template <class Cryptor>
+std::vector<std::uint8_t> crypt(Cryptor&                         cryptor,
+                                const std::vector<std::uint8_t>& in,
+                                std::size_t                      split)
+{
+    std::vector<std::uint8_t> out(in.size() + 16);
+    std::size_t               total = 0, outl = 0;
+    for (std::size_t pos = 0; pos < in.size(); pos += split)
+    {
+        std::size_t size = std::min(split, in.size() - pos);
+        cryptor.update(out.data() + total, &outl, in.data() + pos, size);
+        total += outl;
+    }
+    cryptor.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+/// @brief the padding length or 0, straight from the definition
+std::size_t ref_pad_len(const std::uint8_t block[16])
+{
+    std::size_t pad = block[15];
+    if (pad == 0 || pad > 16)
+    {
+        return 0;
+    }
+    for (std::size_t i = 16 - pad; i < 16; i++)
+    {
+        if (block[i] != pad)
+        {
+            return 0;
+        }
+    }
+    return pad;
+}
+
+void test_known_answer()
+{
+    auto key = from_hex("0123456789abcdeffedcba9876543210");
+    auto iv  = from_hex("000102030405060708090a0b0c0d0e0f");
+    for (const CbcVector& v : SM4_CBC_VECTORS)
+    {
+        std::vector<std::uint8_t> pt(v.pt_len);
+        for (std::size_t i = 0; i < pt.size(); i++)
+        {
+            pt[i] = (std::uint8_t)i;
+        }
+        sm4::SM4CbcEncryptor enc(key.data(), iv.data(), true);
+        check(crypt(enc, pt, 7) == from_hex(v.ct), "SM4 CBC", "known answer");
+        sm4::SM4CbcDecryptor dec(key.data(), iv.data(), true);
+        check(crypt(dec, from_hex(v.ct), 5) == pt, "SM4 CBC",
+              "known answer dec");
+    }
+
+    std::vector<std::uint8_t> pt(20);
+    for (std::size_t i = 0; i < pt.size(); i++)
+    {
+        pt[i] = (std::uint8_t)i;
+    }
+    sm4::SM4EcbEncryptor enc(key.data(), true);
+    check(crypt(enc, pt, 20) == from_hex(SM4_ECB_20), "SM4 ECB",
+          "known answer");
+    sm4::SM4EcbDecryptor dec(key.data(), true);
+    check(crypt(dec, from_hex(SM4_ECB_20), 3) == pt, "SM4 ECB",
+          "known answer dec");
+}
+
+/// @brief every pad length 1 ~ 16, over one and several blocks
+void test_pad_len()
+{
+    std::uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; i++)
+    {
+        key[i] = (std::uint8_t)rng(), iv[i] = (std::uint8_t)rng();
+    }
+    for (std::size_t len = 0; len < 64; len++)
+    {
+        std::vector<std::uint8_t> pt(len);
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::size_t split = 1 + rng() % 20;
+        std::size_t pad   = 16 - len % 16;
+
+        sm4::SM4EcbEncryptor ecb_enc(key, true);
+        sm4::SM4EcbDecryptor ecb_dec(key, true);
+        auto                 ct = crypt(ecb_enc, pt, split);
+        check(ct.size() == len + pad, "SM4 ECB", "padded length");
+        check(crypt(ecb_dec, ct, split) == pt, "SM4 ECB", "round trip");
+
+        sm4::SM4CbcEncryptor cbc_enc(key, iv, true);
+        sm4::SM4CbcDecryptor cbc_dec(key, iv, true);
+        ct = crypt(cbc_enc, pt, split);
+        check(ct.size() == len + pad, "SM4 CBC", "padded length");
+        check(crypt(cbc_dec, ct, split) == pt, "SM4 CBC", "round trip");
+    }
+}
+
+void test_check()
+{
+    std::uint8_t block[16];
+    std::size_t  pad;
+    for (int round = 0; round < 20000; round++)
+    {
+        for (std::uint8_t& b : block)
+        {
+            b = (std::uint8_t)rng();
+        }
+        // mostly valid or nearly valid padding
+        std::size_t n = rng() % 18;
+        std::memset(block + 16 - std::min<std::size_t>(n, 16), (int)n,
+                    std::min<std::size_t>(n, 16));
+        if (round % 2)
+        {
+            block[rng() % 16] ^= (std::uint8_t)(1 << (rng() % 8));
+        }
+        std::size_t ok = internal::pkcs7_check<16>(block, &pad);
+        std::size_t expect = ref_pad_len(block);
+        check(ok == (expect ? ~(std::size_t)0 : 0) && pad == expect,
+              "pkcs7_check", "against reference");
+    }
+}
+
+/**
+ * @brief   decrypt ct, expect the generic error and a zeroed last block
+ */
+template <class Dec>
+void expect_failure(Dec& dec, const std::vector<std::uint8_t>& ct,
+                    const char* name, const char* what)
+{
+    std::vector<std::uint8_t> out(ct.size() + 16, 0xAA);
+    std::size_t               outl = 0;
+    std::string               msg;
+    try
+    {
+        dec.update(out.data(), &outl, ct.data(), ct.size());
+        std::size_t final_len;
+        dec.do_final(out.data() + outl, &final_len);
+    }
+    catch (const std::runtime_error& e)
+    {
+        msg = e.what();
+    }
+    check(msg == ERROR_MESSAGE, name, what);
+    if (ct.size() % 16 == 0 && !ct.empty())
+    {
+        bool zero = true;
+        for (std::size_t i = ct.size() - 16; i < ct.size(); i++)
+        {
+            zero = zero && out[i] == 0;
+        }
+        check(zero, name, "bad block cleared");
+    }
+}
+
+void test_corrupted()
+{
+    std::uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; i++)
+    {
+        key[i] = (std::uint8_t)rng(), iv[i] = (std::uint8_t)rng();
+    }
+    for (int round = 0; round < 500; round++)
+    {
+        // a valid padded plaintext, then one byte of the last block broken
+        std::size_t               blocks = 1 + rng() % 3;
+        std::size_t               pad    = 1 + rng() % 16;
+        std::vector<std::uint8_t> pt(blocks * 16);
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::memset(pt.data() + pt.size() - pad, (int)pad, pad);
+        switch (round % 4)
+        {
+            case 0: pt.back() = 0; break;
+            case 1: pt.back() = (std::uint8_t)(17 + rng() % 239); break;
+            default:
+                if (pad == 1)
+                {
+                    pt.back() = 2, pt[pt.size() - 2] = 3;
+                }
+                else
+                {
+                    pt[pt.size() - 1 - rng() % pad] ^= 0x10;
+                    pt.back() = (std::uint8_t)pad;
+                }
+                break;
+        }
+        if (ref_pad_len(pt.data() + pt.size() - 16) != 0)
+        {
+            continue;
+        }
+
+        // encrypt without padding
+        sm4::SM4EcbEncryptor ecb_enc(key);
+        sm4::SM4EcbDecryptor ecb_dec(key, true);
+        expect_failure(ecb_dec, crypt(ecb_enc, pt, 16), "SM4 ECB",
+                       "corrupted padding");
+        sm4::SM4CbcEncryptor cbc_enc(key, iv);
+        sm4::SM4CbcDecryptor cbc_dec(key, iv, true);
+        expect_failure(cbc_dec, crypt(cbc_enc, pt, 16), "SM4 CBC",
+                       "corrupted padding");
+    }
+
+    // empty ciphertext, or not a whole number of blocks
+    for (std::size_t len : {0, 1, 15, 17, 33})
+    {
+        std::vector<std::uint8_t> ct(len, 0x5C);
+        sm4::SM4EcbDecryptor      ecb_dec(key, true);
+        expect_failure(ecb_dec, ct, "SM4 ECB", "bad length");
+        sm4::SM4CbcDecryptor cbc_dec(key, iv, true);
+        expect_failure(cbc_dec, ct, "SM4 CBC", "bad length");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_pad_len();
+    test_check();
+    test_corrupted();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all PKCS7 checks passed\n");
+    return 0;
+}
@@ -0,0 +1,346 @@
+/**
+ * XtsEncryptor / XtsDecryptor checks.
+ *
+ * Known answers from OpenSSL AES-128-XTS (whole blocks and ciphertext
+ * stealing), then SM4 and AES against a block-at-a-time IEEE P1619
+ * reference: split updates, crypt_sector, crypt_sectors and short input.
+ */
+#include <gmlib/aes/aes_mode.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x715);
+
+// key1 || key2 = bytes 0x00 ~ 0x1f
+const std::uint8_t IV[16] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+};
+
+// AES-128-XTS of bytes 0x00 ~ 0x63
+const std::uint8_t AES_XTS_CT100[100] = {
+    0x3d, 0x75, 0x7a, 0xb1, 0x7f, 0xdb, 0x54, 0x7c, 0x9b, 0x12, 0xdd, 0xaa,
+    0x13, 0x64, 0xa7, 0x2c, 0x61, 0xfe, 0x31, 0x72, 0x05, 0xd3, 0x68, 0x32,
+    0x66, 0xbb, 0x06, 0x49, 0x83, 0x55, 0xca, 0x56, 0x6d, 0x8e, 0xe4, 0xc3,
+    0xaa, 0x8f, 0xd6, 0x19, 0x49, 0xd8, 0xd6, 0x6a, 0x03, 0x8e, 0xd5, 0x9c,
+    0xb6, 0xc8, 0x20, 0x94, 0xfd, 0x9b, 0x10, 0xbc, 0xf6, 0x76, 0xd3, 0x93,
+    0x9f, 0x0f, 0x8c, 0xcf, 0xde, 0x7c, 0xa4, 0x8b, 0x92, 0xd8, 0x63, 0xcf,
+    0x4b, 0xd1, 0x1d, 0x53, 0x24, 0xd3, 0x00, 0x86, 0x3d, 0x67, 0xa2, 0x42,
+    0x10, 0xc6, 0x00, 0x72, 0x99, 0xac, 0x51, 0x0d, 0xf3, 0xc0, 0xa0, 0xf0,
+    0x96, 0x3d, 0x28, 0xe2,
+};
+
+// AES-128-XTS of bytes 0x00 ~ 0x3f
+const std::uint8_t AES_XTS_CT64[64] = {
+    0x3d, 0x75, 0x7a, 0xb1, 0x7f, 0xdb, 0x54, 0x7c, 0x9b, 0x12, 0xdd, 0xaa,
+    0x13, 0x64, 0xa7, 0x2c, 0x61, 0xfe, 0x31, 0x72, 0x05, 0xd3, 0x68, 0x32,
+    0x66, 0xbb, 0x06, 0x49, 0x83, 0x55, 0xca, 0x56, 0x6d, 0x8e, 0xe4, 0xc3,
+    0xaa, 0x8f, 0xd6, 0x19, 0x49, 0xd8, 0xd6, 0x6a, 0x03, 0x8e, 0xd5, 0x9c,
+    0xb6, 0xc8, 0x20, 0x94, 0xfd, 0x9b, 0x10, 0xbc, 0xf6, 0x76, 0xd3, 0x93,
+    0x9f, 0x0f, 0x8c, 0xcf,
+};
+
+// AES-128-XTS of bytes 0x00 ~ 0x24
+const std::uint8_t AES_XTS_CT37[37] = {
+    0x3d, 0x75, 0x7a, 0xb1, 0x7f, 0xdb, 0x54, 0x7c, 0x9b, 0x12, 0xdd, 0xaa,
+    0x13, 0x64, 0xa7, 0x2c, 0x00, 0x47, 0xea, 0x98, 0x62, 0x8f, 0x31, 0x79,
+    0xb9, 0x32, 0xd4, 0xee, 0xdb, 0x36, 0x27, 0x11, 0x61, 0xfe, 0x31, 0x72,
+    0x05,
+};
+
+// AES-128-XTS of bytes 0x00 ~ 0x10
+const std::uint8_t AES_XTS_CT17[17] = {
+    0x36, 0xba, 0x44, 0x3a, 0x75, 0xbe, 0xaf, 0xbe, 0x60,
+    0x7d, 0xbd, 0x5e, 0x92, 0x1e, 0x88, 0xca, 0x3d,
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+/// @brief tweak x alpha in GF(2^128), little endian
+void ref_double(std::uint8_t t[16])
+{
+    unsigned carry = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        unsigned next = t[i] >> 7;
+        t[i]          = (std::uint8_t)((t[i] << 1) | carry);
+        carry         = next;
+    }
+    if (carry)
+    {
+        t[0] ^= 0x87;
+    }
+}
+
+/// @brief one block at a time IEEE P1619 XTS, len >= 16
+template <class Cipher>
+std::vector<std::uint8_t> ref_xts(const std::uint8_t*              key,
+                                  const std::uint8_t*              iv,
+                                  const std::vector<std::uint8_t>& in,
+                                  bool                             enc)
+{
+    Cipher c1, c2;
+    c1.set_key(key, enc ? Cipher::ENCRYPTION : Cipher::DECRYPTION);
+    c2.set_key(key + Cipher::USER_KEY_LEN, Cipher::ENCRYPTION);
+
+    auto crypt = [&](std::uint8_t* out, const std::uint8_t* blk,
+                     const std::uint8_t* t) {
+        std::uint8_t buf[16];
+        for (int i = 0; i < 16; i++)
+        {
+            buf[i] = blk[i] ^ t[i];
+        }
+        if (enc)
+        {
+            c1.encrypt_block(buf, buf);
+        }
+        else
+        {
+            c1.decrypt_block(buf, buf);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            out[i] = buf[i] ^ t[i];
+        }
+    };
+
+    std::vector<std::uint8_t> out(in.size());
+    std::uint8_t              t[16];
+    c2.encrypt_block(t, iv);
+    std::size_t r = in.size() % 16, m = in.size() / 16 - (r ? 1 : 0);
+    for (std::size_t i = 0; i < m; i++)
+    {
+        crypt(out.data() + 16 * i, in.data() + 16 * i, t);
+        ref_double(t);
+    }
+    if (r == 0)
+    {
+        return out;
+    }
+    std::uint8_t t2[16], pp[16], cc[16];
+    std::memcpy(t2, t, 16);
+    ref_double(t2);
+    const std::uint8_t* tail = in.data() + 16 * m;
+    // the second to last block uses the later tweak when decrypting
+    crypt(pp, tail, enc ? t : t2);
+    std::memcpy(cc, tail + 16, r);
+    std::memcpy(cc + r, pp + r, 16 - r);
+    crypt(out.data() + 16 * m, cc, enc ? t2 : t);
+    std::memcpy(out.data() + 16 * m + 16, pp, r);
+    return out;
+}
+
+template <class Cryptor>
+std::vector<std::uint8_t> crypt(Cryptor&                         cryptor,
+                                const std::vector<std::uint8_t>& in,
+                                const std::vector<std::size_t>&  splits)
+{
+    std::vector<std::uint8_t> out(in.size() + 32);
+    std::size_t               pos = 0, total = 0, outl;
+    for (std::size_t i = 0; i <= splits.size(); i++)
+    {
+        std::size_t size = in.size() - pos;
+        if (i < splits.size() && splits[i] < size)
+        {
+            size = splits[i];
+        }
+        outl = 0;
+        cryptor.update(out.data() + total, &outl, in.data() + pos, size);
+        pos += size, total += outl;
+    }
+    cryptor.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+void test_known_answer()
+{
+    std::uint8_t key[32];
+    for (int i = 0; i < 32; i++)
+    {
+        key[i] = (std::uint8_t)i;
+    }
+    struct
+    {
+        const std::uint8_t* ct;
+        std::size_t         len;
+    } vectors[] = {
+        {AES_XTS_CT100, 100},
+        {AES_XTS_CT64, 64},
+        {AES_XTS_CT37, 37},
+        {AES_XTS_CT17, 17},
+    };
+    for (const auto& v : vectors)
+    {
+        std::vector<std::uint8_t> pt(v.len), ct(v.ct, v.ct + v.len);
+        for (std::size_t i = 0; i < v.len; i++)
+        {
+            pt[i] = (std::uint8_t)i;
+        }
+        XtsEncryptor<aes::AES128> enc(key, IV);
+        XtsDecryptor<aes::AES128> dec(key, IV);
+        check(crypt(enc, pt, {}) == ct, "AES128 XTS", "known answer");
+        check(crypt(dec, ct, {}) == pt, "AES128 XTS", "known answer dec");
+        check(ref_xts<aes::AES128>(key, IV, pt, true) == ct, "AES128 XTS",
+              "reference");
+    }
+}
+
+template <class Cipher>
+void test_random(const char* name)
+{
+    using Enc = XtsEncryptor<Cipher>;
+    using Dec = XtsDecryptor<Cipher>;
+
+    for (int round = 0; round < 200; round++)
+    {
+        std::uint8_t key[Enc::USER_KEY_LEN], iv[16];
+        for (std::uint8_t& b : key)
+        {
+            b = (std::uint8_t)rng();
+        }
+        for (std::uint8_t& b : iv)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::uint8_t> pt(16 + rng() % 600);
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::size_t> split(rng() % 8);
+        for (std::size_t& size : split)
+        {
+            size = rng() % 70;
+        }
+        std::vector<std::uint8_t> expect = ref_xts<Cipher>(key, iv, pt, true);
+
+        Enc enc(key, iv);
+        Dec dec(key, iv);
+        check(crypt(enc, pt, split) == expect, name, "encrypt");
+        check(crypt(dec, expect, split) == pt, name, "decrypt");
+        check(ref_xts<Cipher>(key, iv, expect, false) == pt, name,
+              "reference decrypt");
+
+        // reset restarts the data unit
+        enc.reset(iv);
+        check(crypt(enc, pt, {}) == expect, name, "reset");
+
+        std::vector<std::uint8_t> out(pt.size());
+        enc.crypt_sector(out.data(), pt.data(), pt.size(), iv);
+        check(out == expect, name, "crypt_sector");
+        dec.crypt_sector(out.data(), expect.data(), expect.size(), iv);
+        check(out == pt, name, "crypt_sector dec");
+    }
+}
+
+/// @brief sector i uses data unit number index + i, 128-bit little endian
+template <class Cipher>
+void test_sectors(const char* name)
+{
+    using Enc = XtsEncryptor<Cipher>;
+
+    const std::uint64_t indexes[] = {0, 7, UINT64_MAX - 3};
+    for (std::uint64_t index : indexes)
+    {
+        std::uint8_t key[Enc::USER_KEY_LEN];
+        for (std::uint8_t& b : key)
+        {
+            b = (std::uint8_t)rng();
+        }
+        const std::size_t sector_size = 16 * 3 + 5, sector_num = 11;
+        std::vector<std::uint8_t> pt(sector_size * sector_num);
+        std::vector<std::uint8_t> out(pt.size());
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        Enc enc(key, IV);
+        enc.crypt_sectors(out.data(), pt.data(), sector_size, sector_num,
+                          index);
+        for (std::size_t i = 0; i < sector_num; i++)
+        {
+            std::uint8_t  iv[16] = {0};
+            std::uint64_t lo     = index + i;
+            for (int j = 0; j < 8; j++)
+            {
+                iv[j] = (std::uint8_t)(lo >> (8 * j));
+            }
+            iv[8] = (lo < index) ? 1 : 0;
+            std::vector<std::uint8_t> sector(
+                pt.begin() + sector_size * i,
+                pt.begin() + sector_size * (i + 1));
+            check(std::memcmp(out.data() + sector_size * i,
+                              ref_xts<Cipher>(key, iv, sector, true).data(),
+                              sector_size) == 0,
+                  name, "crypt_sectors");
+        }
+    }
+}
+
+void test_short_input()
+{
+    std::uint8_t key[32] = {0}, buf[16] = {0};
+    bool         thrown  = false;
+    try
+    {
+        sm4::SM4XtsEncryptor enc(key, IV);
+        std::size_t          outl;
+        enc.update(buf, &outl, buf, 15);
+        enc.do_final(buf, &outl);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    check(thrown, "SM4 XTS", "input shorter than a block rejected");
+
+    thrown = false;
+    try
+    {
+        sm4::SM4XtsEncryptor(key, IV).crypt_sector(buf, buf, 15, IV);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    check(thrown, "SM4 XTS", "sector shorter than a block rejected");
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_random<sm4::SM4>("SM4 XTS");
+    test_random<aes::AES128>("AES128 XTS");
+    test_sectors<sm4::SM4>("SM4 XTS");
+    test_sectors<aes::AES128>("AES128 XTS");
+    test_short_input();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all XTS checks passed\n");
+    return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * PBKDF2-HMAC / HKDF checks, with SM3.
+ *
+ * OpenSSL SM3 PBKDF2 and HKDF known answers through the generic
+ * hash_lib functions and the multi-lane sm3::pbkdf2_hmac_sm3, then random
+ * password batches through sm3::pbkdf2_hmac_sm3_many against the generic
+ * PBKDF2, and the parameter errors.
+ */
+#include <gmlib/hash_lib/hkdf.h>
+#include <gmlib/hash_lib/pbkdf2.h>
+#include <gmlib/sm3/sm3.h>
+#include <gmlib/sm3/sm3_pbkdf2.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x4DF);
+
+struct Pbkdf2Vector
+{
+    const char* password;
+    const char* salt;
+    std::size_t iter;
+    const char* dk;
+};
+
+// openssl kdf -kdfopt digest:SM3 PBKDF2
+const Pbkdf2Vector PBKDF2_VECTORS[] = {
+    {"password", "salt", 1,
+     "4612f922a1fdcefaf4312fc6f8f3322b489cbf24f2ea361b44c2bd8fa2c6dcb0"},
+    {"password", "salt", 2,
+     "fee723a2bc966e11dffb66133f4e8df577383c78ade30e3298edbd3e54ed85b7"},
+    {"password", "salt", 4096,
+     "b6e8f2074c87432b78f62e5ced980fdff89e86af2f693dab1638e2b3683045dd"},
+    {"passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096,
+     "3b6282ac8519f059e465abff0ea37b0dbfe6c672a76e6b805312d53900db630732cc"
+     "c1a88fa5512a6e8bbd7e48d336632a254dd72a4ced777cd6fa094665db77f64dcc35"
+     "208fc0950b9745e424a665f6b12b954d7a2139b05781cbebe95c3420ca3305cc"},
+    {"", "salt", 3,
+     "f64e1dcfe8b2deeb5466e843c8d607b1f13b2aabf1a5a747100e4b2515aabf891d0b"
+     "c8485fe44e8a2d5dbf494d97262521d757b500cdaf9771bf26a94ff6aea5"},
+    {"pass", "sa", 4096, "5d460023db953370275c5a9cb96be669"},
+};
+
+struct HkdfVector
+{
+    const char* ikm;
+    const char* salt; // nullptr for none
+    const char* info;
+    const char* prk;  // nullptr when not checked
+    const char* okm;
+};
+
+// openssl kdf -kdfopt digest:SM3 HKDF, RFC 5869 test case 1 ~ 3 inputs
+const HkdfVector HKDF_VECTORS[] = {
+    {"0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+     "000102030405060708090a0b0c", "f0f1f2f3f4f5f6f7f8f9",
+     "e0d6f7b0bd056327b7659f1f39ad850561fbcf4fb10fb58e88eafa55cf7cd01e",
+     "c69fe91b7aaee2dd5718d72dcaee0cce93f1b8e41f792da51261b6a517e68b36ed2c"
+     "595572b01dfa359b"},
+    {"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f2021"
+     "22232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f40414243"
+     "4445464748494a4b4c4d4e4f",
+     "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f8081"
+     "82838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9fa0a1a2a3"
+     "a4a5a6a7a8a9aaabacadaeaf",
+     "b0b1b2b3b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1"
+     "d2d3d4d5d6d7d8d9dadbdcdddedfe0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3"
+     "f4f5f6f7f8f9fafbfcfdfeff",
+     nullptr,
+     "c1226236bbdefa7921f9febe27b864f33e449201b436d8844ea53f58170dd6426def"
+     "bd22ed1f3c5960f35523e62e3b6c0d657f2c61893436f539013199bfaef25aafd1e7"
+     "726ede927623a9f5cbb8885c7e5d"},
+    {"0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b", nullptr, "", nullptr,
+     "c8c91a38ae2fb3b023a7c38ce9f0748f28230d59b6b950ba3ba949bf0d713a577481"
+     "5778801741cb2034"},
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+template <class F>
+bool throws(F f)
+{
+    try
+    {
+        f();
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+void test_pbkdf2_known_answer()
+{
+    for (const Pbkdf2Vector& v : PBKDF2_VECTORS)
+    {
+        auto        expect   = from_hex(v.dk);
+        auto        pw       = (const std::uint8_t*)v.password;
+        auto        salt     = (const std::uint8_t*)v.salt;
+        std::size_t pw_len   = std::strlen(v.password);
+        std::size_t salt_len = std::strlen(v.salt);
+
+        std::vector<std::uint8_t> dk(expect.size());
+        hash_lib::pbkdf2_hmac<sm3::SM3>(dk.data(), dk.size(), pw, pw_len,
+                                        salt, salt_len, v.iter);
+        check(dk == expect, "pbkdf2_hmac<SM3>", "known answer");
+
+        std::fill(dk.begin(), dk.end(), 0);
+        sm3::pbkdf2_hmac_sm3(dk.data(), dk.size(), pw, pw_len, salt,
+                             salt_len, v.iter);
+        check(dk == expect, "pbkdf2_hmac_sm3", "known answer");
+    }
+}
+
+void test_pbkdf2_many()
+{
+    for (int round = 0; round < 20; round++)
+    {
+        std::size_t num     = rng() % 20;
+        std::size_t out_len = 1 + rng() % 100;
+        std::size_t iter    = 1 + rng() % 50;
+        std::vector<std::vector<std::uint8_t>> pw(num), salt(num), dk(num);
+        std::vector<const std::uint8_t*>       pw_p(num), salt_p(num);
+        std::vector<std::size_t>               pw_len(num), salt_len(num);
+        std::vector<std::uint8_t*>             out(num);
+        for (std::size_t k = 0; k < num; k++)
+        {
+            // lengths around the HMAC block size, never an empty vector
+            pw[k].resize(1 + rng() % 100), salt[k].resize(1 + rng() % 40);
+            for (std::uint8_t& b : pw[k])
+            {
+                b = (std::uint8_t)rng();
+            }
+            for (std::uint8_t& b : salt[k])
+            {
+                b = (std::uint8_t)rng();
+            }
+            pw_p[k] = pw[k].data(), pw_len[k] = pw[k].size() - 1;
+            salt_p[k] = salt[k].data(), salt_len[k] = salt[k].size() - 1;
+            dk[k].resize(out_len);
+            out[k] = dk[k].data();
+        }
+        sm3::pbkdf2_hmac_sm3_many(out.data(), out_len, pw_p.data(),
+                                  pw_len.data(), salt_p.data(),
+                                  salt_len.data(), iter, num);
+        for (std::size_t k = 0; k < num; k++)
+        {
+            std::vector<std::uint8_t> expect(out_len);
+            hash_lib::pbkdf2_hmac<sm3::SM3>(expect.data(), out_len, pw_p[k],
+                                            pw_len[k], salt_p[k],
+                                            salt_len[k], iter);
+            check(dk[k] == expect, "pbkdf2_hmac_sm3_many",
+                  "against pbkdf2_hmac<SM3>");
+        }
+    }
+}
+
+void test_hkdf_known_answer()
+{
+    for (const HkdfVector& v : HKDF_VECTORS)
+    {
+        auto ikm    = from_hex(v.ikm);
+        auto salt   = from_hex(v.salt ? v.salt : "");
+        auto info   = from_hex(v.info);
+        auto expect = from_hex(v.okm);
+        info.reserve(1);
+
+        const std::uint8_t* salt_p = v.salt ? salt.data() : nullptr;
+        std::uint8_t        prk[32];
+        hash_lib::hkdf_extract<sm3::SM3>(prk, salt_p, salt.size(),
+                                         ikm.data(), ikm.size());
+        if (v.prk)
+        {
+            check(std::memcmp(prk, from_hex(v.prk).data(), 32) == 0,
+                  "hkdf_extract<SM3>", "known answer");
+        }
+        std::vector<std::uint8_t> okm(expect.size());
+        hash_lib::hkdf_expand<sm3::SM3>(okm.data(), okm.size(), prk, 32,
+                                        info.data(), info.size());
+        check(okm == expect, "hkdf_expand<SM3>", "known answer");
+
+        std::fill(okm.begin(), okm.end(), 0);
+        hash_lib::hkdf<sm3::SM3>(okm.data(), okm.size(), ikm.data(),
+                                 ikm.size(), salt_p, salt.size(),
+                                 info.data(), info.size());
+        check(okm == expect, "hkdf<SM3>", "known answer");
+    }
+}
+
+void test_errors()
+{
+    std::uint8_t              pw[4] = {1, 2, 3, 4}, dk[32];
+    std::vector<std::uint8_t> okm(255 * 32 + 1);
+    check(throws([&] {
+              hash_lib::pbkdf2_hmac<sm3::SM3>(dk, 32, pw, 4, pw, 4, 0);
+          }),
+          "pbkdf2_hmac<SM3>", "iteration count 0 rejected");
+    check(throws([&] { sm3::pbkdf2_hmac_sm3(dk, 32, pw, 4, pw, 4, 0); }),
+          "pbkdf2_hmac_sm3", "iteration count 0 rejected");
+    check(throws([&] {
+              hash_lib::hkdf_expand<sm3::SM3>(okm.data(), okm.size(), pw, 4,
+                                              pw, 4);
+          }),
+          "hkdf_expand<SM3>", "output too long rejected");
+    check(!throws([&] {
+              hash_lib::hkdf_expand<sm3::SM3>(okm.data(), okm.size() - 1, pw,
+                                              4, pw, 4);
+          }),
+          "hkdf_expand<SM3>", "longest output accepted");
+}
+
+} // namespace
+
+int main()
+{
+    test_pbkdf2_known_answer();
+    test_pbkdf2_many();
+    test_hkdf_known_answer();
+    test_errors();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all KDF checks passed\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * KeyScheduleCache / memory_utils::memequal checks.
+ *
+ * A hit returns the cached schedule, a full shard evicts its least recently
+ * used key, handles outlive eviction and clear(), keys differing in any
+ * byte are told apart, and concurrent lookups of a shared key set agree.
+ */
+#include <gmlib/block_cipher_mode/key_cache.h>
+#include <gmlib/memory_utils/memequal.h>
+#include <gmlib/sm4/sm4.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0xCAC);
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+/// @brief the schedule encrypts like a freshly keyed SM4
+bool same_cipher(const KeySchedule<sm4::SM4>& s, const std::uint8_t key[16])
+{
+    std::uint8_t pt[16] = {1, 2, 3}, ct1[16], ct2[16], back[16];
+    sm4::SM4     fresh(key, sm4::SM4::ENCRYPTION);
+    fresh.encrypt_block(ct1, pt);
+    s.enc.encrypt_block(ct2, pt);
+    s.dec.decrypt_block(back, ct2);
+    return std::memcmp(ct1, ct2, 16) == 0 && std::memcmp(back, pt, 16) == 0;
+}
+
+void test_memequal()
+{
+    std::uint8_t a[33], b[33];
+    for (int round = 0; round < 1000; round++)
+    {
+        std::size_t n = rng() % 34;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            a[i] = b[i] = (std::uint8_t)rng();
+        }
+        check(memory_utils::memequal(a, b, n), "memequal", "equal");
+        if (n != 0)
+        {
+            b[rng() % n] ^= (std::uint8_t)(1 << (rng() % 8));
+            check(!memory_utils::memequal(a, b, n), "memequal", "differ");
+        }
+    }
+}
+
+void test_hit_and_eviction()
+{
+    // one shard of 4 ways, so the LRU order is easy to follow
+    KeyScheduleCache<sm4::SM4, 4, 1> cache;
+
+    std::uint8_t keys[6][16];
+    for (auto& key : keys)
+    {
+        for (std::uint8_t& b : key)
+        {
+            b = (std::uint8_t)rng();
+        }
+    }
+    // keys[5] differs from keys[0] in the last byte only
+    std::memcpy(keys[5], keys[0], 16);
+    keys[5][15] ^= 1;
+
+    auto h0 = cache.get(keys[0]);
+    check(same_cipher(*h0, keys[0]), "cache", "schedule");
+    check(cache.get(keys[0]) == h0, "cache", "hit");
+    auto h5 = cache.get(keys[5]);
+    check(h5 != h0 && same_cipher(*h5, keys[5]), "cache", "near key");
+
+    auto h1 = cache.get(keys[1]);
+    cache.get(keys[2]);
+    cache.get(keys[0]); // keys[5] is now the least recently used
+    cache.get(keys[3]); // evicts keys[5]
+    check(cache.get(keys[0]) == h0 && cache.get(keys[1]) == h1, "cache",
+          "recently used kept");
+    check(same_cipher(*h5, keys[5]), "cache", "handle outlives eviction");
+    check(cache.get(keys[5]) != h5, "cache", "evicted key re-computed");
+
+    cache.clear();
+    check(same_cipher(*h1, keys[1]), "cache", "handle outlives clear");
+    check(cache.get(keys[1]) != h1, "cache", "cleared key re-computed");
+}
+
+void test_threads()
+{
+    KeyScheduleCache<sm4::SM4, 64, 8> cache;
+
+    std::vector<std::vector<std::uint8_t>> keys(100);
+    for (auto& key : keys)
+    {
+        key.resize(16);
+        for (std::uint8_t& b : key)
+        {
+            b = (std::uint8_t)rng();
+        }
+    }
+    std::vector<int>         bad(4, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t] {
+            std::mt19937 local(t);
+            for (int i = 0; i < 2000; i++)
+            {
+                const auto& key = keys[local() % keys.size()];
+                bad[t] += !same_cipher(*cache.get(key.data()), key.data());
+            }
+        });
+    }
+    for (auto& th : threads)
+    {
+        th.join();
+    }
+    for (int n : bad)
+    {
+        check(n == 0, "cache", "concurrent lookups");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_memequal();
+    test_hit_and_eviction();
+    test_threads();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all key cache checks passed\n");
+    return 0;
+}
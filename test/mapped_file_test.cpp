@@ -0,0 +1,259 @@
+/**
+ * MappedFile / sm3_file / sm4_ctr_file checks.
+ *
+ * OpenSSL known answers (dgst -sm3 over several mapping chunks, enc
+ * -sm4-ctr across a counter wrap), multi-chunk files on several threads
+ * against the streaming classes, and the output file handling: an
+ * existing output is replaced only on success, the input cannot be the
+ * output, and no temporary file is left behind either way.
+ */
+#include <gmlib/memory_utils/mapped_file.h>
+#include <gmlib/sm3/sm3_file.h>
+#include <gmlib/sm4/sm4_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0xF11E);
+
+const fs::path DIR = "mapped_file_test.dir";
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+std::string path_of(const char* name)
+{
+    return (DIR / name).string();
+}
+
+void write_file(const char* name, const std::vector<std::uint8_t>& data)
+{
+    std::ofstream f(path_of(name), std::ios::binary | std::ios::trunc);
+    f.write((const char*)data.data(), (std::streamsize)data.size());
+}
+
+std::vector<std::uint8_t> read_file(const char* name)
+{
+    std::ifstream f(path_of(name), std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(f),
+                                     std::istreambuf_iterator<char>());
+}
+
+std::vector<std::uint8_t> counting(std::size_t len)
+{
+    std::vector<std::uint8_t> out(len);
+    for (std::size_t i = 0; i < len; i++)
+    {
+        out[i] = (std::uint8_t)i;
+    }
+    return out;
+}
+
+/// @brief only the expected files are in DIR, no temporary one
+bool dir_holds(std::size_t file_num)
+{
+    std::size_t n = 0;
+    for (const auto& entry : fs::directory_iterator(DIR))
+    {
+        (void)entry, n++;
+    }
+    return n == file_num;
+}
+
+std::vector<std::uint8_t> ctr_reference(const std::uint8_t*              key,
+                                        const std::uint8_t*              iv,
+                                        const std::vector<std::uint8_t>& in)
+{
+    std::vector<std::uint8_t> out(in.size() + 16);
+    std::size_t               outl, final_len;
+    sm4::SM4CtrEncryptor      ctr(key, iv);
+    ctr.update(out.data(), &outl, in.data(), in.size());
+    ctr.do_final(out.data() + outl, &final_len);
+    out.resize(outl + final_len);
+    return out;
+}
+
+void test_sm3_file()
+{
+    // openssl dgst -sm3, 3000000 bytes 0x00, 0x01 ..., two chunks and more
+    write_file("in", counting(3000000));
+    std::uint8_t digest[32];
+    sm3::sm3_file(digest, path_of("in").c_str());
+    check(std::memcmp(digest,
+                      from_hex("64944526999a1942f2060983a4c8498cbdbb98bcc24995"
+                               "efc5d68654cdfb416a")
+                          .data(),
+                      32) == 0,
+          "sm3_file", "known answer");
+
+    write_file("in", {});
+    sm3::sm3_file(digest, path_of("in").c_str());
+    check(std::memcmp(digest,
+                      from_hex("1ab21d8355cfa17f8e61194831e81a8f22bec8c728fefb"
+                               "747ed035eb5082aa2b")
+                          .data(),
+                      32) == 0,
+          "sm3_file", "empty file");
+}
+
+void test_sm4_ctr_file()
+{
+    auto key = from_hex("0123456789abcdeffedcba9876543210");
+    auto iv  = from_hex("fffffffffffffffffffffffffffffffe");
+
+    // openssl enc -sm4-ctr, the counter wraps after two blocks
+    write_file("in", counting(40));
+    sm4::sm4_ctr_file(path_of("in").c_str(), path_of("out").c_str(),
+                      key.data(), iv.data());
+    check(read_file("out") == from_hex("661316b2cd2d2589977512f08f82f6577800bd"
+                                       "6d1d6672f09ee25fd541877eef0656d6482de4"
+                                       "04eb"),
+          "sm4_ctr_file", "known answer");
+
+    // several chunks on several threads, over an existing longer output
+    for (std::size_t thread_num : {1, 3})
+    {
+        std::vector<std::uint8_t> in(5 * (1 << 20) + 17);
+        for (std::uint8_t& b : in)
+        {
+            b = (std::uint8_t)rng();
+        }
+        write_file("in", in);
+        write_file("out", std::vector<std::uint8_t>(in.size() + 1000, 0xEE));
+        sm4::SM4 cipher(key.data(), sm4::SM4::ENCRYPTION);
+        sm4::sm4_ctr_file(path_of("in").c_str(), path_of("out").c_str(),
+                          cipher, iv.data(), thread_num);
+        check(read_file("out") == ctr_reference(key.data(), iv.data(), in),
+              "sm4_ctr_file", "against SM4CtrEncryptor");
+    }
+    check(dir_holds(2), "sm4_ctr_file", "no temporary file left");
+
+    write_file("in", {});
+    sm4::sm4_ctr_file(path_of("in").c_str(), path_of("out").c_str(),
+                      key.data(), iv.data());
+    check(fs::exists(path_of("out")) && read_file("out").empty(),
+          "sm4_ctr_file", "empty file");
+}
+
+void test_output_handling()
+{
+    auto key = from_hex("0123456789abcdeffedcba9876543210");
+    auto iv  = from_hex("000102030405060708090a0b0c0d0e0f");
+    auto in  = counting(1000);
+    auto old = std::vector<std::uint8_t>(77, 0x5A);
+    write_file("in", in);
+    write_file("out", old);
+
+    // the input as output, by the same and by another path
+    for (const std::string& out : {path_of("in"), (DIR / "." / "in").string()})
+    {
+        bool thrown = false;
+        try
+        {
+            sm4::sm4_ctr_file(path_of("in").c_str(), out.c_str(), key.data(),
+                              iv.data());
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown && read_file("in") == in, "sm4_ctr_file",
+              "input as output rejected");
+    }
+
+    // a missing input leaves the existing output untouched
+    bool thrown = false;
+    try
+    {
+        sm4::sm4_ctr_file(path_of("missing").c_str(), path_of("out").c_str(),
+                          key.data(), iv.data());
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    check(thrown && read_file("out") == old, "sm4_ctr_file",
+          "output kept on failure");
+
+    // an uncommitted mapping leaves the target alone and no file behind
+    {
+        memory_utils::MappedFile out(path_of("out").c_str(), 4096);
+        std::memset(out.writable_data(), 0x11, 4096);
+        check(dir_holds(3), "MappedFile", "written to a temporary file");
+    }
+    check(read_file("out") == old && dir_holds(2), "MappedFile",
+          "uncommitted file removed");
+    {
+        memory_utils::MappedFile out(path_of("new").c_str(), 100);
+        std::memset(out.writable_data(), 0x22, 100);
+        out.commit();
+        check(out.data() == nullptr, "MappedFile", "unmapped on commit");
+    }
+    check(read_file("new") == std::vector<std::uint8_t>(100, 0x22) &&
+              dir_holds(3),
+          "MappedFile", "committed file");
+
+    thrown = false;
+    try
+    {
+        memory_utils::MappedFile f(path_of("missing").c_str());
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    check(thrown, "MappedFile", "missing file rejected");
+}
+
+} // namespace
+
+int main()
+{
+    fs::remove_all(DIR);
+    fs::create_directory(DIR);
+    test_sm3_file();
+    test_sm4_ctr_file();
+    fs::remove_all(DIR);
+    fs::create_directory(DIR);
+    test_output_handling();
+    fs::remove_all(DIR);
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all mapped file checks passed\n");
+    return 0;
+}
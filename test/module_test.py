@@ -0,0 +1,128 @@
+"""
+In-place SM4 and file entry points of the CryptUtils module.
+
+SM4EncryptInPlace / SM4DecryptInPlace take a bytearray and mutate it: the
+ciphertext must equal SM4Encrypt (Base64 decoded), and decryption must give
+back the original bytes and length. Keys are Base64 strings of exactly
+16 bytes or SM4Key handles. SM3File / SM4CtrFile are checked against
+OpenSSL (dgst -sm3, enc -sm4-ctr).
+"""
+import base64
+import os
+import tempfile
+
+import CryptUtils
+
+KEY = base64.b64encode(bytes(range(16))).decode()
+
+
+def test_encrypt_in_place():
+    for n in (0, 1, 15, 16, 17, 100, 4096):
+        text = os.urandom(n).hex()[:n]
+        buf = bytearray(text.encode())
+        CryptUtils.SM4EncryptInPlace(buf, KEY)
+        assert len(buf) == (n // 16 + 1) * 16
+        assert base64.b64encode(bytes(buf)).decode() == \
+            CryptUtils.SM4Encrypt(text, KEY)
+
+
+def test_decrypt_in_place():
+    for n in (0, 1, 15, 16, 17, 100, 4096):
+        data = os.urandom(n)
+        buf = bytearray(data)
+        CryptUtils.SM4EncryptInPlace(buf, KEY)
+        CryptUtils.SM4DecryptInPlace(buf, KEY)
+        assert buf == data
+
+
+def test_key_handle():
+    handle = CryptUtils.SM4Key(KEY)
+    buf = bytearray(b"in place with a key handle")
+    CryptUtils.SM4EncryptInPlace(buf, handle)
+    assert base64.b64encode(bytes(buf)).decode() == \
+        CryptUtils.SM4Encrypt("in place with a key handle", KEY)
+    CryptUtils.SM4DecryptInPlace(buf, KEY)
+    assert buf == b"in place with a key handle"
+
+
+def test_errors():
+    # only a bytearray can be mutated
+    for bad in (b"bytes", "str", memoryview(bytearray(16))):
+        try:
+            CryptUtils.SM4EncryptInPlace(bad, KEY)
+        except TypeError:
+            pass
+        else:
+            raise AssertionError("no TypeError for %r" % type(bad))
+
+    # Base64 keys that do not decode to 16 bytes
+    for bad in ("", "AAAA", KEY[:-4], KEY + "AAAA", KEY[:-1],
+                base64.b64encode(bytes(15)).decode(),
+                base64.b64encode(bytes(17)).decode()):
+        for call in (lambda: CryptUtils.SM4Key(bad),
+                     lambda: CryptUtils.SM4Encrypt("text", bad),
+                     lambda: CryptUtils.SM4EncryptInPlace(bytearray(1), bad)):
+            try:
+                call()
+            except ValueError:
+                pass
+            else:
+                raise AssertionError("no ValueError for key %r" % bad)
+
+    # bad padding or length, the buffer is left as it was
+    cipher = bytearray(os.urandom(40))
+    CryptUtils.SM4EncryptInPlace(cipher, KEY)
+    for bad in (bytearray(16), cipher[:-1], cipher[:-16] + bytearray(16),
+                bytearray()):
+        before = bytes(bad)
+        try:
+            CryptUtils.SM4DecryptInPlace(bad, KEY)
+        except ValueError as e:
+            assert str(e) == "Decryption failed"
+        else:
+            raise AssertionError("no ValueError for %r" % before)
+        assert bytes(bad) == before
+
+
+def test_files():
+    counting = bytes(i & 0xff for i in range(3000000))
+    ctr_key = base64.b64encode(
+        bytes.fromhex("0123456789abcdeffedcba9876543210")).decode()
+    with tempfile.TemporaryDirectory() as tmp:
+        src = os.path.join(tmp, "in")
+        dst = os.path.join(tmp, "out")
+        with open(src, "wb") as f:
+            f.write(counting)
+        assert CryptUtils.SM3File(src).hex() == \
+            "64944526999a1942f2060983a4c8498cbdbb98bcc24995efc5d68654cdfb416a"
+
+        # the counter wraps after two blocks
+        with open(src, "wb") as f:
+            f.write(counting[:40])
+        iv = bytes.fromhex("fffffffffffffffffffffffffffffffe")
+        CryptUtils.SM4CtrFile(src, dst, CryptUtils.SM4Key(ctr_key), iv)
+        with open(dst, "rb") as f:
+            assert f.read().hex() == \
+                "661316b2cd2d2589977512f08f82f6577800bd6d1d6672f0" \
+                "9ee25fd541877eef0656d6482de404eb"
+
+        # failures raise OSError and leave the files as they were
+        for bad in ((src, src), (os.path.join(tmp, "missing"), dst)):
+            try:
+                CryptUtils.SM4CtrFile(bad[0], bad[1], ctr_key, iv)
+            except OSError:
+                pass
+            else:
+                raise AssertionError("no OSError for %r" % (bad,))
+        with open(src, "rb") as f:
+            assert f.read() == counting[:40]
+        assert sorted(os.listdir(tmp)) == ["in", "out"]
+
+
+if __name__ == "__main__":
+    test_encrypt_in_place()
+    test_decrypt_in_place()
+    test_key_handle()
+    test_errors()
+    test_files()
+    print("all module checks passed")
@@ -0,0 +1,224 @@
+/**
+ * SM2 comb table checks (internal::sm2_ec_j_mul_comb,
+ * SM2PublicKey::precompute).
+ *
+ * [k]P through the comb table against sm2_ec_j_mul_a for edge and random
+ * scalars and points, then keys with a table: OpenSSL signatures verified,
+ * ciphertexts decrypted by the private key, copies sharing the table and
+ * a key set again dropping it.
+ */
+#include <gmlib/rng/std_rng.h>
+#include <gmlib/sm2/internal/sm2_comb.h>
+#include <gmlib/sm2/sm2.h>
+#include <gmlib/sm3/sm3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sm2::internal;
+using PrivateKey = sm2::SM2PrivateKey<sm3::SM3>;
+using PublicKey  = sm2::SM2PublicKey<sm3::SM3>;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0xC0B);
+
+// openssl genpkey -algorithm SM2
+const char* PRIV =
+    "e01df68b0a100e86f9528bbc35abbf0f9162357c4f4540c428d1c8d03331cbe2";
+const char* PUB_X =
+    "a071e14993205d954662e14ab8d765926ed6de6497aab7c285f7ab04ea6c4e07";
+const char* PUB_Y =
+    "1a1985e9042a32abf1b09270ba4bcdaac4b6e533960a7a6726850bd9f956ae81";
+
+const char* MSG = "message digest";
+
+// openssl pkeyutl -sign -rawin -digest sm3 -pkeyopt distid:<id>
+const char* SIG_DEFAULT_ID =
+    "af24c16f63bc55face9d4d06f3e2d06e99fbaea19d05530b7cdacef0bf15b22b"
+    "271c358fda59a972ab2060ef4cf76bc74898a71672051e913b7cd1847fdeddf7";
+const char* SIG_ALICE =
+    "1c02243a4377edf76b73eaaf56e448d0e27860d6b1cd24b59018c98e51420695"
+    "afc07dd250a8684808a5f04bafb00620523ebbe081effb580650c986b38ead42";
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+/// @brief both points equal, infinity included
+bool same_point(const sm2_ec_j P, const sm2_ec_j Q)
+{
+    if (sm2_ec_j_is_inf(P) || sm2_ec_j_is_inf(Q))
+    {
+        return sm2_ec_j_is_inf(P) && sm2_ec_j_is_inf(Q);
+    }
+    sm2_ec_a     a, b;
+    std::uint8_t x[64], y[64];
+    sm2_ec_j_to_a(a, P), sm2_ec_j_to_a(b, Q);
+    sm2_ec_a_to_bytes04(x, a), sm2_ec_a_to_bytes04(y, b);
+    return std::memcmp(x, y, 64) == 0;
+}
+
+void test_mul_comb()
+{
+    // 0, 1, 2, n - 1, n, 2^256 - 1, one bit per tooth boundary
+    std::vector<std::vector<std::uint8_t>> ks = {
+        std::vector<std::uint8_t>(32, 0),
+        from_hex("00000000000000000000000000000000000000000000000000000000"
+                 "00000001"),
+        from_hex("00000000000000000000000000000000000000000000000000000000"
+                 "00000002"),
+        from_hex("fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf409"
+                 "39d54122"),
+        from_hex("fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf409"
+                 "39d54123"),
+        std::vector<std::uint8_t>(32, 0xff),
+    };
+    for (int i = 0; i < SM2_COMB_TEETH; i++)
+    {
+        for (int delta : {-1, 0, 1})
+        {
+            int bit = i * SM2_COMB_SPACING + delta;
+            if (bit >= 0 && bit < 256)
+            {
+                std::vector<std::uint8_t> k(32, 0);
+                k[31 - bit / 8] = (std::uint8_t)(1 << (bit % 8));
+                ks.push_back(k);
+            }
+        }
+    }
+    for (int round = 0; round < 40; round++)
+    {
+        std::vector<std::uint8_t> k(32);
+        for (std::uint8_t& b : k)
+        {
+            b = (std::uint8_t)rng();
+        }
+        ks.push_back(k);
+    }
+
+    for (int p = 0; p < 4; p++)
+    {
+        // P = [random]G
+        std::uint8_t scalar[32];
+        for (std::uint8_t& b : scalar)
+        {
+            b = (std::uint8_t)rng();
+        }
+        scalar[0] &= 0x7f;
+        sm2_ec_j PJ;
+        sm2_ec_a P;
+        sm2_ec_j_mul_g(PJ, scalar);
+        sm2_ec_j_to_a(P, PJ);
+        auto tb = std::make_unique<sm2_comb_table>();
+        sm2_comb_table_init(tb.get(), P);
+
+        for (const auto& k : ks)
+        {
+            sm2_ec_j R1, R2;
+            sm2_ec_j_mul_comb(R1, k.data(), tb.get());
+            sm2_ec_j_mul_a(R2, k.data(), P);
+            check(same_point(R1, R2), "sm2_ec_j_mul_comb",
+                  "against sm2_ec_j_mul_a");
+        }
+    }
+}
+
+void test_precomputed_key()
+{
+    rng::StdRng  srng;
+    auto         x    = from_hex(PUB_X), y = from_hex(PUB_Y);
+    auto         d    = from_hex(PRIV);
+    auto         sig1 = from_hex(SIG_DEFAULT_ID), sig2 = from_hex(SIG_ALICE);
+    const auto*  msg  = (const std::uint8_t*)MSG;
+    std::size_t  len  = std::strlen(MSG);
+    const auto*  id   = (const std::uint8_t*)"ALICE123@YAHOO.COM";
+    PublicKey    pub(x.data(), y.data());
+    PrivateKey   priv(d.data());
+    std::uint8_t sig[64];
+
+    pub.precompute();
+    check(pub.verify(sig1.data(), msg, len), "precompute", "verify");
+    check(pub.verify(sig2.data(), msg, len, id, 18), "precompute",
+          "verify with ID");
+    sig1[5] ^= 0x20;
+    check(!pub.verify(sig1.data(), msg, len), "precompute",
+          "bad signature rejected");
+    for (int round = 0; round < 10; round++)
+    {
+        priv.sign(sig, msg, len, srng);
+        check(pub.verify(sig, msg, len), "precompute", "verify own");
+    }
+
+    // copies share the table
+    PublicKey copy(pub);
+    check(copy.verify(sig2.data(), msg, len, id, 18), "precompute",
+          "copied key");
+
+    for (std::size_t p_len : {1, 31, 32, 33, 200})
+    {
+        std::vector<std::uint8_t> pt(p_len), back(p_len);
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::vector<std::uint8_t> ct(PublicKey::ciphertext_len(pt.data(),
+                                                               p_len));
+        std::size_t c_len, back_len;
+        copy.encrypt(ct.data(), &c_len, pt.data(), p_len, srng);
+        priv.decrypt(back.data(), &back_len, ct.data(), c_len);
+        check(back_len == p_len && back == pt, "precompute",
+              "encrypt then decrypt");
+    }
+
+    // a key set again drops the table of the old point
+    PrivateKey   other(srng);
+    std::uint8_t ox[32], oy[32];
+    other.fetch_pub().get_pub(ox, oy);
+    pub.set_pub(ox, oy);
+    other.sign(sig, msg, len, srng);
+    check(pub.verify(sig, msg, len), "set_pub", "new key verified");
+    check(!pub.verify(sig2.data(), msg, len, id, 18), "set_pub",
+          "table of the old key dropped");
+    check(copy.verify(sig2.data(), msg, len, id, 18), "precompute",
+          "copy keeps its table");
+}
+
+} // namespace
+
+int main()
+{
+    test_mul_comb();
+    test_precomputed_key();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all SM2 comb checks passed\n");
+    return 0;
+}
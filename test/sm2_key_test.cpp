@@ -0,0 +1,237 @@
+/**
+ * SM2PrivateKey / SM2PublicKey checks, for the cached Z and private-key
+ * values.
+ *
+ * OpenSSL SM2-SM3 signatures verified under the default ID and under more
+ * distinct IDs than the Z cache holds, revisited in a new order; our own
+ * signatures under the same IDs; keys set again, copied, an invalid
+ * private key rejected without touching the current one, and no private
+ * key bytes left in a destroyed key.
+ */
+#include <gmlib/rng/std_rng.h>
+#include <gmlib/sm2/sm2.h>
+#include <gmlib/sm3/sm3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using PrivateKey = sm2::SM2PrivateKey<sm3::SM3>;
+using PublicKey  = sm2::SM2PublicKey<sm3::SM3>;
+
+namespace {
+
+int fail_num = 0;
+
+// openssl genpkey -algorithm SM2
+const char* PRIV =
+    "e01df68b0a100e86f9528bbc35abbf0f9162357c4f4540c428d1c8d03331cbe2";
+const char* PUB_X =
+    "a071e14993205d954662e14ab8d765926ed6de6497aab7c285f7ab04ea6c4e07";
+const char* PUB_Y =
+    "1a1985e9042a32abf1b09270ba4bcdaac4b6e533960a7a6726850bd9f956ae81";
+
+const char* MSG = "message digest";
+
+struct SigVector
+{
+    const char* id;
+    const char* sig_rs;
+};
+
+// openssl pkeyutl -sign -rawin -digest sm3 -pkeyopt distid:<id>
+const SigVector SIG_VECTORS[] = {
+    {"1234567812345678",
+     "af24c16f63bc55face9d4d06f3e2d06e99fbaea19d05530b7cdacef0bf15b22b"
+     "271c358fda59a972ab2060ef4cf76bc74898a71672051e913b7cd1847fdeddf7"},
+    {"ALICE123@YAHOO.COM",
+     "1c02243a4377edf76b73eaaf56e448d0e27860d6b1cd24b59018c98e51420695"
+     "afc07dd250a8684808a5f04bafb00620523ebbe081effb580650c986b38ead42"},
+    {"a", "eb7636bbf6a8ebe11e1a841925e13508359e95724d39986f0084243b2dbd9d49"
+          "e04aa17c35c3ab12af726b61d6bba79d5d508cb7349b12e5d60b008bc78c8446"},
+    {"b", "48984b9f475a8de4d9e39f59b458d94e4e9dd49fbdd5a57e4b32a7602193a4fa"
+          "5ed433af4d43d62f19cc775482396c99391242fd8387ef7c0fc6cd8bd3873454"},
+    {"c", "bacfd361f87fd8fae8f62ecac20ec931eac1ba530cf81170d2e6b00678b0b6ff"
+          "be40850a310cadbd511454f4325a5859b1432e40cd49219bb199eafb067a8943"},
+    {"d", "55bd941bb82e6d9baf778ca612db5321bd2551453aea55823fac759647182e92"
+          "05e7269fa8aba0c3e34a56d60119031e2ab7c73f376b7198edc50da803146103"},
+    {"e", "039166164ff56b09d773caeddfed86e85083bedc5d07e5cac10eb022dd920af0"
+          "664d3265df81197ca82fce00aa360dc38e11e34e681bf74206e2d4013373d6c9"},
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+bool verify(const PublicKey& pub, const std::uint8_t* sig, const char* id)
+{
+    return pub.verify(sig, (const std::uint8_t*)MSG, std::strlen(MSG),
+                      (const std::uint8_t*)id, std::strlen(id));
+}
+
+/// @brief every OpenSSL signature, in the given order of SIG_VECTORS
+void check_vectors(const PublicKey& pub, const int* order, const char* what)
+{
+    for (int k = 0; k < 7; k++)
+    {
+        const SigVector& v   = SIG_VECTORS[order[k]];
+        auto             sig = from_hex(v.sig_rs);
+        check(verify(pub, sig.data(), v.id), "verify", what);
+        // the signature of another ID must fail
+        const char* other = SIG_VECTORS[(order[k] + 1) % 7].id;
+        check(!verify(pub, sig.data(), other), "verify", "wrong ID rejected");
+        sig[63] ^= 1;
+        check(!verify(pub, sig.data(), v.id), "verify", "bad sig rejected");
+    }
+}
+
+void test_known_answer()
+{
+    static const int FORWARD[7]  = {0, 1, 2, 3, 4, 5, 6};
+    static const int BACKWARD[7] = {6, 5, 4, 3, 2, 1, 0};
+    static const int MIXED[7]    = {3, 1, 6, 0, 2, 5, 4};
+
+    auto      x = from_hex(PUB_X), y = from_hex(PUB_Y);
+    PublicKey pub(x.data(), y.data());
+    // more IDs than the Z cache holds, evicted and computed again
+    check_vectors(pub, FORWARD, "OpenSSL signature");
+    check_vectors(pub, BACKWARD, "OpenSSL signature, again");
+    check_vectors(pub, MIXED, "OpenSSL signature, mixed order");
+
+    auto       d = from_hex(PRIV);
+    PrivateKey priv(d.data());
+    check_vectors(priv.fetch_pub(), MIXED, "derived public key");
+    std::uint8_t gx[32], gy[32];
+    priv.fetch_pub().get_pub(gx, gy);
+    check(std::memcmp(gx, x.data(), 32) == 0 &&
+              std::memcmp(gy, y.data(), 32) == 0,
+          "set_priv", "public key");
+}
+
+void test_sign()
+{
+    rng::StdRng  rng;
+    auto         d = from_hex(PRIV);
+    PrivateKey   priv(d.data());
+    std::uint8_t sig[64];
+    for (int round = 0; round < 3; round++)
+    {
+        for (const SigVector& v : SIG_VECTORS)
+        {
+            priv.sign(sig, (const std::uint8_t*)MSG, std::strlen(MSG), rng,
+                      (const std::uint8_t*)v.id, std::strlen(v.id));
+            check(verify(priv.fetch_pub(), sig, v.id), "sign", "own ID");
+            check(!verify(priv.fetch_pub(), sig, "x"), "sign", "other ID");
+        }
+    }
+
+    // a generated key, then set again, then copied
+    PrivateKey gen(rng);
+    priv.sign(sig, (const std::uint8_t*)MSG, std::strlen(MSG), rng);
+    check(!gen.verify(sig, (const std::uint8_t*)MSG, std::strlen(MSG)),
+          "gen_priv", "other key rejected");
+    gen.set_priv(d.data());
+    gen.sign(sig, (const std::uint8_t*)MSG, std::strlen(MSG), rng);
+    check(priv.verify(sig, (const std::uint8_t*)MSG, std::strlen(MSG)),
+          "set_priv", "key replaced");
+
+    PrivateKey copy(gen);
+    copy.sign(sig, (const std::uint8_t*)MSG, std::strlen(MSG), rng,
+              (const std::uint8_t*)"a", 1);
+    check(verify(priv.fetch_pub(), sig, "a"), "copy", "sign");
+    PrivateKey assigned;
+    assigned = copy;
+    assigned.sign(sig, (const std::uint8_t*)MSG, std::strlen(MSG), rng);
+    check(priv.verify(sig, (const std::uint8_t*)MSG, std::strlen(MSG)),
+          "copy", "assign");
+}
+
+void test_invalid_priv()
+{
+    rng::StdRng rng;
+    auto        d = from_hex(PRIV);
+    PrivateKey  priv(d.data());
+    // 0, n - 1, n
+    const char* BAD[] = {
+        "0000000000000000000000000000000000000000000000000000000000000000",
+        "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54122",
+        "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54123",
+    };
+    for (const char* hex : BAD)
+    {
+        bool thrown = false;
+        try
+        {
+            priv.set_priv(from_hex(hex).data());
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "set_priv", "invalid key rejected");
+        std::uint8_t got[32], sig[64];
+        priv.get_priv(got);
+        priv.sign(sig, (const std::uint8_t*)MSG, std::strlen(MSG), rng);
+        check(std::memcmp(got, d.data(), 32) == 0 &&
+                  verify(priv.fetch_pub(), sig, "1234567812345678"),
+              "set_priv", "key kept after rejection");
+    }
+}
+
+void test_destroy()
+{
+    auto d = from_hex(PRIV);
+    alignas(PrivateKey) std::uint8_t storage[sizeof(PrivateKey)];
+    PrivateKey* priv = new (storage) PrivateKey(d.data());
+    bool        found = false;
+    for (std::size_t i = 0; i + 32 <= sizeof(storage); i++)
+    {
+        found = found || std::memcmp(storage + i, d.data(), 32) == 0;
+    }
+    check(found, "~SM2PrivateKey", "key stored");
+    priv->~PrivateKey();
+    found = false;
+    for (std::size_t i = 0; i + 32 <= sizeof(storage); i++)
+    {
+        found = found || std::memcmp(storage + i, d.data(), 32) == 0;
+    }
+    check(!found, "~SM2PrivateKey", "key cleared");
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_sign();
+    test_invalid_priv();
+    test_destroy();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all SM2 key checks passed\n");
+    return 0;
+}
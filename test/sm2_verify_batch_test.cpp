@@ -0,0 +1,217 @@
+/**
+ * SM2PublicKey::verify_batch checks.
+ *
+ * Batches over several keys, signatures of a key scattered through the
+ * batch: an OpenSSL key with its signatures, generated keys, one of them
+ * with enough signatures for a temporary comb table and one with its own
+ * table. A random part of every batch is broken (bit flips, r or s out of
+ * range, another message or another key) and the result array is checked
+ * signature by signature, against the expected result and verify.
+ */
+#include <gmlib/rng/std_rng.h>
+#include <gmlib/sm2/sm2.h>
+#include <gmlib/sm3/sm3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using PrivateKey = sm2::SM2PrivateKey<sm3::SM3>;
+using PublicKey  = sm2::SM2PublicKey<sm3::SM3>;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0xBA7C);
+
+const char* N =
+    "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54123";
+
+// openssl genpkey -algorithm SM2
+const char* PUB_X =
+    "a071e14993205d954662e14ab8d765926ed6de6497aab7c285f7ab04ea6c4e07";
+const char* PUB_Y =
+    "1a1985e9042a32abf1b09270ba4bcdaac4b6e533960a7a6726850bd9f956ae81";
+
+const char* MSG = "message digest";
+
+// openssl pkeyutl -sign -rawin -digest sm3 -pkeyopt distid:<id>
+const char* SIG_DEFAULT_ID =
+    "af24c16f63bc55face9d4d06f3e2d06e99fbaea19d05530b7cdacef0bf15b22b"
+    "271c358fda59a972ab2060ef4cf76bc74898a71672051e913b7cd1847fdeddf7";
+const char* SIG_ALICE =
+    "1c02243a4377edf76b73eaaf56e448d0e27860d6b1cd24b59018c98e51420695"
+    "afc07dd250a8684808a5f04bafb00620523ebbe081effb580650c986b38ead42";
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+struct Entry
+{
+    const PublicKey*          pub;
+    std::vector<std::uint8_t> sig;
+    std::vector<std::uint8_t> msg;
+    bool                      valid;
+};
+
+/// @brief verify_batch over the entries, then every result checked
+void check_batch(std::vector<Entry>& batch,
+                 const char*         id,
+                 const char*         what)
+{
+    std::size_t                      num = batch.size();
+    std::vector<const PublicKey*>    pub(num);
+    std::vector<const std::uint8_t*> sig(num), msg(num);
+    std::vector<std::size_t>         msg_len(num);
+    std::unique_ptr<bool[]>          result(new bool[num + 1]);
+    bool                             all_valid = true;
+    for (std::size_t i = 0; i < num; i++)
+    {
+        pub[i] = batch[i].pub, sig[i] = batch[i].sig.data();
+        msg[i] = batch[i].msg.data(), msg_len[i] = batch[i].msg.size();
+        all_valid = all_valid && batch[i].valid;
+    }
+    bool ok = PublicKey::verify_batch(
+        result.get(), pub.data(), sig.data(), msg.data(), msg_len.data(),
+        num, (const std::uint8_t*)id, std::strlen(id));
+    check(ok == all_valid, "verify_batch", what);
+    for (std::size_t i = 0; i < num; i++)
+    {
+        check(result[i] == batch[i].valid, "verify_batch", what);
+        check(result[i] == pub[i]->verify(sig[i], msg[i], msg_len[i],
+                                          (const std::uint8_t*)id,
+                                          std::strlen(id)),
+              "verify_batch", "same as verify");
+    }
+}
+
+/// @brief breaks the entry in one of several ways
+void corrupt(Entry& e, const PublicKey* other)
+{
+    int way = (int)(rng() % 5);
+    if (way == 0)
+    {
+        e.sig[rng() % 64] ^= (std::uint8_t)(1 << (rng() % 8));
+    }
+    else if (way == 1)
+    {
+        std::memset(e.sig.data(), 0, 32); // r = 0
+    }
+    else if (way == 2)
+    {
+        std::memcpy(e.sig.data() + 32, from_hex(N).data(), 32); // s = n
+    }
+    else if (way == 3)
+    {
+        e.msg.push_back(0);
+    }
+    else
+    {
+        e.pub = other;
+    }
+    e.valid = false;
+}
+
+void test_known_answer()
+{
+    auto      x = from_hex(PUB_X), y = from_hex(PUB_Y);
+    PublicKey pub(x.data(), y.data());
+    auto      msg = std::vector<std::uint8_t>(MSG, MSG + std::strlen(MSG));
+
+    std::vector<Entry> batch = {
+        {&pub, from_hex(SIG_DEFAULT_ID), msg, true},
+        {&pub, from_hex(SIG_ALICE), msg, false}, // signed under another ID
+        {&pub, from_hex(SIG_DEFAULT_ID), msg, true},
+    };
+    check_batch(batch, "1234567812345678", "OpenSSL signatures");
+    batch[0].valid = batch[2].valid = false, batch[1].valid = true;
+    check_batch(batch, "ALICE123@YAHOO.COM", "OpenSSL signatures with ID");
+
+    std::vector<Entry> empty;
+    check_batch(empty, "1234567812345678", "empty batch");
+}
+
+void test_mixed()
+{
+    rng::StdRng             srng;
+    std::vector<PrivateKey> priv;
+    for (int k = 0; k < 4; k++)
+    {
+        priv.emplace_back(srng);
+    }
+    // key 0 gets a comb table, key 1 enough signatures for a temporary one
+    std::vector<PublicKey> pub;
+    for (const PrivateKey& k : priv)
+    {
+        pub.push_back(k.fetch_pub());
+    }
+    pub[0].precompute();
+
+    for (int round = 0; round < 6; round++)
+    {
+        std::vector<Entry> batch;
+        const char*        id = (round % 2) ? "ALICE123@YAHOO.COM"
+                                            : "1234567812345678";
+        std::size_t        num = 40 + rng() % 20;
+        for (std::size_t i = 0; i < num; i++)
+        {
+            // key 1 for about half of the signatures
+            std::size_t k = (rng() % 2) ? 1 : rng() % 4;
+            Entry       e;
+            e.pub = &pub[k];
+            e.msg.resize(rng() % 100);
+            for (std::uint8_t& b : e.msg)
+            {
+                b = (std::uint8_t)rng();
+            }
+            e.sig.resize(64);
+            priv[k].sign(e.sig.data(), e.msg.data(), e.msg.size(), srng,
+                         (const std::uint8_t*)id, std::strlen(id));
+            e.valid = true;
+            if (round > 0 && rng() % 4 == 0)
+            {
+                corrupt(e, &pub[(k + 1) % 4]);
+            }
+            batch.push_back(std::move(e));
+        }
+        check_batch(batch, id, round ? "mixed batch" : "all valid batch");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_mixed();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all SM2 verify_batch checks passed\n");
+    return 0;
+}
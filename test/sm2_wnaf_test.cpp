@@ -0,0 +1,251 @@
+/**
+ * SM2 interleaved wNAF checks (internal::sm2_wnaf,
+ * internal::sm2_ec_j_mul_g_add_mul_a).
+ *
+ * wNAF digits summed back to the scalar, with the digit rules of the
+ * window; [s]G + [t]P against sm2_ec_j_mul_g + sm2_ec_j_mul_a for edge and
+ * random scalars, P = G and a sum at infinity included; OpenSSL signatures
+ * verified through a key without a comb table.
+ */
+#include <gmlib/rng/std_rng.h>
+#include <gmlib/sm2/internal/sm2_wnaf.h>
+#include <gmlib/sm2/sm2.h>
+#include <gmlib/sm3/sm3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sm2::internal;
+using PrivateKey = sm2::SM2PrivateKey<sm3::SM3>;
+using PublicKey  = sm2::SM2PublicKey<sm3::SM3>;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x3AF);
+
+const char* N_MINUS_1 =
+    "fffffffeffffffffffffffffffffffff7203df6b21c6052b53bbf40939d54122";
+
+// openssl genpkey -algorithm SM2
+const char* PUB_X =
+    "a071e14993205d954662e14ab8d765926ed6de6497aab7c285f7ab04ea6c4e07";
+const char* PUB_Y =
+    "1a1985e9042a32abf1b09270ba4bcdaac4b6e533960a7a6726850bd9f956ae81";
+
+const char* MSG = "message digest";
+
+// openssl pkeyutl -sign -rawin -digest sm3 -pkeyopt distid:<id>
+const char* SIG_DEFAULT_ID =
+    "af24c16f63bc55face9d4d06f3e2d06e99fbaea19d05530b7cdacef0bf15b22b"
+    "271c358fda59a972ab2060ef4cf76bc74898a71672051e913b7cd1847fdeddf7";
+const char* SIG_ALICE =
+    "1c02243a4377edf76b73eaaf56e448d0e27860d6b1cd24b59018c98e51420695"
+    "afc07dd250a8684808a5f04bafb00620523ebbe081effb580650c986b38ead42";
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+std::vector<std::uint8_t> random_scalar()
+{
+    std::vector<std::uint8_t> k(32);
+    for (std::uint8_t& b : k)
+    {
+        b = (std::uint8_t)rng();
+    }
+    return k;
+}
+
+/// @brief 0, 1, 2, n - 1, 2^256 - 1, a single top bit, then random ones
+std::vector<std::vector<std::uint8_t>> scalars(int random_num)
+{
+    std::vector<std::vector<std::uint8_t>> ks = {
+        std::vector<std::uint8_t>(32, 0),
+        std::vector<std::uint8_t>(32, 0),
+        std::vector<std::uint8_t>(32, 0),
+        from_hex(N_MINUS_1),
+        std::vector<std::uint8_t>(32, 0xff),
+        std::vector<std::uint8_t>(32, 0),
+    };
+    ks[1][31] = 1, ks[2][31] = 2, ks[5][0] = 0x80;
+    for (int i = 0; i < random_num; i++)
+    {
+        ks.push_back(random_scalar());
+    }
+    return ks;
+}
+
+/// @brief both points equal, infinity included
+bool same_point(const sm2_ec_j P, const sm2_ec_j Q)
+{
+    if (sm2_ec_j_is_inf(P) || sm2_ec_j_is_inf(Q))
+    {
+        return sm2_ec_j_is_inf(P) && sm2_ec_j_is_inf(Q);
+    }
+    sm2_ec_a     a, b;
+    std::uint8_t x[64], y[64];
+    sm2_ec_j_to_a(a, P), sm2_ec_j_to_a(b, Q);
+    sm2_ec_a_to_bytes04(x, a), sm2_ec_a_to_bytes04(y, b);
+    return std::memcmp(x, y, 64) == 0;
+}
+
+void test_wnaf()
+{
+    for (int w = 2; w <= 8; w++)
+    {
+        for (const auto& k : scalars(30))
+        {
+            std::int8_t naf[SM2_WNAF_MAX_LEN];
+            int         len = sm2_wnaf(naf, k.data(), w);
+
+            // digit rules: odd, below 2^(w-1), w - 1 zeros after each
+            bool ok = len >= 0 && len <= SM2_WNAF_MAX_LEN &&
+                      (len == 0 || naf[len - 1] != 0);
+            int  gap = w;
+            for (int i = 0; i < len && ok; i++)
+            {
+                int d = naf[i];
+                gap++;
+                if (d != 0)
+                {
+                    ok = (d & 1) && d < (1 << (w - 1)) &&
+                         -d < (1 << (w - 1)) && gap >= w;
+                    gap = 0;
+                }
+            }
+            check(ok, "sm2_wnaf", "digit rules");
+
+            // sum of naf[i] * 2^i, two's complement in 9 32-bit limbs
+            std::uint32_t sum[9] = {0};
+            for (int i = len - 1; i >= 0; i--)
+            {
+                std::uint32_t carry = 0;
+                for (int j = 0; j < 9; j++)
+                {
+                    std::uint32_t top = sum[j] >> 31;
+                    sum[j]            = (sum[j] << 1) | carry;
+                    carry             = top;
+                }
+                std::uint64_t add = (std::uint64_t)(std::int64_t)naf[i];
+                std::uint64_t acc = 0;
+                for (int j = 0; j < 9; j++)
+                {
+                    acc += (std::uint64_t)sum[j] + (std::uint32_t)add;
+                    sum[j] = (std::uint32_t)acc;
+                    acc >>= 32;
+                    add = (std::uint64_t)((std::int64_t)add >> 32);
+                }
+            }
+            std::uint8_t back[32];
+            for (int i = 0; i < 32; i++)
+            {
+                back[31 - i] = (std::uint8_t)(sum[i / 4] >> (8 * (i % 4)));
+            }
+            check(sum[8] == 0 && std::memcmp(back, k.data(), 32) == 0,
+                  "sm2_wnaf", "digits sum to the scalar");
+        }
+    }
+}
+
+void test_mul_g_add_mul_a()
+{
+    auto ks = scalars(12);
+
+    sm2_ec_a points[3];
+    sm2_ec_j PJ;
+    sm2_fp_from_bytes(points[0][0], SM2_CURVE_GX);
+    sm2_fp_from_bytes(points[0][1], SM2_CURVE_GY);
+    for (int p = 1; p < 3; p++)
+    {
+        sm2_ec_j_mul_g(PJ, random_scalar().data());
+        sm2_ec_j_to_a(points[p], PJ);
+    }
+
+    for (const sm2_ec_a& P : points)
+    {
+        for (const auto& s : ks)
+        {
+            for (const auto& t : ks)
+            {
+                sm2_ec_j R, sG, tP;
+                sm2_ec_j_mul_g_add_mul_a(R, s.data(), t.data(), P);
+                sm2_ec_j_mul_g(sG, s.data());
+                sm2_ec_j_mul_a(tP, t.data(), P);
+                sm2_ec_j_add(sG, sG, tP);
+                check(same_point(R, sG), "sm2_ec_j_mul_g_add_mul_a",
+                      "against sm2_ec_j_mul_g + sm2_ec_j_mul_a");
+            }
+        }
+    }
+
+    // [n - 1]G + [1]G is infinity
+    sm2_ec_j R;
+    sm2_ec_j_mul_g_add_mul_a(R, ks[3].data(), ks[1].data(), points[0]);
+    check(sm2_ec_j_is_inf(R), "sm2_ec_j_mul_g_add_mul_a", "sum at infinity");
+}
+
+void test_verify()
+{
+    rng::StdRng  srng;
+    auto         x    = from_hex(PUB_X), y = from_hex(PUB_Y);
+    auto         sig1 = from_hex(SIG_DEFAULT_ID), sig2 = from_hex(SIG_ALICE);
+    const auto*  msg  = (const std::uint8_t*)MSG;
+    std::size_t  len  = std::strlen(MSG);
+    const auto*  id   = (const std::uint8_t*)"ALICE123@YAHOO.COM";
+    PublicKey    pub(x.data(), y.data());
+    PrivateKey   priv(srng);
+    std::uint8_t sig[64];
+
+    check(pub.verify(sig1.data(), msg, len), "verify", "OpenSSL signature");
+    check(pub.verify(sig2.data(), msg, len, id, 18), "verify",
+          "OpenSSL signature with ID");
+    check(!pub.verify(sig2.data(), msg, len), "verify", "wrong ID rejected");
+    sig1[40] ^= 4;
+    check(!pub.verify(sig1.data(), msg, len), "verify",
+          "bad signature rejected");
+    for (int round = 0; round < 10; round++)
+    {
+        priv.sign(sig, msg, len, srng);
+        check(priv.verify(sig, msg, len), "verify", "own signature");
+        check(!pub.verify(sig, msg, len), "verify", "other key rejected");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_wnaf();
+    test_mul_g_add_mul_a();
+    test_verify();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all SM2 wNAF checks passed\n");
+    return 0;
+}
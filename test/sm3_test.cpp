@@ -0,0 +1,155 @@
+/**
+ * sm3::SM3 checks, for whichever backend the CPU flags select (the SSSE3
+ * message expansion when CPU_FLAG_SSSE3 or CPU_FLAG_AVX2 is defined).
+ *
+ * GB/T 32905 examples and OpenSSL SM3 of the bytes 0x00, 0x01 ... for
+ * lengths around the block and padding boundaries, each hashed in one call
+ * and in random split updates.
+ */
+#include <gmlib/sm3/sm3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x5B3);
+
+struct Sm3Vector
+{
+    std::size_t len; // message is the bytes i & 0xff, i = 0 ~ len - 1
+    const char* digest;
+};
+
+// OpenSSL SM3
+const Sm3Vector SM3_VECTORS[] = {
+    {0, "1ab21d8355cfa17f8e61194831e81a8f22bec8c728fefb747ed035eb5082aa2b"},
+    {1, "2daef60e7a0b8f5e024c81cd2ab3109f2b4f155cf83adeb2ae5532f74a157fdf"},
+    {55, "a79cf9dcee3404abf7f769698201647fd9d3ff61d629d0f58bb4b5579a427db8"},
+    {56, "62f7363b15f4de76dd925c493b9d6d00d4ba0ef2a1f334c1d0f13b293aeb40d1"},
+    {63, "6165e4cbb15cde01c6226e0015a47f710f8f8e1f2c296700033bb34d9212109c"},
+    {64, "93566f236d157aae078d1ddb5cebdbba1520b5142e22a8915564345ba2ae1d63"},
+    {65, "c886e6814be748285a10b28ae62ddacd85db830cd2cf3a2bfa2f729c15f63618"},
+    {100, "4b2833c158dd41614b76e37f18889243bd6b4a744e36de60920a2f89e409c64e"},
+    {128, "a9e7985473ca09df1510d83b572f72375430756c4a661b00724afeb8b75dd0a5"},
+    {1000, "e1043d6f7910a57e49c10eb042760c060d07ea26866cb067cc5eecb42f9056a3"},
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+std::vector<std::uint8_t> digest_split(const std::vector<std::uint8_t>& msg)
+{
+    std::vector<std::uint8_t> digest(32);
+    sm3::SM3                  sm3;
+    std::size_t               pos = 0;
+    while (pos < msg.size())
+    {
+        std::size_t size = rng() % 150;
+        if (size > msg.size() - pos)
+        {
+            size = msg.size() - pos;
+        }
+        sm3.update(msg.data() + pos, size);
+        pos += size;
+    }
+    sm3.do_final(digest.data());
+    return digest;
+}
+
+void test_known_answer()
+{
+    // GB/T 32905 examples 1 and 2
+    std::string abc = "abc", abcd;
+    for (int i = 0; i < 16; i++)
+    {
+        abcd += "abcd";
+    }
+    std::uint8_t digest[32];
+    sm3::SM3().do_final(digest, (const std::uint8_t*)abc.data(), abc.size());
+    check(std::memcmp(digest,
+                      from_hex("66c7f0f462eeedd9d1f2d46bdc10e4e24167c4875cf2f7"
+                               "a2297da02b8f4ba8e0")
+                          .data(),
+                      32) == 0,
+          "SM3", "GB/T 32905 example 1");
+    sm3::SM3().do_final(digest, (const std::uint8_t*)abcd.data(), abcd.size());
+    check(std::memcmp(digest,
+                      from_hex("debe9ff92275b8a138604889c18e5a4d6fdb70e5387e57"
+                               "65293dcba39c0c5732")
+                          .data(),
+                      32) == 0,
+          "SM3", "GB/T 32905 example 2");
+
+    for (const Sm3Vector& v : SM3_VECTORS)
+    {
+        std::vector<std::uint8_t> msg(v.len);
+        for (std::size_t i = 0; i < v.len; i++)
+        {
+            msg[i] = (std::uint8_t)i;
+        }
+        auto expect = from_hex(v.digest);
+        sm3::SM3().do_final(digest, msg.data(), msg.size());
+        check(std::memcmp(digest, expect.data(), 32) == 0, "SM3",
+              "known answer");
+        for (int round = 0; round < 5; round++)
+        {
+            check(digest_split(msg) == expect, "SM3", "split updates");
+        }
+    }
+}
+
+void test_reset()
+{
+    std::vector<std::uint8_t> msg(300);
+    for (std::uint8_t& b : msg)
+    {
+        b = (std::uint8_t)rng();
+    }
+    std::uint8_t d1[32], d2[32];
+    sm3::SM3     sm3;
+    sm3.do_final(d1, msg.data(), msg.size());
+    sm3.update(msg.data(), 77);
+    sm3.reset();
+    sm3.do_final(d2, msg.data(), msg.size());
+    check(std::memcmp(d1, d2, 32) == 0, "SM3", "reset");
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_reset();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all SM3 checks passed\n");
+    return 0;
+}
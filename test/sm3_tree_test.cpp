@@ -0,0 +1,250 @@
+/**
+ * SM3Tree / sm3_tree_file checks.
+ *
+ * Known answers (hashlib SM3 over the tree definition), then random inputs
+ * against a single-threaded reference tree built with sm3::SM3, on the
+ * multi-thread path: several threads, leaves small enough that one input
+ * spans many batches of thread_num x LANE_NUM leaves, random update splits
+ * and one tree reused across inputs.
+ */
+#include <gmlib/sm3/sm3.h>
+#include <gmlib/sm3/sm3_tree.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0x57EE);
+
+struct TreeVector
+{
+    std::size_t len; // message is the bytes i & 0xff, i = 0 ~ len - 1
+    std::size_t leaf_size;
+    const char* root;
+};
+
+// hashlib SM3, leaf = SM3(Z || data), node = SM3(0x01 || left || right)
+const TreeVector TREE_VECTORS[] = {
+    {0, 64, "46b58571be41685c253194d20ec7f82b659cc8c6b753f26d4e9ec85bc91c231e"},
+    {100, 128,
+     "2e283cf089c1b3b6e2e2010202df4fe12480f5997a6666a8b9956f0aaa294f16"},
+    {100, 64,
+     "2593b0a4d82ffd7377e2ea80f5a442c5882c2c500252eae2869cd210dee9d9a0"},
+    {150, 64,
+     "4dbbc83deb49bec725675516a0c46bd0291be2e2a07ed3d29477a6d30c4b7b84"},
+};
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+std::vector<std::uint8_t> from_hex(const char* hex)
+{
+    std::vector<std::uint8_t> out;
+    for (std::size_t i = 0; hex[i] && hex[i + 1]; i += 2)
+    {
+        out.push_back((std::uint8_t)std::stoul(std::string(hex + i, 2),
+                                               nullptr, 16));
+    }
+    return out;
+}
+
+std::vector<std::uint8_t> random_bytes(std::size_t len)
+{
+    std::vector<std::uint8_t> out(len);
+    for (std::uint8_t& b : out)
+    {
+        b = (std::uint8_t)rng();
+    }
+    return out;
+}
+
+/// @brief leaf digests, one sm3::SM3 per leaf
+std::vector<std::uint8_t> ref_leaves(const std::vector<std::uint8_t>& msg,
+                                     std::size_t leaf_size)
+{
+    const std::uint8_t        ZERO_BLOCK[64] = {0};
+    std::vector<std::uint8_t> out;
+    std::size_t               pos = 0;
+    do
+    {
+        std::size_t size = msg.size() - pos;
+        size             = (size > leaf_size) ? leaf_size : size;
+        std::uint8_t d[32];
+        sm3::SM3     sm3;
+        sm3.update(ZERO_BLOCK, 64);
+        sm3.do_final(d, msg.data() + pos, size);
+        out.insert(out.end(), d, d + 32);
+        pos += size;
+    } while (pos < msg.size());
+    return out;
+}
+
+/// @brief root from the definition, level by level
+std::vector<std::uint8_t> ref_root(std::vector<std::uint8_t> level)
+{
+    while (level.size() > 32)
+    {
+        std::vector<std::uint8_t> next;
+        for (std::size_t i = 0; i < level.size(); i += 64)
+        {
+            if (i + 32 == level.size())
+            {
+                next.insert(next.end(), level.begin() + i, level.end());
+                break;
+            }
+            std::uint8_t one = 0x01, d[32];
+            sm3::SM3     sm3;
+            sm3.update(&one, 1);
+            sm3.do_final(d, level.data() + i, 64);
+            next.insert(next.end(), d, d + 32);
+        }
+        level = next;
+    }
+    return level;
+}
+
+void test_known_answer()
+{
+    for (const TreeVector& v : TREE_VECTORS)
+    {
+        std::vector<std::uint8_t> msg(v.len);
+        for (std::size_t i = 0; i < v.len; i++)
+        {
+            msg[i] = (std::uint8_t)i;
+        }
+        auto expect = from_hex(v.root);
+        check(ref_root(ref_leaves(msg, v.leaf_size)) == expect, "reference",
+              "known answer");
+
+        std::uint8_t digest[32];
+        sm3::SM3Tree::digest(digest, msg.data(), msg.size(), v.leaf_size, 4);
+        check(std::memcmp(digest, expect.data(), 32) == 0, "SM3Tree::digest",
+              "known answer");
+        sm3::SM3Tree tree(v.leaf_size, 1);
+        tree.do_final(digest, msg.data(), msg.size());
+        check(std::memcmp(digest, expect.data(), 32) == 0, "SM3Tree",
+              "known answer");
+    }
+}
+
+/// @brief many leaves over several threads, one tree reused across inputs
+void test_threads()
+{
+    constexpr std::size_t LANE_NUM = sm3::SM3MultiBuffer::LANE_NUM;
+    for (std::size_t thread_num : {1, 2, 3, 4})
+    {
+        std::size_t  leaf_size = 64 * (1 + rng() % 3);
+        sm3::SM3Tree tree(leaf_size, thread_num);
+        for (int round = 0; round < 12; round++)
+        {
+            // up to about 5 batches, lengths around leaf boundaries
+            std::size_t leaf_num = rng() % (5 * thread_num * LANE_NUM + 2);
+            std::size_t len      = leaf_num * leaf_size;
+            len = (round % 3 == 0 || len == 0) ? len : len - rng() % leaf_size;
+            auto msg    = random_bytes(len);
+            auto leaves = ref_leaves(msg, leaf_size);
+            auto expect = ref_root(leaves);
+
+            std::uint8_t digest[32];
+            tree.reset();
+            std::size_t pos = 0;
+            while (pos < len)
+            {
+                std::size_t size = (rng() % 4 == 0) ? rng() % (3 * len + 1)
+                                                    : rng() % (leaf_size * 3);
+                size = (size > len - pos) ? len - pos : size;
+                tree.update(msg.data() + pos, size);
+                pos += size;
+            }
+            tree.do_final(digest);
+            check(std::memcmp(digest, expect.data(), 32) == 0, "SM3Tree",
+                  "root against reference");
+            check(tree.leaf_num() * 32 == leaves.size() &&
+                      std::memcmp(tree.leaf_digest(), leaves.data(),
+                                  leaves.size()) == 0,
+                  "SM3Tree", "leaf digests against reference");
+
+            sm3::SM3Tree::digest(digest, msg.data(), len, leaf_size,
+                                 thread_num);
+            check(std::memcmp(digest, expect.data(), 32) == 0,
+                  "SM3Tree::digest", "root against reference");
+        }
+    }
+}
+
+void test_file()
+{
+    auto msg = random_bytes(64 * 100 + 17);
+    const char* path = "sm3_tree_test.tmp";
+    FILE*       fp   = std::fopen(path, "wb");
+    if (fp == nullptr)
+    {
+        check(false, "sm3_tree_file", "temporary file");
+        return;
+    }
+    std::fwrite(msg.data(), 1, msg.size(), fp);
+    std::fclose(fp);
+
+    std::uint8_t digest[32];
+    sm3::sm3_tree_file(digest, path, 128, 3);
+    auto expect = ref_root(ref_leaves(msg, 128));
+    check(std::memcmp(digest, expect.data(), 32) == 0, "sm3_tree_file",
+          "root against reference");
+
+    // an empty file is one empty leaf
+    fp = std::fopen(path, "wb");
+    std::fclose(fp);
+    sm3::sm3_tree_file(digest, path, 64, 2);
+    check(std::memcmp(digest, from_hex(TREE_VECTORS[0].root).data(), 32) == 0,
+          "sm3_tree_file", "empty file");
+    std::remove(path);
+}
+
+void test_leaf_size()
+{
+    for (std::size_t leaf_size : {0, 1, 63, 65, 100})
+    {
+        bool thrown = false;
+        try
+        {
+            sm3::SM3Tree tree(leaf_size);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        check(thrown, "SM3Tree", "invalid leaf size rejected");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_known_answer();
+    test_threads();
+    test_file();
+    test_leaf_size();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all SM3 tree checks passed\n");
+    return 0;
+}
@@ -0,0 +1,243 @@
+/**
+ * BlockCipherModeImpl / HashImpl dispatch checks.
+ *
+ * Library modes and SM3 (static dispatch) give the same output called
+ * directly and through the abc interfaces, for random update splits. An
+ * out-of-tree mode with the default Derived = void still reaches its
+ * overrides through the vtable. update must report no output when the
+ * input only tops up the buffer.
+ */
+#include <gmlib/sm3/sm3.h>
+#include <gmlib/sm4/sm4_mode.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace block_cipher_mode;
+
+namespace {
+
+int fail_num = 0;
+
+std::mt19937 rng(0xD15);
+
+void check(bool ok, const char* name, const char* what)
+{
+    if (!ok)
+    {
+        std::printf("[FAIL] %s %s\n", name, what);
+        fail_num++;
+    }
+}
+
+/// @brief out-of-tree mode, xors every byte with its block index
+class IndexXorMode : public BlockCipherModeImpl<16>
+{
+public:
+    std::size_t block_index = 0;
+
+private:
+    void update_blocks(std::uint8_t*       out,
+                       const std::uint8_t* in,
+                       std::size_t         block_num) override
+    {
+        for (std::size_t i = 0; i < block_num * 16; i++)
+        {
+            out[i] = in[i] ^ (std::uint8_t)(block_index + i / 16);
+        }
+        block_index += block_num;
+    }
+
+    void final_block(std::uint8_t*       out,
+                     const std::uint8_t* in,
+                     std::size_t         inl) override
+    {
+        for (std::size_t i = 0; i < inl; i++)
+        {
+            out[i] = in[i] ^ (std::uint8_t)block_index;
+        }
+    }
+};
+
+std::vector<std::size_t> random_split()
+{
+    std::vector<std::size_t> split(rng() % 10);
+    for (std::size_t& size : split)
+    {
+        size = rng() % 50;
+    }
+    return split;
+}
+
+std::vector<std::uint8_t> crypt(abc::BlockCipherMode&            mode,
+                                const std::vector<std::uint8_t>& in,
+                                const std::vector<std::size_t>&  splits)
+{
+    std::vector<std::uint8_t> out(in.size() + 16);
+    std::size_t               pos = 0, total = 0, outl;
+    for (std::size_t i = 0; i <= splits.size(); i++)
+    {
+        std::size_t size = in.size() - pos;
+        if (i < splits.size() && splits[i] < size)
+        {
+            size = splits[i];
+        }
+        mode.update(out.data() + total, &outl, in.data() + pos, size);
+        pos += size, total += outl;
+    }
+    mode.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+/// @brief the same as above, called on the concrete (final) class
+template <class Mode>
+std::vector<std::uint8_t> crypt_direct(Mode&                            mode,
+                                       const std::vector<std::uint8_t>& in,
+                                       const std::vector<std::size_t>&  splits)
+{
+    std::vector<std::uint8_t> out(in.size() + 16);
+    std::size_t               pos = 0, total = 0, outl;
+    for (std::size_t i = 0; i <= splits.size(); i++)
+    {
+        std::size_t size = in.size() - pos;
+        if (i < splits.size() && splits[i] < size)
+        {
+            size = splits[i];
+        }
+        mode.update(out.data() + total, &outl, in.data() + pos, size);
+        pos += size, total += outl;
+    }
+    mode.do_final(out.data() + total, &outl);
+    out.resize(total + outl);
+    return out;
+}
+
+template <class Mode, class... Args>
+void test_mode(const char* name, bool block_only, Args... args)
+{
+    for (int round = 0; round < 50; round++)
+    {
+        std::vector<std::uint8_t> pt(rng() % 200);
+        if (block_only)
+        {
+            pt.resize(pt.size() / 16 * 16);
+        }
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        auto split = random_split();
+        Mode direct(args...), erased(args...);
+        check(crypt_direct(direct, pt, split) == crypt(erased, pt, split),
+              name, "direct and abc calls differ");
+    }
+}
+
+void test_out_of_tree()
+{
+    for (int round = 0; round < 50; round++)
+    {
+        std::vector<std::uint8_t> pt(rng() % 200), expect;
+        for (std::uint8_t& b : pt)
+        {
+            b = (std::uint8_t)rng();
+        }
+        for (std::size_t i = 0; i < pt.size(); i++)
+        {
+            expect.push_back(pt[i] ^ (std::uint8_t)(i / 16));
+        }
+        IndexXorMode mode;
+        check(crypt(mode, pt, random_split()) == expect, "Derived = void",
+              "output");
+    }
+}
+
+void test_top_up()
+{
+    std::uint8_t key[16] = {0}, buf[64] = {0};
+    std::size_t  outl;
+
+    sm4::SM4EcbEncryptor ecb(key);
+    ecb.update(buf, &outl, buf, 5);
+    check(outl == 0, "SM4 ECB", "first partial update");
+    outl = 12345;
+    ecb.update(buf, &outl, buf, 5);
+    check(outl == 0, "SM4 ECB", "top-up only update");
+    ecb.update(buf, &outl, buf, 40);
+    check(outl == 48, "SM4 ECB", "update filling the buffer");
+}
+
+void test_sm3()
+{
+    // GB/T 32905 example 1
+    const std::uint8_t ABC_DIGEST[32] = {
+        0x66, 0xc7, 0xf0, 0xf4, 0x62, 0xee, 0xed, 0xd9, 0xd1, 0xf2, 0xd4,
+        0x6b, 0xdc, 0x10, 0xe4, 0xe2, 0x41, 0x67, 0xc4, 0x87, 0x5c, 0xf2,
+        0xf7, 0xa2, 0x29, 0x7d, 0xa0, 0x2b, 0x8f, 0x4b, 0xa8, 0xe0,
+    };
+    std::uint8_t digest[32];
+    sm3::SM3     sm3;
+    sm3.do_final(digest, (const std::uint8_t*)"abc", 3);
+    check(std::memcmp(digest, ABC_DIGEST, 32) == 0, "SM3", "known answer");
+
+    for (int round = 0; round < 100; round++)
+    {
+        std::vector<std::uint8_t> msg(rng() % 500);
+        for (std::uint8_t& b : msg)
+        {
+            b = (std::uint8_t)rng();
+        }
+        std::uint8_t expect[32];
+        sm3::SM3     one;
+        one.do_final(expect, msg.data(), msg.size());
+
+        sm3::SM3             split;
+        hash_lib::abc::Hash& erased = split;
+        std::size_t          pos    = 0;
+        while (pos < msg.size())
+        {
+            std::size_t size = rng() % 100;
+            if (size > msg.size() - pos)
+            {
+                size = msg.size() - pos;
+            }
+            erased.update(msg.data() + pos, size);
+            pos += size;
+        }
+        erased.do_final(digest);
+        check(std::memcmp(digest, expect, 32) == 0, "SM3", "split updates");
+    }
+}
+
+} // namespace
+
+int main()
+{
+    std::uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; i++)
+    {
+        key[i] = (std::uint8_t)rng(), iv[i] = (std::uint8_t)rng();
+    }
+    test_mode<sm4::SM4EcbEncryptor>("SM4 ECB", true, key);
+    test_mode<sm4::SM4CbcEncryptor>("SM4 CBC", true, key, iv);
+    test_mode<sm4::SM4CfbEncryptor>("SM4 CFB", false, key, iv);
+    test_mode<sm4::SM4OfbEncryptor>("SM4 OFB", false, key, iv);
+    test_mode<sm4::SM4CtrEncryptor>("SM4 CTR", false, key, iv);
+    test_mode<sm4::SM4GcmEncryptor>("SM4 GCM", false, key, iv,
+                                    (std::size_t)12, iv, (std::size_t)16);
+    test_out_of_tree();
+    test_top_up();
+    test_sm3();
+
+    if (fail_num)
+    {
+        std::printf("%d check(s) failed\n", fail_num);
+        return 1;
+    }
+    std::printf("all dispatch checks passed\n");
+    return 0;
+}